@@ -0,0 +1,57 @@
+#ifndef BOOT_H
+# define BOOT_H
+
+/*
+** Serial bootloader, top 1KB of the flash (0x7C00, BOOTSZ = 512 words, BOOTRST, page 282 27-13)
+**
+** Start (reset vector of the boot section, no vector table, no C runtime):
+**  - power-on, brown-out, watchdog reset with an application: jumps to it at once
+**  - external reset (button, DTR of the USB adapter), SW1 held, or no application (erased):
+**    waits for a host, BOOT_WAIT_MS of silence then the application (never without one)
+**  - MCUSR is cleared (its flags pile up), the application gets its value in r2
+**  - the watchdog is stopped: a reset by a watchdog left running (reset mode) would hit
+**    the boot again in the middle of an upload; the application sets it up again
+**
+** Host -> boot, every reply comes from the boot (tools/boot_flash.py):
+**  'S'                             -> 'B' BOOT_VERSION SPM_PAGESIZE BOOT_APP_PAGES
+**  'Q' ~'Q' first count            -> 'K' {page CRC} x count (little endian) / 'E' out of range
+**  'W' ~'W' page {byte} x 128 CRC  -> status page, status: 'K' written, read back same CRC /
+**                                     'C' bad CRC, nothing written, then every byte is dropped
+**                                     until BOOT_QUIET_MS of silence / 'E' page of the boot /
+**                                     'F' read back differs
+**  'G' ~'G'                        -> 'K', the application starts
+**  other bytes are dropped (a host syncs by sending 'S' until it gets 'B')
+**  ~: the complement, so the data of a frame whose first byte was lost is not read as
+**  commands (a 'G' in it would start the application)
+**
+** Page CRC: CRC-16 CCITT (0xFFFF, _crc_ccitt_update()) of the page number then its 128 bytes,
+** the same for a 'W' frame and for the flash ('Q', read back): the host only sends the pages
+** whose CRC differs
+**
+** Flow: the bytes go to a 256 byte ring, also filled while the flash is busy (page erase +
+** write ~9ms, page 276 27.8.12): the host may send the next 'W' frame before the reply
+*/
+
+#define BOOT_VERSION    1
+
+#define BOOT_START      0x7C00
+#define BOOT_APP_PAGES  (BOOT_START / SPM_PAGESIZE)     /* 248 pages of 128 bytes */
+
+#ifndef BOOT_BAUD
+# define BOOT_BAUD      1000000     /* U2X0, UBRR0 1: 0% error at 16MHz */
+#endif
+#define BOOT_WAIT_MS    500
+#define BOOT_QUIET_MS   1           /* After a bad frame */
+
+#define BOOT_SYNC       'S'
+#define BOOT_QUERY      'Q'
+#define BOOT_WRITE      'W'
+#define BOOT_GO         'G'
+
+#define BOOT_HELLO      'B'
+#define BOOT_OK         'K'
+#define BOOT_BAD_CRC    'C'
+#define BOOT_RANGE      'E'
+#define BOOT_VERIFY     'F'
+
+#endif
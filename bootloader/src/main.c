@@ -0,0 +1,230 @@
+#include <avr/io.h>
+#include <avr/boot.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+#include <util/crc16.h>
+#include <util/delay.h>
+#include "uart.h"       /* UART_UBRR() only, the driver is not linked */
+#include "board.h"      /* SW1: held at reset -> stay in the bootloader */
+#include "boot.h"
+
+/* Timer1 at clk/1024 (page 143 16-5): 15.6 counts per ms, cleared by every received byte */
+#define BOOT_WAIT_TICKS ((F_CPU / 1024) * BOOT_WAIT_MS / 1000)
+#define BOOT_QUIET_TICKS ((F_CPU / 1024) * BOOT_QUIET_MS / 1000)
+
+/*
+** No C runtime (-nostartfiles): nothing clears .bss or copies .data,
+** every variable is in .noinit and set by main()
+*/
+#define BOOT_NOINIT __attribute__((section(".noinit")))
+
+static uint8_t g_ring[256] BOOT_NOINIT;         /* Received bytes, the indexes wrap by themselves */
+static uint8_t g_head BOOT_NOINIT;
+static uint8_t g_tail BOOT_NOINIT;
+static uint8_t g_page[SPM_PAGESIZE] BOOT_NOINIT;
+static uint8_t g_stay BOOT_NOINIT;              /* No application: no time out */
+static uint8_t g_reset BOOT_NOINIT;             /* MCUSR at reset, given in r2 */
+
+int main(void) __attribute__((OS_main));
+
+/* First word of the boot section (reset vector with BOOTRST), r1 is the zero of gcc */
+__attribute__((naked, used, section(".vectors"))) static void boot_reset(void)
+{
+    __asm__ __volatile__ ("clr __zero_reg__\n\t" "rjmp main");
+}
+
+/*
+** Registers back to their reset value (page 13 ~), the application starts as after a reset
+** r2: MCUSR of this reset (the register itself is cleared)
+*/
+static void __attribute__((noreturn)) boot_app(void)
+{
+    UCSR0B = 0;
+    UCSR0A = (1 << TXC0);
+    UBRR0 = 0;
+    TCCR1B = 0;
+    TCNT1 = 0;
+    TIFR1 = (1 << ICF1) | (1 << OCF1B) | (1 << OCF1A) | (1 << TOV1);
+    PIN_CLR(SW1);
+    __asm__ __volatile__ ("mov r2, %0\n\t" "jmp 0" :: "r"(g_reset));
+    __builtin_unreachable();
+}
+
+/* One received byte to the ring: called from every wait loop (1 byte every 10us at 1Mbaud) */
+static void boot_poll(void)
+{
+    if (UCSR0A & (1 << RXC0))
+    {
+        g_ring[g_head++] = UDR0;
+        TCNT1 = 0;
+    }
+}
+
+static uint8_t boot_getc(void)
+{
+    while (g_head == g_tail)
+    {
+        boot_poll();
+        if (!g_stay && TCNT1 >= BOOT_WAIT_TICKS)
+            boot_app();
+    }
+    return g_ring[g_tail++];
+}
+
+static void boot_putc(uint8_t c)
+{
+    while (!(UCSR0A & (1 << UDRE0)))
+        boot_poll();
+    UCSR0A = (1 << TXC0) | (1 << U2X0);     /* TXC0 cleared, set again once c is out */
+    UDR0 = c;
+}
+
+/*
+** After a bad frame the next bytes are out of step (one lost, the frames behind it may be
+** read as commands): everything is dropped until the host is silent, it syncs again
+*/
+static void boot_drain(void)
+{
+    TCNT1 = 0;
+    while (TCNT1 < BOOT_QUIET_TICKS)
+    {
+        boot_poll();
+        g_tail = g_head;
+    }
+}
+
+static void boot_wait(void)
+{
+    while (boot_spm_busy())
+        boot_poll();
+}
+
+/* CRC of a page as the host computes it: page number, then the 128 bytes */
+static uint16_t boot_crc_flash(uint8_t page)
+{
+    const uint8_t *flash = (const uint8_t *)(uintptr_t)(page * SPM_PAGESIZE);
+    uint16_t crc = _crc_ccitt_update(0xFFFF, page);
+
+    for (uint8_t i = 0; i < SPM_PAGESIZE; i++)
+    {
+        crc = _crc_ccitt_update(crc, pgm_read_byte(flash + i));
+        boot_poll();
+    }
+    return crc;
+}
+
+/*
+** 'W' frame: the page is kept in RAM until its CRC is checked, then erased and written
+** (page 278 27.8.13: erase, fill the buffer, write, RWW section on again) and read back
+*/
+static uint8_t boot_write(uint8_t page)
+{
+    uint16_t crc = _crc_ccitt_update(0xFFFF, page);
+    uint16_t sent;
+
+    for (uint8_t i = 0; i < SPM_PAGESIZE; i++)
+    {
+        g_page[i] = boot_getc();
+        crc = _crc_ccitt_update(crc, g_page[i]);
+    }
+    sent = boot_getc();
+    sent |= boot_getc() << 8;
+    if (sent != crc)
+        return BOOT_BAD_CRC;
+    if (page >= BOOT_APP_PAGES)
+        return BOOT_RANGE;
+
+    uint16_t addr = page * SPM_PAGESIZE;
+
+    eeprom_busy_wait();                     /* No SPM during an EEPROM write (page 276) */
+    boot_page_erase(addr);
+    boot_wait();
+    for (uint8_t i = 0; i < SPM_PAGESIZE; i += 2)
+    {
+        boot_page_fill(addr + i, g_page[i] | (g_page[i + 1] << 8));
+        boot_poll();
+    }
+    boot_page_write(addr);
+    boot_wait();
+    boot_rww_enable();
+    boot_wait();
+    return boot_crc_flash(page) == crc ? BOOT_OK : BOOT_VERIFY;
+}
+
+static void boot_command(uint8_t cmd)
+{
+    if (cmd == BOOT_SYNC)
+    {
+        boot_putc(BOOT_HELLO);
+        boot_putc(BOOT_VERSION);
+        boot_putc(SPM_PAGESIZE);
+        boot_putc(BOOT_APP_PAGES);
+        return;
+    }
+    if ((cmd != BOOT_QUERY && cmd != BOOT_WRITE && cmd != BOOT_GO) || boot_getc() != (uint8_t)~cmd)
+        return;
+
+    if (cmd == BOOT_QUERY)
+    {
+        uint8_t page = boot_getc();
+        uint8_t count = boot_getc();
+
+        if (page + count > BOOT_APP_PAGES)
+        {
+            boot_putc(BOOT_RANGE);
+            return;
+        }
+        boot_putc(BOOT_OK);
+        while (count--)
+        {
+            uint16_t crc = boot_crc_flash(page++);
+
+            boot_putc(crc & 0xFF);
+            boot_putc(crc >> 8);
+        }
+    }
+    else if (cmd == BOOT_WRITE)
+    {
+        uint8_t page = boot_getc();
+        uint8_t reply = boot_write(page);
+
+        boot_putc(reply);
+        boot_putc(page);
+        if (reply == BOOT_BAD_CRC)
+            boot_drain();
+    }
+    else if (cmd == BOOT_GO)
+    {
+        boot_putc(BOOT_OK);
+        while (!(UCSR0A & (1 << TXC0)))
+            ;
+        boot_app();
+    }
+}
+
+/*
+** Straight to the application unless a host may be there: external reset, SW1 held
+** (pull-up on, a few us to charge the pin), or nothing to start
+*/
+int main(void)
+{
+    g_reset = MCUSR;
+    MCUSR = 0;
+    wdt_disable();                          /* After WDRF is cleared: WDE is forced on while it is set */
+    PIN_SET(SW1);
+    g_stay = pgm_read_word(0) == 0xFFFF;
+    _delay_us(5);
+    if (!(g_reset & (1 << EXTRF)) && !g_stay && PIN_READ(SW1))
+        boot_app();
+
+    g_head = 0;
+    g_tail = 0;
+    TCCR1B = (1 << CS12) | (1 << CS10);
+    UCSR0A = (1 << U2X0);
+    UBRR0 = UART_UBRR(BOOT_BAUD);
+    UCSR0B = (1 << RXEN0) | (1 << TXEN0);   /* 8N1: reset value of UCSR0C */
+
+    while (1)
+        boot_command(boot_getc());
+}
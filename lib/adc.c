@@ -0,0 +1,55 @@
+#include "adc.h"
+#include "periph.h"
+#include <util/delay.h>
+
+#define ADC_PS_MASK ((1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0))
+
+static uint8_t g_adc_prescaler = ADC_PS_MASK;  /* ADPS bits, 128 at 16MHz */
+
+void init_adc(void)
+{
+    periph_claim(PERIPH_ADC);   /* ADC clock on, before any ADC register is written */
+
+    ADMUX = ADC_AVCC;
+    ADCSRA = (1 << ADEN) | g_adc_prescaler;     /* Enable, prescaler 128 at 16MHz (page 259 24-5) */
+}
+
+uint16_t adc_read(uint8_t admux)
+{
+    uint8_t reference = ADMUX ^ admux;
+
+    ADMUX = admux;                      /* Channel: taken at the start of the conversion (page 248) */
+    if (reference & ((1 << REFS1) | (1 << REFS0)))
+        _delay_us(200);                 /* New reference: let AREF settle (page 252) */
+
+    ADCSRA |= (1 << ADSC);              /* Start single conversion */
+    while (ADCSRA & (1 << ADSC))        /* Wait for conversion to complete */
+    {
+        ;
+    }
+
+    return ADC;                         /* ADCL then ADCH, read as one 16 bit value */
+}
+
+uint8_t adc_read8(uint8_t admux)
+{
+    return adc_read(admux) >> 2;
+}
+
+/* ADEN off, clock off (until the next init_adc) */
+void adc_stop(void)
+{
+    ADCSRA = 0;
+    periph_release(PERIPH_ADC);
+}
+
+/*
+** clock_set() listener: ADPS n divides by 2^n, 128 >> div -> ADPS = 7 - div
+** Kept for the next init_adc() when the ADC is off
+*/
+void adc_clock(uint8_t div)
+{
+    g_adc_prescaler = (div < 6) ? ADC_PS_MASK - div : 1;
+    if (ADCSRA & (1 << ADEN))
+        ADCSRA = (ADCSRA & ~ADC_PS_MASK) | g_adc_prescaler;
+}
@@ -0,0 +1,31 @@
+#ifndef ADC_H
+# define ADC_H
+
+#include <avr/io.h>
+
+/*
+** ADC single conversion driver (page 246 ~)
+**  - prescaler 128: 16MHz / 128 = 125kHz (50 ~ 200kHz for 10 bit, page 250 24-5)
+**  - one conversion = 13 ADC clocks = 104us
+**  - the whole ADMUX is given to each read: reference + channel
+**    a change of reference waits 200us before the conversion (AREF settling)
+**  - 10 bit result (ADC), adc_read8() keeps the 8 most significant bits
+**
+** init_adc() claims the ADC clock (periph.h), adc_stop() gives it back
+** adc_clock(): clock_listen() listener, the prescaler follows the CPU clock (128 >> div, 2 at least)
+** so the ADC clock stays at 125kHz
+*/
+
+#define ADC_AVCC        (1 << REFS0)                    /* AVcc, capacitor at AREF (page 257 24-3) */
+#define ADC_1V1         ((1 << REFS1) | (1 << REFS0))   /* Internal 1.1V */
+
+#define ADC_CHANNEL(n)  (ADC_AVCC | ((n) & 0x07))       /* ADC0 ~ ADC7 on AVcc */
+#define ADC_TEMPERATURE (ADC_1V1 | (1 << MUX3))         /* Internal sensor, 1.1V only (page 256 24.8) */
+
+void        init_adc(void);
+uint16_t    adc_read(uint8_t admux);
+uint8_t     adc_read8(uint8_t admux);
+void        adc_stop(void);
+void        adc_clock(uint8_t div);
+
+#endif
@@ -0,0 +1,134 @@
+#include "bam.h"
+#include "periph.h"
+
+/*
+** Slot masks are double buffered
+**  - ISR reads g_bam_slot[g_bam_front]
+**  - bam_commit() writes the other buffer and asks the ISR to swap at the next frame start
+**  - so a frame is never shown half old / half new (no glitch)
+*/
+static volatile uint8_t *g_bam_port;
+static uint8_t g_bam_mask = 0;                  /* Pins owned by the engine */
+static uint8_t g_bam_level[8];                  /* Brightness of each pin (index = bit of the port) */
+static uint8_t g_bam_slot[2][BAM_BITS];         /* Port value of each slot */
+static volatile uint8_t g_bam_front = 0;        /* Buffer used by the ISR */
+static volatile uint8_t g_bam_pending = 0;      /* 1 -> swap buffers at the next frame */
+static volatile uint8_t g_bam_bit = 0;          /* Current slot */
+static volatile uint8_t g_bam_ocr = 0;          /* 2^bit - 1 (avoid variable shift in the ISR) */
+
+/*
+** Only the pins of the mask are used
+** If OC1A (PB1) or OC1B (PB2) is driven by Timer1, the pin is removed from the mask
+** (the hardware PWM of module01 keeps the pin, page 140 16-1)
+*/
+void bam_init(volatile uint8_t *port, uint8_t mask)
+{
+    if (port == &PORTB)
+    {
+        if (TCCR1A & ((1 << COM1A1) | (1 << COM1A0)))
+            mask &= ~(1 << PB1);
+        if (TCCR1A & ((1 << COM1B1) | (1 << COM1B0)))
+            mask &= ~(1 << PB2);
+    }
+
+    g_bam_port = port;
+    g_bam_mask = mask;
+    g_bam_bit = 0;
+    g_bam_ocr = 0;
+    g_bam_front = 0;
+    g_bam_pending = 0;
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        g_bam_level[i] = 0;
+    }
+    for (uint8_t i = 0; i < BAM_BITS; i++)
+    {
+        g_bam_slot[0][i] = 0;
+        g_bam_slot[1][i] = 0;
+    }
+
+    periph_claim(PERIPH_TIM2);
+
+    /* Timer2 CTC mode, page 164 18-8 (mode 2) */
+    TCCR2A = (1 << WGM21);
+    TCNT2 = 0;
+    OCR2A = 0;
+    TIMSK2 |= (1 << OCIE2A);                    /* Compare A interrupt, page 166 */
+    TCCR2B = (1 << CS22) | (1 << CS21);         /* 256 prescaler, page 165 18-9 */
+}
+
+void bam_stop(void)
+{
+    TCCR2B = 0;                                 /* Stop the clock */
+    TIMSK2 &= ~(1 << OCIE2A);
+    *g_bam_port &= ~g_bam_mask;                 /* All engine pins OFF */
+    periph_release(PERIPH_TIM2);
+}
+
+/*
+** Only store the level, nothing is shown until bam_commit()
+** (several pins can be changed and shown at the same frame)
+*/
+void bam_set(uint8_t pin, uint8_t level)
+{
+    g_bam_level[pin & 0x07] = level;
+}
+
+/*
+** Build the 8 slot masks from the levels
+**  - slot n = every pin with bit n set in its level
+**  - pending is cleared first, so the ISR cannot swap while we write the back buffer
+*/
+void bam_commit(void)
+{
+    g_bam_pending = 0;
+
+    uint8_t *slot = g_bam_slot[g_bam_front ^ 1];
+
+    for (uint8_t bit = 0; bit < BAM_BITS; bit++)
+    {
+        uint8_t value = 0;
+
+        for (uint8_t pin = 0; pin < 8; pin++)
+        {
+            if ((g_bam_mask & (1 << pin)) && (g_bam_level[pin] & (1 << bit)))
+                value |= (1 << pin);
+        }
+        slot[bit] = value;
+    }
+
+    g_bam_pending = 1;
+}
+
+/*
+** Start of a slot (the counter has just been cleared by the compare match)
+**  - show the slot mask with one store
+**  - program the length of the slot: 2^bit units
+*/
+ISR(TIMER2_COMPA_vect)
+{
+    uint8_t bit = g_bam_bit;
+    uint8_t ocr = g_bam_ocr;
+
+    if (bit == 0 && g_bam_pending)              /* New frame: take the new buffer */
+    {
+        g_bam_front ^= 1;
+        g_bam_pending = 0;
+    }
+
+    *g_bam_port = (*g_bam_port & ~g_bam_mask) | g_bam_slot[g_bam_front][bit];
+    OCR2A = ocr;
+
+    if (++bit == BAM_BITS)
+    {
+        bit = 0;
+        ocr = 0;
+    }
+    else
+    {
+        ocr = (ocr << 1) | 1;
+    }
+    g_bam_bit = bit;
+    g_bam_ocr = ocr;
+}
@@ -0,0 +1,46 @@
+#ifndef BAM_H
+# define BAM_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*
+** Bit Angle Modulation (BAM) engine
+**  - 8 bit brightness per pin, for any set of pins on one port
+**  - One frame = 8 slots, slot n lasts 2^n time units (1 + 2 + ... + 128 = 255 units)
+**  - During slot n, a pin is ON when bit n of its brightness is set
+**  - So only 8 interrupts per frame (O(bits)) instead of 256 (O(levels)) for classic software PWM
+**
+** Timer2 in CTC mode (Timer1 is left alone, OC1A/PB1 hardware PWM keeps working)
+**  - prescaler 256 -> 1 unit = 256 / 16MHz = 16us
+**  - frame = 255 * 16us = 4.08ms -> 245Hz refresh (no flicker, > 200Hz)
+**  - slot n: OCR2A = 2^n - 1 (page 162 18.7.2 CTC mode)
+**
+** ISR cost: c = "BENCH TIMER2_COMPA_vect_slot" of test/sim (bench_bam.c, make bench), cycles
+** per slot with prologue / epilogue, 8 slots per frame (the frame slot adds the buffer swap)
+**  - 200Hz: c * 8 * 200 = c * 1600 cycles/s -> c / 100 % of 16MHz
+**  - 245Hz (this setting): c * 8 * 245 = c * 1960 cycles/s -> c / 82 % of 16MHz
+**  - baseline.tsv of test/sim keeps the measured c
+**
+** Users: the LED bank D1 ~ D4 (PB0, PB1, PB2, PB4, lib/board.h) of module00/ex04, and of
+** module04/ex02 / module05/ex04 when they dim it. One engine per program: Timer2 and
+** TIMER2_COMPA_vect are its own (not with systime.c on Timer2 or init_rgb() of pwm.h)
+**
+** PORT write
+**  - The whole mask is written with one store per slot (read PORT, merge, write PORT)
+**  - Other bits of the same port are kept, but main code must not do a non atomic
+**    read-modify-write on that port (|= with more than one bit) while the engine is running
+**  - gpio_leds() writes the engine pins too: bam_set() + bam_commit() instead
+*/
+
+#define BAM_BITS        8
+#define BAM_PRESCALER   256
+#define BAM_UNIT_US     ((BAM_PRESCALER * 1000000UL) / F_CPU)     /* 16us */
+#define BAM_REFRESH_HZ  (F_CPU / (BAM_PRESCALER * 255UL))         /* 245Hz */
+
+void bam_init(volatile uint8_t *port, uint8_t mask);
+void bam_set(uint8_t pin, uint8_t level);
+void bam_commit(void);
+void bam_stop(void);
+
+#endif
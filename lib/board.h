@@ -0,0 +1,166 @@
+#ifndef BOARD_H
+# define BOARD_H
+
+#include <avr/io.h>
+
+/*
+** Board description: every pin the exercises drive or read, in one table
+**
+**  X(g, p, name, group, index, port, bit, mode)
+**  - group: pins used together (LED, SW, RGB), index: their bit in a group value (gpio_leds())
+**  - port / bit: B / C / D, 0 ~ 7
+**  - mode: OUT_LOW / OUT_HIGH / IN / IN_PULLUP (state given by BOARD_INIT() / BOARD_SETUP())
+**  - g / p: passed through to X by the generators below (group / port being computed)
+**
+** Remapping a LED or a switch is one line here, the code never names a port or a bit:
+**  - PIN_MASK / PIN_BIT / PIN_INDEX / PIN_PORT(name): integer constant expressions
+**    (PIN_PORT has the INPUT_PORTB / C / D numbers of input.h)
+**  - PIN_SET / PIN_CLR / PIN_OUTPUT / PIN_INPUT(name): one sbi / cbi
+**    PIN_TOGGLE(name): one out to PINx (writing 1 toggles, page 60 14.2.2), PIN_READ(name): sbis / sbic
+**    (the register is picked by a constant condition, the other branches are folded away)
+**  - BOARD_MASK(groups, port): pins of the groups on one port (BOARD_LED | BOARD_SW...)
+**  - BOARD_WRITE(groups, value): value bit i -> pin of index i, one read-modify-write per port used
+**  - BOARD_INIT(groups): from the reset state, PORT then DDR of each port used in one store
+**    (no glitch: an OUT_HIGH pin is a pull-up for a cycle, never driven low)
+**    BOARD_SETUP(groups): the same at any time, the other pins of the port are kept
+**  - BOARD_ONE_PORT(groups), BOARD_GROUP_MASK / BOARD_GROUP_REG: groups read as one PINx value
+**
+** Pins on a timer output (OC0A PD6, OC0B PD5, OC1A PB1, OC2B PD3) or an external interrupt
+** (INT0 PD2) are fixed by the hardware: the code using them checks with BOARD_ASSERT()
+*/
+
+#define BOARD_PINS(X, g, p) \
+    X(g, p, LED_D1, LED, 0, B, 0, OUT_LOW) \
+    X(g, p, LED_D2, LED, 1, B, 1, OUT_LOW) \
+    X(g, p, LED_D3, LED, 2, B, 2, OUT_LOW) \
+    X(g, p, LED_D4, LED, 3, B, 4, OUT_LOW) \
+    X(g, p, SW1,    SW,  0, D, 2, IN_PULLUP) \
+    X(g, p, SW2,    SW,  1, D, 4, IN_PULLUP) \
+    X(g, p, RGB_R,  RGB, 0, D, 5, OUT_LOW) \
+    X(g, p, RGB_G,  RGB, 1, D, 6, OUT_LOW) \
+    X(g, p, RGB_B,  RGB, 2, D, 3, OUT_LOW)
+
+/* Groups (bits, may be or-ed) */
+#define BOARD_LED       0x01
+#define BOARD_SW        0x02
+#define BOARD_RGB       0x04
+#define BOARD_ALL       0x07
+
+/* Modes: bit 0 output, bit 1 PORT level (high / pull-up) */
+#define BOARD_MODE_IN           0x00
+#define BOARD_MODE_OUT_LOW      0x01
+#define BOARD_MODE_IN_PULLUP    0x02
+#define BOARD_MODE_OUT_HIGH     0x03
+
+/* Same numbers as INPUT_PORTB / C / D */
+#define BOARD_PORT_B    0
+#define BOARD_PORT_C    1
+#define BOARD_PORT_D    2
+
+#define BOARD_ENUM_X(g, p, name, group, index, port, bit, mode) \
+    BOARD_BIT_##name = (bit), \
+    BOARD_INDEX_##name = (index), \
+    BOARD_PORT_##name = BOARD_PORT_##port,
+
+enum e_board_pin
+{
+    BOARD_PINS(BOARD_ENUM_X, _, _)
+};
+
+#define PIN_BIT(name)       BOARD_BIT_##name
+#define PIN_MASK(name)      (1 << BOARD_BIT_##name)
+#define PIN_INDEX(name)     BOARD_INDEX_##name
+#define PIN_PORT(name)      BOARD_PORT_##name
+
+/* PORTx / DDRx / PINx of a pin */
+#define BOARD_REG(reg, name) \
+    (*(BOARD_PORT_##name == BOARD_PORT_B ? &reg##B : BOARD_PORT_##name == BOARD_PORT_C ? &reg##C : &reg##D))
+
+#define PIN_SET(name)       (BOARD_REG(PORT, name) |= PIN_MASK(name))
+#define PIN_CLR(name)       (BOARD_REG(PORT, name) &= ~PIN_MASK(name))
+#define PIN_TOGGLE(name)    (BOARD_REG(PIN, name) = PIN_MASK(name))
+#define PIN_READ(name)      (BOARD_REG(PIN, name) & PIN_MASK(name))
+#define PIN_OUTPUT(name)    (BOARD_REG(DDR, name) |= PIN_MASK(name))
+#define PIN_INPUT(name)     (BOARD_REG(DDR, name) &= ~PIN_MASK(name))
+
+/* Compile time check of a pin the hardware fixes (timer output, INTx) */
+#define BOARD_ASSERT(name, port, bit) \
+    _Static_assert(BOARD_PORT_##name == BOARD_PORT_##port && BOARD_BIT_##name == (bit), \
+                   #name " must stay on P" #port #bit " (hardware function)")
+
+/*
+** Generators: one term per pin of the table, 0 for the pins outside (groups, port),
+** the sum is a constant
+*/
+#define BOARD_HERE(g, p, group, port) \
+    (((g) & BOARD_##group) && BOARD_PORT_##port == BOARD_PORT_##p)
+
+#define BOARD_MASK_X(g, p, name, group, index, port, bit, mode) \
+    | (BOARD_HERE(g, p, group, port) ? (1 << (bit)) : 0)
+#define BOARD_DDR_X(g, p, name, group, index, port, bit, mode) \
+    | (BOARD_HERE(g, p, group, port) && (BOARD_MODE_##mode & 0x01) ? (1 << (bit)) : 0)
+#define BOARD_LEVEL_X(g, p, name, group, index, port, bit, mode) \
+    | (BOARD_HERE(g, p, group, port) && (BOARD_MODE_##mode & 0x02) ? (1 << (bit)) : 0)
+#define BOARD_VALUE_X(g, p, name, group, index, port, bit, mode) \
+    | (BOARD_HERE(g, p, group, port) && (board_value_ & (1 << (index))) ? (1 << (bit)) : 0)
+
+#define BOARD_MASK(g, p)    (0 BOARD_PINS(BOARD_MASK_X, g, p))
+#define BOARD_DDR(g, p)     (0 BOARD_PINS(BOARD_DDR_X, g, p))
+#define BOARD_LEVEL(g, p)   (0 BOARD_PINS(BOARD_LEVEL_X, g, p))
+
+/* Groups with all their pins on one port (read as one value: PINx & mask) */
+#define BOARD_ONE_PORT(g) \
+    ((BOARD_MASK(g, B) != 0) + (BOARD_MASK(g, C) != 0) + (BOARD_MASK(g, D) != 0) == 1)
+#define BOARD_GROUP_MASK(g) (BOARD_MASK(g, B) | BOARD_MASK(g, C) | BOARD_MASK(g, D))
+#define BOARD_GROUP_REG(reg, g) \
+    (*(BOARD_MASK(g, B) ? &reg##B : BOARD_MASK(g, C) ? &reg##C : &reg##D))
+
+#define BOARD_WRITE_PORT(g, p) \
+    do { \
+        if (BOARD_MASK(g, p)) \
+            PORT##p = (PORT##p & ~BOARD_MASK(g, p)) | (0 BOARD_PINS(BOARD_VALUE_X, g, p)); \
+    } while (0)
+
+#define BOARD_WRITE(g, value) \
+    do { \
+        uint8_t board_value_ = (value); \
+        BOARD_WRITE_PORT(g, B); \
+        BOARD_WRITE_PORT(g, C); \
+        BOARD_WRITE_PORT(g, D); \
+    } while (0)
+
+#define BOARD_INIT_PORT(g, p) \
+    do { \
+        if (BOARD_MASK(g, p)) \
+        { \
+            PORT##p = BOARD_LEVEL(g, p); \
+            DDR##p = BOARD_DDR(g, p); \
+        } \
+    } while (0)
+
+/* Reset state only: the other pins of a port used are set back to input, no pull-up */
+#define BOARD_INIT(g) \
+    do { \
+        BOARD_INIT_PORT(g, B); \
+        BOARD_INIT_PORT(g, C); \
+        BOARD_INIT_PORT(g, D); \
+    } while (0)
+
+/* Any time: only the pins of the groups change (read-modify-write) */
+#define BOARD_SETUP_PORT(g, p) \
+    do { \
+        if (BOARD_MASK(g, p)) \
+        { \
+            PORT##p = (PORT##p & ~BOARD_MASK(g, p)) | BOARD_LEVEL(g, p); \
+            DDR##p = (DDR##p & ~BOARD_MASK(g, p)) | BOARD_DDR(g, p); \
+        } \
+    } while (0)
+
+#define BOARD_SETUP(g) \
+    do { \
+        BOARD_SETUP_PORT(g, B); \
+        BOARD_SETUP_PORT(g, C); \
+        BOARD_SETUP_PORT(g, D); \
+    } while (0)
+
+#endif
@@ -0,0 +1,104 @@
+#include "clock.h"
+#include <util/delay.h>
+#include <util/atomic.h>
+
+static t_clock_listener g_clock_listener[CLOCK_LISTENERS];
+static uint8_t g_clock_listeners = 0;
+static uint8_t g_clock_div = CLOCK_16MHZ;
+
+/* systime.c, if linked (weak: clock.c does not need it) */
+void systime_clock(uint8_t div) __attribute__((weak));
+
+/*
+** 0 -> table full
+*/
+uint8_t clock_listen(t_clock_listener listener)
+{
+    if (g_clock_listeners == CLOCK_LISTENERS)
+        return 0;
+    g_clock_listener[g_clock_listeners++] = listener;
+    return 1;
+}
+
+/*
+** Timed sequence (page 37): CLKPCE alone, then the prescaler within 4 cycles
+*/
+void clock_set(uint8_t div)
+{
+    if (div > CLOCK_1MHZ)
+        div = CLOCK_1MHZ;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (div == g_clock_div)
+            return;
+
+        CLKPR = (1 << CLKPCE);
+        CLKPR = div;
+        g_clock_div = div;
+
+        if (systime_clock)
+            systime_clock(div);
+        for (uint8_t i = 0; i < g_clock_listeners; i++)
+            g_clock_listener[i](div);
+    }
+}
+
+/*
+** Prescaler and TOP giving the same period at the clock F_CPU >> div (timer_cfg.h listeners)
+** cycles: prescaler x (TOP + 1) at F_CPU, prescalers are powers of 2 (page 110 15-9 / 165 18-9)
+** The smallest prescaler whose counts fit wins (best resolution, the rounding is under half
+** a count), the slowest one at its longest period when none does
+** Returns the CS bits
+*/
+uint8_t clock_timer(uint8_t timer, uint32_t cycles, uint8_t div, uint16_t *top)
+{
+    static const uint8_t shift01[] = { 0, 3, 6, 8, 10 };            /* 1, 8, 64, 256, 1024 */
+    static const uint8_t shift2[] = { 0, 3, 5, 6, 7, 8, 10 };       /* 1, 8, 32, ... 1024 */
+    const uint8_t *shift = (timer == 2) ? shift2 : shift01;
+    uint8_t count = (timer == 2) ? sizeof(shift2) : sizeof(shift01);
+    uint32_t max = (timer == 1) ? 65536UL : 256UL;
+    uint32_t counts = max;
+    uint8_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        uint8_t s = shift[i] + div;
+
+        counts = (cycles + ((1UL << s) >> 1)) >> s;
+        if (counts <= max)
+            break;
+    }
+    if (i == count)
+    {
+        i = count - 1;
+        counts = max;
+    }
+    if (counts < 2)
+        counts = 2;
+    *top = counts - 1;
+    return i + 1;
+}
+
+uint8_t clock_div(void)
+{
+    return g_clock_div;
+}
+
+uint32_t clock_hz(void)
+{
+    return CLOCK_HZ(g_clock_div);
+}
+
+/*
+** 1ms = 16 steps of 62.5us at 16MHz, a step lasts (1 << div) times longer at a lower clock
+** -> (16 >> div) steps per ms
+*/
+void clock_delay_ms(uint16_t ms)
+{
+    while (ms--)
+    {
+        for (uint8_t step = 16 >> g_clock_div; step; step--)
+            _delay_us(62.5);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef CLOCK_H
+# define CLOCK_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*
+** System clock prescaler at run time (CLKPR, page 37 8.12.2)
+**  - F_CPU stays the full speed clock (16MHz), the CPU runs at F_CPU >> div
+**  - CLOCK_16MHZ (div 0) ~ CLOCK_1MHZ (div 4)
+**  - Supply current goes down with the clock (page 304): slow while waiting on a bus, full speed for bursts
+**
+** Every peripheral on the I/O clock slows down with the CPU, so values computed from F_CPU are wrong after a change
+**  - clock_set() calls every listener with the new div, interrupts off, right after the change
+**    (UART: uart_clock(), TWI: i2c_clock(), ADC: adc_clock(), timers of timer_cfg.h: timer0_clock() ~ timer2_clock())
+**  - systime (when linked) is always told first, micros() / millis() stay right
+**  - timers set up by hand have no listener: lib/pwm.c (no prescaler, TOP 255) keeps its duty
+**    cycles, its PWM frequency goes down with the clock (62.5kHz -> 3.9kHz at 1MHz)
+**  - _delay_ms() / _delay_us() are computed for F_CPU: they last (1 << div) times longer,
+**    clock_delay_ms() follows the clock
+**
+** Before a change: wait for the last UART byte (TXC0) and the end of TWI transfers
+** (a byte on the wire would be cut at the wrong bit rate)
+*/
+
+#define CLOCK_16MHZ     0
+#define CLOCK_8MHZ      1
+#define CLOCK_4MHZ      2
+#define CLOCK_2MHZ      3
+#define CLOCK_1MHZ      4
+
+#define CLOCK_LISTENERS 4
+
+#define CLOCK_HZ(div)   (F_CPU >> (div))
+
+/* Rounded (not truncated) divisors, lowest error at every clock */
+#define CLOCK_UBRR_U2X(div, baud)   ((CLOCK_HZ(div) + 4UL * (baud)) / (8UL * (baud)) - 1)
+#define CLOCK_TWBR(div, scl)        ((CLOCK_HZ(div) / (scl) > 16) ? (CLOCK_HZ(div) / (scl) - 16) / 2 : 0)   /* 0: fastest (clk / 16) */
+
+typedef void (*t_clock_listener)(uint8_t div);
+
+uint8_t     clock_listen(t_clock_listener listener);
+void        clock_set(uint8_t div);
+uint8_t     clock_div(void);
+uint32_t    clock_hz(void);
+void        clock_delay_ms(uint16_t ms);
+uint8_t     clock_timer(uint8_t timer, uint32_t cycles, uint8_t div, uint16_t *top);
+
+#endif
@@ -0,0 +1,43 @@
+#include "debounce.h"
+
+/*
+** Start from the current level so a switch held at boot does not give a press edge
+*/
+void debounce_init(t_debounce *d, uint8_t active)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        d->state = active;
+        d->ct0 = 0xFF;
+        d->ct1 = 0xFF;
+        d->press = 0;
+        d->release = 0;
+    }
+}
+
+/*
+** Read and clear the edges of the pins of mask (atomic, works from main or from an ISR)
+*/
+uint8_t debounce_pressed(t_debounce *d, uint8_t mask)
+{
+    uint8_t edges;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        edges = d->press & mask;
+        d->press &= ~mask;
+    }
+    return edges;
+}
+
+uint8_t debounce_released(t_debounce *d, uint8_t mask)
+{
+    uint8_t edges;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        edges = d->release & mask;
+        d->release &= ~mask;
+    }
+    return edges;
+}
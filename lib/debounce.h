@@ -0,0 +1,54 @@
+#ifndef DEBOUNCE_H
+# define DEBOUNCE_H
+
+#include <avr/io.h>
+#include <util/atomic.h>
+
+/*
+** Debounce of 8 pins in parallel with 2 bit vertical counters
+**  - One byte per counter bit: bit n of ct0/ct1 is the counter of pin n
+**  - A pin must read the same value 4 ticks in a row to change its debounced state
+**  - Every tick is ~10 instructions for the whole port, no branch, no delay
+**  - Call debounce_tick() from a periodic ISR (10ms -> 40ms debounce time)
+**
+** active: 1 = pressed (switches are active low, so give ~PIND)
+** press / release: edges collected since the last read (sticky until read)
+*/
+
+typedef struct s_debounce
+{
+    uint8_t             state;      /* Debounced level (1 = pressed) */
+    uint8_t             ct0;        /* Vertical counter, bit 0 */
+    uint8_t             ct1;        /* Vertical counter, bit 1 */
+    volatile uint8_t    press;      /* 0 -> 1 edges not read yet */
+    volatile uint8_t    release;    /* 1 -> 0 edges not read yet */
+}   t_debounce;
+
+void    debounce_init(t_debounce *d, uint8_t active);
+uint8_t debounce_pressed(t_debounce *d, uint8_t mask);
+uint8_t debounce_released(t_debounce *d, uint8_t mask);
+
+/*
+** changed = pins whose sample differs from the debounced state
+**  - their counter counts down (3 -> 2 -> 1 -> 0 -> roll over)
+**  - the others are reset to 3
+**  - on roll over the debounced state toggles and the edge is published
+*/
+static inline void debounce_tick(t_debounce *d, uint8_t active)
+{
+    uint8_t changed = d->state ^ active;
+
+    d->ct0 = ~(d->ct0 & changed);
+    d->ct1 = d->ct0 ^ (d->ct1 & changed);
+    changed &= d->ct0 & d->ct1;
+    d->state ^= changed;
+    d->press |= d->state & changed;
+    d->release |= ~d->state & changed;
+}
+
+static inline uint8_t debounce_state(const t_debounce *d, uint8_t mask)
+{
+    return d->state & mask;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#include "eeprom.h"
+
+/* kvstore.c / elog.c, if linked (weak: a program may have only one of them) */
+uint8_t kv_ready(void) __attribute__((weak));
+uint8_t elog_ready(void) __attribute__((weak));
+
+/* EEPE is clear when this runs (page 30): one write started per interrupt */
+ISR(EE_READY_vect)
+{
+    if (kv_ready && kv_ready())
+        return;
+    if (elog_ready && elog_ready())
+        return;
+    EECR &= ~(1 << EERIE);                      /* Both queues empty */
+}
+
+void eeprom_ready(void)
+{
+    EECR |= (1 << EERIE);
+}
@@ -0,0 +1,18 @@
+#ifndef EEPROM_H
+# define EEPROM_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*
+** EEPROM ready interrupt, shared by the write queues of kvstore.c and elog.c
+**  - EE_READY_vect asks each user linked in turn (weak calls, kvstore first) for its next byte:
+**    kv_ready() / elog_ready() start one write and return 1, or return 0 when they have
+**    nothing left, then the interrupt is turned off
+**  - a user with new bytes calls eeprom_ready(), the interrupt fires at once if EEPE is clear
+**  - the two users have their own part of the EEPROM (kvstore 0 ~ 511, elog 512 ~ 1023)
+*/
+
+void    eeprom_ready(void);
+
+#endif
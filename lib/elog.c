@@ -0,0 +1,389 @@
+#include "elog.h"
+#include "eeprom.h"
+#include "uart.h"
+#include <util/crc16.h>
+#include <util/atomic.h>
+#include <string.h>
+
+/* Page header (little endian) */
+#define ELOG_H_VERSION      0
+#define ELOG_H_SEQ          1
+#define ELOG_H_CHANNELS     3
+#define ELOG_H_TICK         4
+#define ELOG_H_TIME         6           /* Base sample: time, then the values */
+#define ELOG_H_VALUES       10
+#define ELOG_BODY(ch)       (ELOG_H_VALUES + 2 * (ch))
+
+#define ELOG_RECORD_MAX     (1 + 5 + 3 * ELOG_CHANNELS)     /* Flags, 32 bit varint, 17 bit varints */
+#define ELOG_PAGE_ADDR(p)   (ELOG_EEPROM_START + (uint16_t)(p) * ELOG_PAGE_SIZE)
+
+/*
+** RAM page, filled by elog_add() then written by the ISR
+**  - fill: end of the records (0 -> page not open)
+**  - used: end of the last commit, what the ISR writes (data only grows past it)
+**  - pos: ISR position, up to used
+*/
+typedef struct s_elog_page
+{
+    uint8_t             data[ELOG_PAGE_SIZE];
+    uint8_t             slot;
+    uint8_t             fill;
+    uint8_t             used;
+    volatile uint8_t    pos;
+    volatile uint8_t    pending;
+}   t_elog_page;
+
+static t_elog_page g_elog_page[2];
+static uint8_t g_elog_open = 0;                 /* Page elog_add() fills */
+
+static uint8_t g_elog_channels;
+static uint16_t g_elog_tick;
+static uint8_t g_elog_slot = ELOG_PAGES - 1;    /* EEPROM page of the newest page */
+static uint16_t g_elog_seq = 0xFFFF;
+static uint16_t g_elog_lost = 0;
+
+/* Sample before, for the differences */
+static uint32_t g_elog_time;
+static uint32_t g_elog_period;
+static int16_t g_elog_values[ELOG_CHANNELS];
+
+/* The page still being written first: it was sealed before the open one was flushed */
+static t_elog_page *elog_job(void)
+{
+    t_elog_page *other = &g_elog_page[g_elog_open ^ 1];
+
+    if (other->pending)
+        return other;
+    if (g_elog_page[g_elog_open].pending)
+        return &g_elog_page[g_elog_open];
+    return 0;
+}
+
+/*
+** Next byte from EE_READY_vect (eeprom.c, after kvstore), EEPE is clear when this runs (page 30)
+** Bytes already right in the EEPROM are skipped in the same interrupt
+** 1 -> a write started, 0 -> queue empty
+*/
+uint8_t elog_ready(void)
+{
+    t_elog_page *page;
+
+    while ((page = elog_job()))
+    {
+        uint8_t pos = page->pos;
+
+        if (pos == page->used)
+        {
+            page->pending = 0;
+            continue;
+        }
+        page->pos = pos + 1;
+
+        EEAR = ELOG_PAGE_ADDR(page->slot) + pos;
+        EECR |= (1 << EERE);
+        if (EEDR != page->data[pos])
+        {
+            EEDR = page->data[pos];
+            EECR |= (1 << EEMPE);               /* EEPE within 4 cycles (page 30) */
+            EECR |= (1 << EEPE);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+** EEAR cannot change during a write (page 30): the wait (3.4ms at most) is done with interrupts
+** on, the read with them off, after EEPE is checked again (EE_READY_vect may have started the
+** next byte in between)
+*/
+static uint8_t elog_read(uint16_t addr)
+{
+    while (1)
+    {
+        while (EECR & (1 << EEPE))
+            ;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            if (!(EECR & (1 << EEPE)))
+            {
+                EEAR = addr;
+                EECR |= (1 << EERE);
+                return EEDR;
+            }
+        }
+    }
+}
+
+/* Commit at offset of data: marker, CRC of the page up to it (marker included) */
+static uint8_t elog_commit(uint8_t *data, uint8_t offset)
+{
+    uint16_t crc = 0xFFFF;
+
+    data[offset] = ELOG_COMMIT;
+    for (uint8_t i = 0; i <= offset; i++)
+        crc = _crc_ccitt_update(crc, data[i]);
+    data[offset + 1] = crc & 0xFF;
+    data[offset + 2] = crc >> 8;
+    return offset + ELOG_COMMIT_SIZE;
+}
+
+/* Zig-zag varint of value at out, returns its size */
+static uint8_t elog_varint(uint8_t *out, int32_t value)
+{
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    uint8_t size = 0;
+
+    while (zigzag >= 0x80)
+    {
+        out[size++] = zigzag | 0x80;
+        zigzag >>= 7;
+    }
+    out[size++] = zigzag;
+    return size;
+}
+
+/*
+** Page read into scratch: a valid header and a good first commit
+** The records are only walked (flags, varint ends), not decoded
+*/
+static uint8_t elog_check(uint8_t slot, uint8_t *scratch)
+{
+    uint16_t addr = ELOG_PAGE_ADDR(slot);
+    uint8_t channels;
+    uint8_t offset;
+    uint16_t crc = 0xFFFF;
+
+    for (uint8_t i = 0; i < ELOG_PAGE_SIZE; i++)
+        scratch[i] = elog_read(addr + i);
+    channels = scratch[ELOG_H_CHANNELS];
+    if (scratch[ELOG_H_VERSION] != ELOG_VERSION || channels == 0 || channels > ELOG_CHANNELS)
+        return 0;
+    for (offset = 0; offset < ELOG_BODY(channels); offset++)
+        crc = _crc_ccitt_update(crc, scratch[offset]);
+
+    while (offset + ELOG_COMMIT_SIZE <= ELOG_PAGE_SIZE)
+    {
+        uint8_t flags = scratch[offset++];
+        uint8_t fields = 0;
+
+        crc = _crc_ccitt_update(crc, flags);
+        if (flags == ELOG_COMMIT)
+            return crc == (scratch[offset] | (scratch[offset + 1] << 8));
+        if (flags & ~(ELOG_TIME_BIT | ((1 << channels) - 1)))
+            return 0;                           /* Erased (0xFF) or not a record */
+        for (; flags; flags >>= 1)
+            fields += flags & 1;
+        while (fields && offset < ELOG_PAGE_SIZE)
+        {
+            crc = _crc_ccitt_update(crc, scratch[offset]);
+            fields -= !(scratch[offset++] & 0x80);
+        }
+    }
+    return 0;
+}
+
+/*
+** channels: 1 ~ ELOG_CHANNELS values per sample, tick_ms: time unit of the records
+** Finds the newest page of the ring, the first sample opens the page after it
+*/
+void elog_init(uint8_t channels, uint16_t tick_ms)
+{
+    uint8_t valid = 0;                          /* A page found */
+
+    g_elog_channels = channels;
+    g_elog_tick = tick_ms;
+    g_elog_slot = ELOG_PAGES - 1;               /* Blank EEPROM: the first page is 0 */
+    g_elog_seq = 0xFFFF;
+    g_elog_open = 0;
+    g_elog_lost = 0;
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        g_elog_page[i].pending = 0;
+        g_elog_page[i].fill = 0;
+    }
+
+    for (uint8_t slot = 0; slot < ELOG_PAGES; slot++)
+    {
+        uint8_t *scratch = g_elog_page[0].data;
+        uint16_t seq;
+
+        if (!elog_check(slot, scratch))
+            continue;
+        seq = scratch[ELOG_H_SEQ] | (scratch[ELOG_H_SEQ + 1] << 8);
+        if (!valid || (int16_t)(seq - g_elog_seq) > 0)
+        {
+            g_elog_slot = slot;
+            g_elog_seq = seq;
+        }
+        valid = 1;
+    }
+}
+
+/* Next page of the ring in page, sample as its base */
+static void elog_open(t_elog_page *page, uint32_t time, const int16_t *values)
+{
+    uint8_t *data = page->data;
+
+    g_elog_slot = (g_elog_slot + 1) % ELOG_PAGES;
+    g_elog_seq++;
+    memset(data, 0xFF, ELOG_PAGE_SIZE);
+    data[ELOG_H_VERSION] = ELOG_VERSION;
+    data[ELOG_H_SEQ] = g_elog_seq & 0xFF;
+    data[ELOG_H_SEQ + 1] = g_elog_seq >> 8;
+    data[ELOG_H_CHANNELS] = g_elog_channels;
+    data[ELOG_H_TICK] = g_elog_tick & 0xFF;
+    data[ELOG_H_TICK + 1] = g_elog_tick >> 8;
+    memcpy(&data[ELOG_H_TIME], &time, 4);       /* Little endian */
+    memcpy(&data[ELOG_H_VALUES], values, 2 * g_elog_channels);
+    page->slot = g_elog_slot;
+    page->fill = ELOG_BODY(g_elog_channels);
+    page->used = 0;                             /* Nothing of it written yet */
+    page->pos = 0;
+
+    g_elog_time = time;
+    g_elog_period = 0;
+    memcpy(g_elog_values, values, 2 * g_elog_channels);
+}
+
+/*
+** Sample at ms (millis(), or any ms clock) with g_elog_channels values
+** ELOG_ERR_BUSY: the page is full and the one before is still being written
+*/
+uint8_t elog_add(uint32_t ms, const int16_t *values)
+{
+    t_elog_page *page = &g_elog_page[g_elog_open];
+    uint32_t time = ms / g_elog_tick;
+    uint8_t record[ELOG_RECORD_MAX];
+    uint8_t size = 1;
+
+    if (page->fill)
+    {
+        uint32_t period = time - g_elog_time;
+
+        record[0] = 0;
+        if (period != g_elog_period)
+        {
+            record[0] |= ELOG_TIME_BIT;
+            size += elog_varint(&record[size], (int32_t)(period - g_elog_period));
+        }
+        for (uint8_t i = 0; i < g_elog_channels; i++)
+        {
+            if (values[i] != g_elog_values[i])
+            {
+                record[0] |= 1 << i;
+                size += elog_varint(&record[size], (int32_t)values[i] - g_elog_values[i]);
+            }
+        }
+        if (page->fill + size + ELOG_COMMIT_SIZE <= ELOG_PAGE_SIZE)     /* Room kept for the commit */
+        {
+            memcpy(&page->data[page->fill], record, size);
+            page->fill += size;
+            g_elog_time = time;
+            g_elog_period = period;
+            memcpy(g_elog_values, values, 2 * g_elog_channels);
+            return ELOG_OK;
+        }
+
+        /* Full: committed, the sample opens the next page in the other one */
+        if (g_elog_page[g_elog_open ^ 1].pending)
+        {
+            if (g_elog_lost != 0xFFFF)
+                g_elog_lost++;
+            return ELOG_ERR_BUSY;
+        }
+        elog_flush();
+        g_elog_open ^= 1;
+        page = &g_elog_page[g_elog_open];
+    }
+    elog_open(page, time, values);
+    return ELOG_OK;
+}
+
+/*
+** Commit the open page and queue what is new in it (nothing new -> nothing)
+** A write of the page still going on goes on with it
+*/
+void elog_flush(void)
+{
+    t_elog_page *page = &g_elog_page[g_elog_open];
+
+    if (!page->fill || page->fill == page->used)
+        return;
+    page->fill = elog_commit(page->data, page->fill);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        page->used = page->fill;
+        page->pending = 1;
+        eeprom_ready();
+    }
+}
+
+uint8_t elog_busy(void)
+{
+    return g_elog_page[0].pending || g_elog_page[1].pending;
+}
+
+/* Queue written (before a power down: EE_READY_vect does not wake the CPU up) */
+void elog_sync(void)
+{
+    while (elog_busy())
+        ;
+}
+
+static uint16_t elog_tx(uint16_t crc, uint8_t byte)
+{
+    uart_tx(byte);
+    return _crc_ccitt_update(crc, byte);
+}
+
+/*
+** Binary dump (tools/elog_dump.py), every field little endian
+**   'E' 'L' | version 1 | page size | lost (16 bit) | page count | {page} ...
+**   CRC-16 CCITT (0xFFFF) of everything after 'E' 'L'
+**
+** The EEPROM pages as they are, then the RAM pages (the open one with a commit after its
+** records, in RAM only): a page which comes twice (same sequence) is newer the second time
+** 128 bytes at 115200 baud: 11ms per page
+*/
+void elog_dump(void)
+{
+    uint16_t crc = 0xFFFF;
+    uint8_t count = ELOG_PAGES;
+    uint8_t ram[2] = { g_elog_open ^ 1, g_elog_open };     /* Older first */
+    t_elog_page *open = &g_elog_page[g_elog_open];
+
+    for (uint8_t i = 0; i < 2; i++)
+        count += g_elog_page[ram[i]].fill != 0;
+
+    uart_tx('E');
+    uart_tx('L');
+    crc = elog_tx(crc, ELOG_VERSION);
+    crc = elog_tx(crc, ELOG_PAGE_SIZE);
+    crc = elog_tx(crc, g_elog_lost & 0xFF);
+    crc = elog_tx(crc, g_elog_lost >> 8);
+    crc = elog_tx(crc, count);
+
+    for (uint8_t slot = 0; slot < ELOG_PAGES; slot++)
+    {
+        uint16_t addr = ELOG_PAGE_ADDR(slot);
+
+        for (uint8_t i = 0; i < ELOG_PAGE_SIZE; i++)
+            crc = elog_tx(crc, elog_read(addr + i));
+    }
+    if (open->fill && open->fill != open->used)
+        elog_commit(open->data, open->fill);    /* Past fill: the next records go over it */
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        t_elog_page *page = &g_elog_page[ram[i]];
+
+        if (!page->fill)
+            continue;
+        for (uint8_t j = 0; j < ELOG_PAGE_SIZE; j++)
+            crc = elog_tx(crc, page->data[j]);
+    }
+    uart_tx(crc & 0xFF);
+    uart_tx(crc >> 8);
+    g_elog_lost = 0;
+}
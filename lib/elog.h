@@ -0,0 +1,70 @@
+#ifndef ELOG_H
+# define ELOG_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*
+** Sample logger in EEPROM: timestamped samples of 1 ~ ELOG_CHANNELS int16 values,
+** kept when no host listens, read back in one binary dump (tools/elog_dump.py)
+**
+** Layout: ELOG_EEPROM_SIZE bytes from ELOG_EEPROM_START (the half kvstore leaves), pages of
+** 128 bytes written as a ring, the oldest page goes when the ring comes back to it
+**  - page   : version, sequence (16 bit), channels, tick (ms), base time (ticks, 32 bit),
+**             base values (int16), then records and commits
+**  - record : flags, then a zig-zag varint per set bit, the period one first
+**             bit 6: period changed, the varint is the difference with the period before
+**             bit 0 ~ 3: channel changed, the varint is the difference with the sample before
+**  - zig-zag: 0, -1, 1, -2... -> 0, 1, 2, 3... then 7 bits per byte, bit 7 = more bytes
+**  - commit : ELOG_COMMIT, CRC16 (CCITT) of the page from its first byte to the marker:
+**             the records before the last good commit are the page, pages are never erased
+**             (a commit left over from an older round fails: the sequence is in its CRC)
+**
+** Size: a sample at the same period with the same values is 1 byte, one value which moved
+** by less than 64 is 2 bytes (8 for the raw time and two values)
+**
+** Writes are page aligned and asynchronous: samples go to a RAM page, a full page (or
+** elog_flush()) gets a commit and its new bytes are queued, EE_READY_vect writes one byte per
+** interrupt (3.4ms each, page 29 8.4.3, shared with kvstore: eeprom.c) and skips the bytes
+** already right in the EEPROM
+**  - only appended: a reset in the middle of a write leaves the page as it was at the commit
+**    before, the header is written once per page
+**  - two RAM pages: the next one fills while the last one is written, a sample coming while
+**    both are taken is dropped (ELOG_ERR_BUSY, counted in the dump)
+**  - a reset loses the samples not flushed yet (one page at most)
+**
+** Wear: every byte of a page is written once per round of the ring, a flush costs the 3 bytes
+** of its commit: flush every few dozen samples, not every sample
+*/
+
+#ifndef ELOG_EEPROM_START
+# define ELOG_EEPROM_START  512
+#endif
+#ifndef ELOG_EEPROM_SIZE
+# define ELOG_EEPROM_SIZE   512
+#endif
+
+#define ELOG_PAGE_SIZE      128
+#define ELOG_PAGES          (ELOG_EEPROM_SIZE / ELOG_PAGE_SIZE)
+#define ELOG_VERSION        0x01
+#define ELOG_CHANNELS       4           /* Flag bits 0 ~ 3 */
+#define ELOG_TIME_BIT       0x40
+#define ELOG_COMMIT         0x80        /* Never a record (bit 7 is not a flag) */
+#define ELOG_COMMIT_SIZE    3
+
+#if ELOG_EEPROM_SIZE % ELOG_PAGE_SIZE || ELOG_PAGES < 2 || ELOG_EEPROM_START + ELOG_EEPROM_SIZE > E2END + 1
+# error "elog: ELOG_EEPROM_SIZE must be 2 pages of 128 bytes or more, inside the EEPROM"
+#endif
+
+#define ELOG_OK             0
+#define ELOG_ERR_BUSY       1           /* Both RAM pages taken, sample dropped */
+
+void    elog_init(uint8_t channels, uint16_t tick_ms);
+uint8_t elog_add(uint32_t ms, const int16_t *values);
+void    elog_flush(void);
+uint8_t elog_busy(void);
+void    elog_sync(void);
+void    elog_dump(void);
+uint8_t elog_ready(void);
+
+#endif
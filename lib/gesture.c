@@ -0,0 +1,111 @@
+#include "gesture.h"
+
+#define GESTURE_IDLE    0
+#define GESTURE_DOWN    1   /* Pressed, not long yet */
+#define GESTURE_HOLD    2   /* Long press done, auto repeat */
+#define GESTURE_WAIT    3   /* Released, waiting for a second press */
+#define GESTURE_SECOND  4   /* Second press of a double click, waiting for release */
+
+void gesture_init(t_gesture *g)
+{
+    g->state = GESTURE_IDLE;
+    g->timer = 0;
+    g->period = 0;
+}
+
+/* 0 when nothing is in progress (the caller can sleep until the next pin change) */
+uint8_t gesture_busy(const t_gesture *g)
+{
+    return g->state != GESTURE_IDLE;
+}
+
+/*
+** level: debounced byte (1 = pressed), only cfg->mask is looked at
+*/
+uint8_t gesture_tick(const t_gesture_cfg *cfg, t_gesture *g, uint8_t level)
+{
+    uint8_t down = (level & cfg->mask) != 0;
+    uint8_t events = 0;
+
+    if (g->timer != 0xFF)
+        g->timer++;
+
+    switch (g->state)
+    {
+        case GESTURE_IDLE:
+            if (down)
+            {
+                events = GESTURE_PRESS;
+                g->state = GESTURE_DOWN;
+                g->timer = 0;
+            }
+            break;
+
+        case GESTURE_DOWN:
+            if (!down)
+            {
+                events = GESTURE_RELEASE;
+                if (cfg->double_ticks)
+                {
+                    g->state = GESTURE_WAIT;
+                    g->timer = 0;
+                }
+                else
+                {
+                    events |= GESTURE_CLICK;
+                    g->state = GESTURE_IDLE;
+                }
+            }
+            else if (cfg->long_ticks && g->timer >= cfg->long_ticks)
+            {
+                events = GESTURE_LONG;
+                g->state = GESTURE_HOLD;
+                g->timer = 0;
+                g->period = cfg->repeat_start;
+            }
+            break;
+
+        case GESTURE_HOLD:
+            if (!down)
+            {
+                events = GESTURE_RELEASE;
+                g->state = GESTURE_IDLE;
+            }
+            else if (g->timer >= g->period)
+            {
+                events = GESTURE_REPEAT;
+                g->timer = 0;
+                if (g->period > cfg->repeat_min + cfg->repeat_step)
+                    g->period -= cfg->repeat_step;
+                else
+                    g->period = cfg->repeat_min;
+            }
+            break;
+
+        case GESTURE_WAIT:
+            if (down)
+            {
+                events = GESTURE_PRESS | GESTURE_DOUBLE;
+                g->state = GESTURE_SECOND;
+            }
+            else if (g->timer >= cfg->double_ticks)
+            {
+                events = GESTURE_CLICK;
+                g->state = GESTURE_IDLE;
+            }
+            break;
+
+        case GESTURE_SECOND:
+            if (!down)
+            {
+                events = GESTURE_RELEASE;
+                g->state = GESTURE_IDLE;
+            }
+            break;
+
+        default:
+            g->state = GESTURE_IDLE;
+            break;
+    }
+    return events;
+}
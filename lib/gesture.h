@@ -0,0 +1,52 @@
+#ifndef GESTURE_H
+# define GESTURE_H
+
+#include <avr/io.h>
+
+/*
+** Button gestures on top of debounced levels (debounce.h)
+**  - Called once per tick for each button (10ms tick in the examples), O(1), no delay
+**  - Timings come from a table (one t_gesture_cfg per button), in ticks
+**
+** Events (bits, several can come at the same tick)
+**  - PRESS   : button went down (immediate feedback)
+**  - RELEASE : button went up
+**  - CLICK   : short press, and no second press in the double click window
+**  - DOUBLE  : second press inside the double click window
+**  - LONG    : held for long_ticks
+**  - REPEAT  : while held after LONG, first every repeat_start ticks,
+**              then faster by repeat_step until repeat_min (accelerating auto repeat)
+**
+** double_ticks = 0 -> no double click, CLICK comes at once on release
+** long_ticks   = 0 -> no long press / repeat
+*/
+
+#define GESTURE_PRESS   0x01
+#define GESTURE_RELEASE 0x02
+#define GESTURE_CLICK   0x04
+#define GESTURE_DOUBLE  0x08
+#define GESTURE_LONG    0x10
+#define GESTURE_REPEAT  0x20
+
+typedef struct s_gesture_cfg
+{
+    uint8_t mask;           /* Pin of the button in the debounced byte */
+    uint8_t double_ticks;   /* Window for the second press */
+    uint8_t long_ticks;     /* Hold time for LONG */
+    uint8_t repeat_start;   /* First repeat period */
+    uint8_t repeat_min;     /* Fastest repeat period */
+    uint8_t repeat_step;    /* Period decrease at each repeat */
+}   t_gesture_cfg;
+
+typedef struct s_gesture
+{
+    uint8_t state;
+    uint8_t timer;          /* Ticks in the current state */
+    uint8_t period;         /* Current repeat period */
+}   t_gesture;
+
+void    gesture_init(t_gesture *g);
+uint8_t gesture_tick(const t_gesture_cfg *cfg, t_gesture *g, uint8_t level);
+uint8_t gesture_busy(const t_gesture *g);
+
+#endif
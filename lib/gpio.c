@@ -0,0 +1,27 @@
+#include "gpio.h"
+
+_Static_assert(BOARD_ONE_PORT(BOARD_SW), "board.h: the switches are read with one PINx load");
+
+void gpio_leds_init(void)
+{
+    BOARD_SETUP(BOARD_LED);     /* Outputs, all off */
+}
+
+/*
+** Value bit i -> LED of index i: with D1 ~ D3 on PB0 ~ PB2 and D4 on PB4 the terms fold
+** into (value & 0x07) | ((value & 0x08) << 1), one PORTB store
+*/
+void gpio_leds(uint8_t value)
+{
+    BOARD_WRITE(BOARD_LED, value);
+}
+
+void gpio_switches_init(void)
+{
+    BOARD_SETUP(BOARD_SW);      /* Inputs with pull-ups */
+}
+
+uint8_t gpio_switches(void)
+{
+    return ~BOARD_GROUP_REG(PIN, BOARD_SW) & BOARD_GROUP_MASK(BOARD_SW);
+}
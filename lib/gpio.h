@@ -0,0 +1,21 @@
+#ifndef GPIO_H
+# define GPIO_H
+
+#include <avr/io.h>
+#include "board.h"
+
+/*
+** Board LEDs and switches (pins: lib/board.h, page 58 ~ I/O ports)
+**  - LEDs D1 ~ D4 (group LED, active high)
+**  - switches SW1 / SW2 (group SW): active low, internal pull-ups, on one port
+**  - gpio_leds() shows a 4 bit value (bit 0 -> D1 ... bit 3 -> D4) with one store per port,
+**    the other pins of the port are kept
+**  - gpio_switches(): pressed switches (1 = pressed) at their pin bits, PIN_MASK(SW1) / PIN_MASK(SW2)
+*/
+
+void    gpio_leds_init(void);
+void    gpio_leds(uint8_t value);
+void    gpio_switches_init(void);
+uint8_t gpio_switches(void);
+
+#endif
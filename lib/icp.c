@@ -0,0 +1,215 @@
+#include "icp.h"
+#include "periph.h"
+#include "clock.h"
+
+#define ICP_IDLE        0
+#define ICP_FIRST       1   /* Waiting for the first edge of the gate */
+#define ICP_COUNT       2   /* Counting edges, timestamp on the last one */
+#define ICP_FALL        3   /* Duty: waiting for the falling edge */
+#define ICP_RISE        4   /* Duty: waiting for the end of the period */
+
+static volatile uint16_t g_icp_ovf = 0;         /* High word of the timestamps */
+static volatile uint8_t g_icp_state = ICP_IDLE;
+static uint8_t g_icp_mode;
+static uint8_t g_icp_edge;                      /* ICES1 of the start edge (period mode) */
+static uint16_t g_icp_periods;                  /* N requested (0 -> auto) */
+static uint16_t g_icp_gate;                     /* N of the current gate */
+static uint16_t g_icp_auto = 1;                 /* Last N chosen by the auto range */
+static uint16_t g_icp_left;                     /* Edges left in the current gate */
+static uint32_t g_icp_t0;
+static uint32_t g_icp_t1;
+
+static volatile uint8_t g_icp_ready = 0;
+static t_icp_result g_icp_result;
+
+/*
+** Timer1 normal mode, clk/1, capture + overflow interrupts (page 142 16.11.2)
+*/
+void icp_init(uint8_t flags)
+{
+    DDRB &= ~(1 << DDB0);                       /* ICP1 input */
+    periph_claim(PERIPH_TIM1);
+
+    g_icp_edge = (flags & ICP_RISING) ? (1 << ICES1) : 0;
+
+    TCCR1A = 0;
+    TCCR1B = g_icp_edge | ((flags & ICP_NOISE_CANCEL) ? (1 << ICNC1) : 0) | (1 << CS10);
+    TCNT1 = 0;
+    g_icp_ovf = 0;
+    TIFR1 = (1 << ICF1) | (1 << TOV1);          /* Clear old flags (write 1) */
+    TIMSK1 = (1 << TOIE1);
+}
+
+/* Duty mode always starts on a rising edge: the first half measured is the high time */
+static void icp_arm(void)
+{
+    uint8_t edge = (g_icp_mode == ICP_MODE_DUTY) ? (1 << ICES1) : g_icp_edge;
+
+    TCCR1B = (TCCR1B & ~(1 << ICES1)) | edge;
+    TIFR1 = (1 << ICF1);                        /* Edge change can set ICF1, clear it (page 119) */
+    g_icp_state = ICP_FIRST;
+    TIMSK1 |= (1 << ICIE1);
+}
+
+/*
+** periods: N periods per result (1 ~ ICP_MAX_PERIODS), 0 -> auto range
+*/
+void icp_start(uint8_t mode, uint16_t periods)
+{
+    if (periods > ICP_MAX_PERIODS)
+        periods = ICP_MAX_PERIODS;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        g_icp_mode = mode;
+        g_icp_periods = periods;
+        if (mode == ICP_MODE_DUTY)
+            g_icp_gate = 1;
+        else
+            g_icp_gate = periods ? periods : g_icp_auto;
+        g_icp_ready = 0;
+        icp_arm();
+    }
+}
+
+void icp_stop(void)
+{
+    TIMSK1 &= ~(1 << ICIE1);
+    g_icp_state = ICP_IDLE;
+}
+
+/*
+** Timer1 stopped and given back (clock gated if nobody else uses it)
+*/
+void icp_deinit(void)
+{
+    icp_stop();
+    TIMSK1 = 0;
+    TCCR1B = 0;
+    periph_release(PERIPH_TIM1);
+}
+
+/*
+** Copy the last result, 1 if there was a new one
+** In auto mode the next gate is sized from this result: N = gate time / period
+*/
+uint8_t icp_read(t_icp_result *result)
+{
+    uint8_t ready;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ready = g_icp_ready;
+        if (ready)
+        {
+            *result = g_icp_result;
+            g_icp_ready = 0;
+        }
+    }
+    if (!ready)
+        return 0;
+
+    if (g_icp_mode == ICP_MODE_PERIOD && g_icp_periods == 0 && result->ticks != 0)
+    {
+        uint32_t period = result->ticks / result->periods;
+        uint32_t gate = (clock_hz() / 1000UL) * ICP_GATE_MS;
+        uint32_t n = period ? gate / period : ICP_MAX_PERIODS;
+
+        if (n < 1)
+            n = 1;
+        if (n > ICP_MAX_PERIODS)
+            n = ICP_MAX_PERIODS;
+        g_icp_auto = (uint16_t)n;
+        g_icp_gate = g_icp_auto;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        icp_arm();
+    }
+    return 1;
+}
+
+/* f (mHz) = CPU clock * 1000 * N / ticks (the clock of now, clock_set() included) */
+uint32_t icp_freq_mhz(const t_icp_result *result)
+{
+    if (result->ticks == 0)
+        return 0;
+    return (uint32_t)(((uint64_t)clock_hz() * 1000ULL * result->periods + result->ticks / 2) / result->ticks);
+}
+
+uint16_t icp_duty_permille(const t_icp_result *result)
+{
+    if (result->ticks == 0)
+        return 0;
+    return (uint16_t)(((uint64_t)result->high * 1000ULL) / result->ticks);
+}
+
+ISR(TIMER1_OVF_vect)
+{
+    g_icp_ovf++;
+}
+
+/*
+** Timestamp of the captured edge
+** If the counter wrapped just before the capture, TOV1 is still pending (this ISR runs first):
+** a small ICR1 with TOV1 set belongs to the next overflow
+*/
+static inline uint32_t icp_timestamp(void)
+{
+    uint16_t icr = ICR1;
+    uint16_t ovf = g_icp_ovf;
+
+    if ((TIFR1 & (1 << TOV1)) && icr < 0x8000)
+        ovf++;
+    return ((uint32_t)ovf << 16) | icr;
+}
+
+static void icp_publish(uint32_t ticks, uint32_t high, uint16_t periods)
+{
+    g_icp_result.ticks = ticks;
+    g_icp_result.high = high;
+    g_icp_result.periods = periods;
+    g_icp_ready = 1;
+    TIMSK1 &= ~(1 << ICIE1);                    /* One result at a time, icp_read() re-arms */
+    g_icp_state = ICP_IDLE;
+}
+
+ISR(TIMER1_CAPT_vect)
+{
+    switch (g_icp_state)
+    {
+        case ICP_COUNT:                         /* Hot path: only count */
+            if (--g_icp_left == 0)
+                icp_publish(icp_timestamp() - g_icp_t0, 0, g_icp_gate);
+            break;
+
+        case ICP_FIRST:
+            g_icp_t0 = icp_timestamp();
+            if (g_icp_mode == ICP_MODE_DUTY)
+            {
+                TCCR1B ^= (1 << ICES1);         /* Wait for the other edge */
+                TIFR1 = (1 << ICF1);
+                g_icp_state = ICP_FALL;
+            }
+            else
+            {
+                g_icp_left = g_icp_gate;
+                g_icp_state = ICP_COUNT;
+            }
+            break;
+
+        case ICP_FALL:
+            g_icp_t1 = icp_timestamp();
+            TCCR1B ^= (1 << ICES1);
+            TIFR1 = (1 << ICF1);
+            g_icp_state = ICP_RISE;
+            break;
+
+        case ICP_RISE:
+            icp_publish(icp_timestamp() - g_icp_t0, g_icp_t1 - g_icp_t0, 1);
+            break;
+
+        default:
+            break;
+    }
+}
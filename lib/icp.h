@@ -0,0 +1,64 @@
+#ifndef ICP_H
+# define ICP_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+/*
+** Input capture measurement on Timer1 (ICP1 = PB0)
+**  - Timer1 runs free at clk/1 -> 1 tick = 62.5ns (page 118 16.6 Input Capture Unit)
+**  - TIMER1_OVF_vect extends the 16 bit counter to 32 bit (268 sec before wrap)
+**  - Every capture gives an exact 32 bit timestamp of the edge
+**
+** Two ways to measure
+**  - Low frequency : one period = timestamp(edge 1) - timestamp(edge 0), resolution 62.5ns
+**  - High frequency: the ISR only counts edges during a gate of N periods and
+**                    takes the timestamps of the first and last edge (gated, reciprocal counting)
+**                    -> f = N / (t_last - t_first), resolution 62.5ns / N
+**  - periods = 0 (auto): N is chosen after each result so the gate lasts about ICP_GATE_MS
+**
+** Duty mode: rising -> falling -> rising (edge select is switched in the ISR), always one period,
+** whatever edge icp_init() was given: .high is the high time
+**
+** Ticks are CPU clocks: icp_freq_mhz() and the auto gate use clock_hz() (clock.h), a result
+** measured across a clock_set() is wrong (read it and start again)
+**
+** Limits: each edge is one interrupt (~40 cycles in the counting path), so about 200kHz max
+**
+** icp.c owns Timer1 and defines TIMER1_OVF_vect: it cannot be linked with systime.c on Timer1
+** (the default, same vector: the link fails). With icp, systime goes on Timer2 (systime.c in
+** the SRC of the exercise, -DSYSTIME_TIMER=2)
+*/
+
+#ifndef ICP_GATE_MS
+# define ICP_GATE_MS 100
+#endif
+
+#define ICP_MAX_PERIODS 10000
+
+/* icp_init() flags */
+#define ICP_FALLING         0x00
+#define ICP_RISING          0x01    /* ICES1: capture on rising edge (page 142) */
+#define ICP_NOISE_CANCEL    0x02    /* ICNC1: 4 samples filter, adds 4 cycles of delay */
+
+/* icp_start() modes */
+#define ICP_MODE_PERIOD     0
+#define ICP_MODE_DUTY       1
+
+typedef struct s_icp_result
+{
+    uint32_t    ticks;      /* Length of the gate (N periods) in 62.5ns ticks */
+    uint32_t    high;       /* High time in ticks (duty mode only) */
+    uint16_t    periods;    /* N */
+}   t_icp_result;
+
+void        icp_init(uint8_t flags);
+void        icp_start(uint8_t mode, uint16_t periods);
+void        icp_stop(void);
+void        icp_deinit(void);
+uint8_t     icp_read(t_icp_result *result);
+uint32_t    icp_freq_mhz(const t_icp_result *result);
+uint16_t    icp_duty_permille(const t_icp_result *result);
+
+#endif
@@ -0,0 +1,200 @@
+#include "input.h"
+
+#if (INPUT_QUEUE_SIZE & (INPUT_QUEUE_SIZE - 1)) != 0
+# error "input: INPUT_QUEUE_SIZE must be a power of 2"
+#endif
+
+#define INPUT_QUEUE_MASK (INPUT_QUEUE_SIZE - 1)
+
+static t_input_event g_input_queue[INPUT_QUEUE_SIZE];
+static volatile uint8_t g_input_head = 0;       /* Written with interrupts off only (ISR, input_settle) */
+static volatile uint8_t g_input_tail = 0;       /* Written by main only */
+static volatile uint8_t g_input_dropped = 0;    /* Events lost because the queue was full */
+
+static uint8_t g_input_mask[3];                 /* Watched pins of each port */
+static uint8_t g_input_level[3];                /* Last reported level of each port */
+static uint8_t g_input_pending[3];              /* Pins with an edge dropped by the lockout */
+static uint16_t g_input_time[3][8];             /* Last accepted edge of each pin (1.024ms units) */
+
+static uint8_t input_read(uint8_t port)
+{
+    if (port == INPUT_PORTB)
+        return PINB;
+    if (port == INPUT_PORTC)
+        return PINC;
+    return PIND;
+}
+
+/*
+** PCICR bit n -> PCINTn_vect for port n (B = 0, C = 1, D = 2), page 73
+*/
+void input_watch(uint8_t port, uint8_t mask)
+{
+    uint8_t sreg = SREG;
+
+    cli();
+    g_input_mask[port] |= mask;
+    uint16_t now = (uint16_t)(micros() >> 10);
+
+    for (uint8_t pin = 0; pin < 8; pin++)       /* Out of lockout: the first edge counts */
+        if (mask & (1 << pin))
+            g_input_time[port][pin] = now - INPUT_LOCKOUT_MS;
+    g_input_level[port] = input_read(port);
+    if (port == INPUT_PORTB)
+        PCMSK0 |= mask;
+    else if (port == INPUT_PORTC)
+        PCMSK1 |= mask;
+    else
+        PCMSK2 |= mask;
+    PCIFR = (1 << port);                        /* Forget old changes (write 1 to clear) */
+    PCICR |= (1 << port);
+    SREG = sreg;
+}
+
+/*
+** Pins of changed out of their lockout, their edge time is now
+** The others are kept in g_input_pending: input_settle() reads them again later
+** 16 bit -> wraps after 67s, a late edge is at worst held until input_settle()
+*/
+static uint8_t input_accept(uint8_t port, uint8_t changed, uint16_t now)
+{
+    uint8_t accepted = 0;
+
+    for (uint8_t pin = 0; pin < 8; pin++)
+    {
+        if (!(changed & (1 << pin)))
+            continue;
+        if ((uint16_t)(now - g_input_time[port][pin]) >= INPUT_LOCKOUT_MS)
+        {
+            accepted |= (1 << pin);
+            g_input_time[port][pin] = now;
+        }
+    }
+    g_input_pending[port] = (g_input_pending[port] | changed) & ~accepted;
+    return accepted;
+}
+
+/* Interrupts off (ISR, or main with cli) */
+static void input_push(uint8_t port, uint8_t level, uint8_t accepted, uint32_t time)
+{
+    g_input_level[port] = (g_input_level[port] & ~accepted) | (level & accepted);
+
+    uint8_t head = g_input_head;
+    uint8_t next = (head + 1) & INPUT_QUEUE_MASK;
+
+    if (next == g_input_tail)                   /* Full: keep the old events */
+    {
+        g_input_dropped++;
+        return;
+    }
+    g_input_queue[head].time = time;
+    g_input_queue[head].port = port;
+    g_input_queue[head].changed = accepted;
+    g_input_queue[head].level = g_input_level[port];
+    g_input_head = next;                        /* Publish after the data is written */
+}
+
+static void input_isr(uint8_t port, uint8_t level)
+{
+    uint8_t changed = (level ^ g_input_level[port]) & g_input_mask[port];
+
+    if (!changed)
+        return;
+
+    uint32_t time = micros();
+    uint8_t accepted = input_accept(port, changed, (uint16_t)(time >> 10));   /* ~ms */
+
+    if (accepted)
+        input_push(port, level, accepted, time);
+}
+
+/*
+** Edges dropped by the lockout: once it is over, the pin is read again and a level which
+** differs from the last reported one gives an event (a tap shorter than the lockout,
+** a bounce ending on the other level)
+** Interrupts off, called by input_poll() / input_wait() (the systime overflow wakes idle)
+*/
+static void input_settle(void)
+{
+    uint32_t time = 0;
+
+    for (uint8_t port = 0; port < 3; port++)
+    {
+        if (!g_input_pending[port])
+            continue;
+        if (!time)
+            time = micros();
+
+        uint8_t level = input_read(port);
+        uint8_t changed = (level ^ g_input_level[port]) & g_input_pending[port];
+        uint8_t accepted;
+
+        g_input_pending[port] &= changed;       /* Back to the reported level: nothing to say */
+        accepted = input_accept(port, changed, (uint16_t)(time >> 10));
+        if (accepted)
+            input_push(port, level, accepted, time);
+    }
+}
+
+ISR(PCINT0_vect)
+{
+    input_isr(INPUT_PORTB, PINB);
+}
+
+ISR(PCINT1_vect)
+{
+    input_isr(INPUT_PORTC, PINC);
+}
+
+ISR(PCINT2_vect)
+{
+    input_isr(INPUT_PORTD, PIND);
+}
+
+/*
+** Take one event, 0 when the queue is empty (never blocks)
+*/
+uint8_t input_poll(t_input_event *event)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        input_settle();
+    }
+
+    uint8_t tail = g_input_tail;
+
+    if (tail == g_input_head)
+        return 0;
+    *event = g_input_queue[tail];
+    g_input_tail = (tail + 1) & INPUT_QUEUE_MASK;
+    return 1;
+}
+
+/*
+** Sleep until an event comes
+** The check and the sleep are done with interrupts off, "sei; sleep" then:
+** the instruction after sei always runs before any interrupt (page 14),
+** so an event coming between the check and the sleep still wakes us up
+*/
+void input_wait(t_input_event *event)
+{
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    input_settle();
+    while (g_input_head == g_input_tail)
+    {
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+        cli();
+        input_settle();
+    }
+    sei();
+    input_poll(event);
+}
+
+uint8_t input_dropped(void)
+{
+    return g_input_dropped;
+}
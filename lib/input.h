@@ -0,0 +1,55 @@
+#ifndef INPUT_H
+# define INPUT_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "systime.h"
+
+/*
+** Pin change input layer
+**  - Any pin of PORTB / PORTC / PORTD can be an event source (PCINT0 ~ PCINT23, page 73 13.2.4)
+**    not only the INT0 / INT1 pins
+**  - The pin change ISR timestamps the edge (micros()) and pushes an event in a queue
+**  - Queue: one producer (ISR) / one consumer (main), 8 bit indexes -> lock free
+**  - input_wait() sleeps in idle mode until an event is there (CPU stopped, timers and PWM keep running)
+**
+** Bounce: the first edge of a pin is reported at once, the next edges of the same pin
+** are ignored during INPUT_LOCKOUT_MS (contacts bounce for a few ms)
+** -> the pin is read again once the lockout is over (input_poll() / input_wait(), woken by the
+**    systime overflow), a level which differs from the last event gives one more event:
+**    a pulse shorter than the lockout is reported late, never lost half way
+**
+** Needs systime (Timer1, or Timer2 with SYSTIME_TIMER=2)
+*/
+
+#define INPUT_PORTB 0
+#define INPUT_PORTC 1
+#define INPUT_PORTD 2
+
+#ifndef INPUT_QUEUE_SIZE
+# define INPUT_QUEUE_SIZE 8     /* Power of 2 */
+#endif
+
+#ifndef INPUT_LOCKOUT_MS
+# define INPUT_LOCKOUT_MS 20
+#endif
+
+typedef struct s_input_event
+{
+    uint32_t    time;       /* micros() of the edge */
+    uint8_t     port;       /* INPUT_PORTB / C / D */
+    uint8_t     changed;    /* Pins which changed */
+    uint8_t     level;      /* PINx after the change */
+}   t_input_event;
+
+void    input_watch(uint8_t port, uint8_t mask);
+uint8_t input_poll(t_input_event *event);
+void    input_wait(t_input_event *event);
+uint8_t input_dropped(void);
+
+/* Pins of mask which went low / high with this event (switches are active low) */
+#define INPUT_FELL(ev, mask)    ((ev)->changed & ~(ev)->level & (mask))
+#define INPUT_ROSE(ev, mask)    ((ev)->changed & (ev)->level & (mask))
+
+#endif
@@ -0,0 +1,476 @@
+#include "kvstore.h"
+#include "eeprom.h"
+#include <util/crc16.h>
+#include <util/atomic.h>
+#include <string.h>
+
+#define KV_PAGE_HEADER      3           /* version, sequence low, sequence high */
+#define KV_RECORD_HEADER    3           /* version, key length, value length */
+#define KV_RECORD_SIZE(k, v) (KV_RECORD_HEADER + (k) + (v) + 2)
+#define KV_PAGE_ADDR(p)     (KV_EEPROM_START + (uint16_t)(p) * KV_PAGE_SIZE)
+
+#define KV_RING_SIZE        256         /* uint8_t index wraps by itself */
+#define KV_SEGMENTS         8
+
+/*
+** A write step is one page at most: it always fits in an empty queue
+** The live records (largest size) fit in all the pages but one, with the room
+** lost at the end of each page: there is always a page to open
+*/
+#define KV_RECORD_MAX       KV_RECORD_SIZE(KV_KEY_SIZE - 1, KV_VALUE_SIZE - 1)
+#define KV_PAGE_RECORDS     ((KV_PAGE_SIZE - KV_PAGE_HEADER) / KV_RECORD_MAX)
+
+#if KV_PAGE_SIZE > KV_RING_SIZE - 1
+# error "kvstore: a page must fit in the write queue"
+#endif
+#if (KV_ENTRIES + KV_PAGE_RECORDS - 1) / KV_PAGE_RECORDS > KV_PAGES - 1
+# error "kvstore: KV_ENTRIES records of the largest size must fit in KV_PAGES - 1 pages"
+#endif
+
+/*
+** RAM cache, key[0] == '\0' -> free
+** page: where the last record of the key is (rewritten when the ring comes back to it)
+*/
+typedef struct s_kv_entry
+{
+    char        key[KV_KEY_SIZE];
+    char        value[KV_VALUE_SIZE];
+    uint8_t     page;
+}   t_kv_entry;
+
+static t_kv_entry g_kv[KV_ENTRIES];
+
+/* Write position */
+static uint8_t g_kv_page = KV_PAGES - 1;
+static uint16_t g_kv_seq = 0xFFFF;
+static uint8_t g_kv_used = KV_PAGE_SIZE;    /* Bytes used in g_kv_page (full -> next write opens a page) */
+
+/*
+** Write queue
+**  - ring: data bytes, segment: start address + length of a run of bytes
+**  - kv_set() stages everything after the tails, then publishes it at once
+**  - a published segment is only changed by the ISR
+*/
+typedef struct s_kv_segment
+{
+    uint16_t    addr;
+    uint8_t     len;
+}   t_kv_segment;
+
+static uint8_t g_kv_ring[KV_RING_SIZE];
+static volatile uint8_t g_kv_ring_head = 0;
+static uint8_t g_kv_ring_tail = 0;
+static t_kv_segment g_kv_seg[KV_SEGMENTS];
+static volatile uint8_t g_kv_seg_head = 0;
+static volatile uint8_t g_kv_seg_tail = 0;
+
+static uint8_t g_kv_stage_ring;
+static uint8_t g_kv_stage_seg;
+static uint16_t g_kv_stage_addr;
+
+/*
+** Next byte from EE_READY_vect (eeprom.c), EEPE is clear when this runs (page 30)
+** Bytes already right in the EEPROM are skipped in the same interrupt
+** 1 -> a write started, 0 -> queue empty
+*/
+uint8_t kv_ready(void)
+{
+    while (g_kv_seg_head != g_kv_seg_tail)
+    {
+        t_kv_segment *seg = &g_kv_seg[g_kv_seg_head];
+
+        if (seg->len == 0)
+        {
+            g_kv_seg_head = (g_kv_seg_head + 1) & (KV_SEGMENTS - 1);
+            continue;
+        }
+        uint8_t data = g_kv_ring[g_kv_ring_head++];
+
+        EEAR = seg->addr++;
+        seg->len--;
+        EECR |= (1 << EERE);
+        if (EEDR != data)
+        {
+            EEDR = data;
+            EECR |= (1 << EEMPE);               /* EEPE within 4 cycles (page 30) */
+            EECR |= (1 << EEPE);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void kv_stage(uint16_t addr, uint8_t data)
+{
+    if (addr != g_kv_stage_addr)                /* Not contiguous: new segment */
+    {
+        g_kv_stage_seg = (g_kv_stage_seg + 1) & (KV_SEGMENTS - 1);
+        g_kv_seg[g_kv_stage_seg].addr = addr;
+        g_kv_seg[g_kv_stage_seg].len = 0;
+    }
+    g_kv_seg[g_kv_stage_seg].len++;
+    g_kv_ring[g_kv_stage_ring++] = data;
+    g_kv_stage_addr = addr + 1;
+}
+
+/* Boot reads only (no write queued yet): EEPE is clear */
+static void kv_read(uint16_t addr, void *dst, uint8_t len)
+{
+    uint8_t *out = dst;
+
+    while (len--)
+    {
+        EEAR = addr++;
+        EECR |= (1 << EERE);                    /* CPU halted 4 cycles, data in EEDR (page 30) */
+        *out++ = EEDR;
+    }
+}
+
+static uint16_t kv_crc_seed(uint16_t seq)
+{
+    uint16_t crc = 0xFFFF;
+
+    crc = _crc_ccitt_update(crc, seq & 0xFF);
+    return _crc_ccitt_update(crc, seq >> 8);
+}
+
+/* Record of (key, value) at the write position */
+static void kv_stage_record(const char *key, const char *value)
+{
+    uint8_t klen = strlen(key);
+    uint8_t vlen = strlen(value);
+    uint16_t addr = KV_PAGE_ADDR(g_kv_page) + g_kv_used;
+    uint16_t crc = kv_crc_seed(g_kv_seq);
+    uint8_t header[KV_RECORD_HEADER] = { KV_VERSION, klen, vlen };
+
+    for (uint8_t i = 0; i < KV_RECORD_HEADER; i++)
+    {
+        crc = _crc_ccitt_update(crc, header[i]);
+        kv_stage(addr++, header[i]);
+    }
+    for (uint8_t i = 0; i < klen; i++)
+    {
+        crc = _crc_ccitt_update(crc, key[i]);
+        kv_stage(addr++, key[i]);
+    }
+    for (uint8_t i = 0; i < vlen; i++)
+    {
+        crc = _crc_ccitt_update(crc, value[i]);
+        kv_stage(addr++, value[i]);
+    }
+    kv_stage(addr++, crc & 0xFF);
+    kv_stage(addr, crc >> 8);
+    g_kv_used += KV_RECORD_SIZE(klen, vlen);
+}
+
+/* Bytes of the live records whose last copy is in page */
+static uint8_t kv_live_bytes(uint8_t page)
+{
+    uint8_t bytes = 0;
+
+    for (uint8_t i = 0; i < KV_ENTRIES; i++)
+    {
+        if (g_kv[i].key[0] && g_kv[i].page == page)
+            bytes += KV_RECORD_SIZE(strlen(g_kv[i].key), strlen(g_kv[i].value));
+    }
+    return bytes;
+}
+
+/*
+** Live records of page written again at the write position (they always fit: a page
+** holds no more than what was moved out of one page, see kv_stage_page)
+*/
+static void kv_stage_move(uint8_t page)
+{
+    for (uint8_t i = 0; i < KV_ENTRIES; i++)
+    {
+        if (g_kv[i].key[0] && g_kv[i].page == page
+            && g_kv_used + KV_RECORD_SIZE(strlen(g_kv[i].key), strlen(g_kv[i].value)) <= KV_PAGE_SIZE)
+        {
+            kv_stage_record(g_kv[i].key, g_kv[i].value);
+            g_kv[i].page = g_kv_page;
+        }
+    }
+}
+
+/*
+** Open the next page of the ring, it holds no live record (moved out at the step before),
+** then move the live records of the page after it: the oldest, opened next time
+** Until that next opening they are in both pages, a reset in the middle of the move
+** loses nothing (kv_init() reads the oldest page first, kv_write() finishes the move)
+*/
+static void kv_stage_page(void)
+{
+    uint16_t addr;
+
+    g_kv_page = (g_kv_page + 1) % KV_PAGES;
+    g_kv_seq++;
+    g_kv_used = KV_PAGE_HEADER;
+    addr = KV_PAGE_ADDR(g_kv_page);
+    kv_stage(addr, KV_VERSION);
+    kv_stage(addr + 1, g_kv_seq & 0xFF);
+    kv_stage(addr + 2, g_kv_seq >> 8);
+    kv_stage_move((g_kv_page + 1) % KV_PAGES);
+}
+
+/* Room in the queue for one step (bytes, one segment: a step is contiguous) */
+static uint8_t kv_room(uint8_t bytes)
+{
+    uint8_t ring_free;
+    uint8_t seg_free;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ring_free = (KV_RING_SIZE - 1) - (uint8_t)(g_kv_ring_tail - g_kv_ring_head);
+        seg_free = (KV_SEGMENTS - 1) - ((g_kv_seg_tail - g_kv_seg_head) & (KV_SEGMENTS - 1));
+    }
+    return bytes <= ring_free && seg_free;
+}
+
+static void kv_stage_begin(void)
+{
+    g_kv_stage_ring = g_kv_ring_tail;
+    g_kv_stage_seg = (g_kv_seg_tail - 1) & (KV_SEGMENTS - 1);   /* First byte opens the segment at the tail */
+    g_kv_stage_addr = 0xFFFF;
+}
+
+static void kv_stage_end(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        g_kv_ring_tail = g_kv_stage_ring;
+        g_kv_seg_tail = (g_kv_stage_seg + 1) & (KV_SEGMENTS - 1);
+        eeprom_ready();
+    }
+}
+
+/*
+** Queue the record of entry (value "" -> delete)
+** Steps of one page at most, each one queued whole or not at all: a step which does not
+** fit in the queue now -> KV_ERR_BUSY, the steps before it stay (a retry goes on from there)
+*/
+static uint8_t kv_write(t_kv_entry *entry, const char *key, const char *value)
+{
+    uint8_t size = KV_RECORD_SIZE(strlen(key), strlen(value));
+    uint8_t next = (g_kv_page + 1) % KV_PAGES;
+    uint8_t live = kv_live_bytes(next);
+
+    if (live)                                   /* Reset in the middle of a move: finish it */
+    {
+        if (!kv_room(live))
+            return KV_ERR_BUSY;
+        kv_stage_begin();
+        kv_stage_move(next);
+        kv_stage_end();
+    }
+    for (uint8_t steps = 0; g_kv_used + size > KV_PAGE_SIZE; steps++)
+    {
+        if (steps == KV_PAGES)                  /* Every page full of live records */
+            return KV_ERR_SPACE;
+        if (!kv_room(KV_PAGE_HEADER + kv_live_bytes((g_kv_page + 2) % KV_PAGES)))
+            return KV_ERR_BUSY;
+        kv_stage_begin();
+        kv_stage_page();
+        kv_stage_end();
+    }
+    if (!kv_room(size))
+        return KV_ERR_BUSY;
+    kv_stage_begin();
+    if (entry)
+        entry->page = g_kv_page;
+    kv_stage_record(key, value);
+    kv_stage_end();
+    return KV_OK;
+}
+
+static t_kv_entry *kv_find(const char *key)
+{
+    for (uint8_t i = 0; i < KV_ENTRIES; i++)
+    {
+        if (g_kv[i].key[0] && strcmp(g_kv[i].key, key) == 0)
+            return &g_kv[i];
+    }
+    return 0;
+}
+
+static t_kv_entry *kv_free_entry(void)
+{
+    for (uint8_t i = 0; i < KV_ENTRIES; i++)
+    {
+        if (!g_kv[i].key[0])
+            return &g_kv[i];
+    }
+    return 0;
+}
+
+/*
+** Record at addr in page, checked against the page sequence
+** Returns its size (0 -> end of the page) and applies it to the cache
+*/
+static uint8_t kv_load_record(uint8_t page, uint16_t seq, uint8_t offset)
+{
+    uint16_t addr = KV_PAGE_ADDR(page) + offset;
+    uint8_t header[KV_RECORD_HEADER];
+    char key[KV_KEY_SIZE];
+    char value[KV_VALUE_SIZE];
+    uint16_t crc = kv_crc_seed(seq);
+    uint16_t stored;
+
+    if (offset + KV_RECORD_SIZE(1, 0) > KV_PAGE_SIZE)
+        return 0;
+    kv_read(addr, header, KV_RECORD_HEADER);
+    if (header[0] != KV_VERSION || header[1] == 0 || header[1] >= KV_KEY_SIZE || header[2] >= KV_VALUE_SIZE
+        || offset + KV_RECORD_SIZE(header[1], header[2]) > KV_PAGE_SIZE)
+        return 0;
+    addr += KV_RECORD_HEADER;
+    kv_read(addr, key, header[1]);
+    kv_read(addr + header[1], value, header[2]);
+    kv_read(addr + header[1] + header[2], &stored, 2);     /* Little endian, as written */
+
+    for (uint8_t i = 0; i < KV_RECORD_HEADER; i++)
+        crc = _crc_ccitt_update(crc, header[i]);
+    for (uint8_t i = 0; i < header[1]; i++)
+        crc = _crc_ccitt_update(crc, key[i]);
+    for (uint8_t i = 0; i < header[2]; i++)
+        crc = _crc_ccitt_update(crc, value[i]);
+    if (crc != stored)
+        return 0;
+    key[header[1]] = '\0';
+    value[header[2]] = '\0';
+
+    t_kv_entry *entry = kv_find(key);
+
+    if (header[2] == 0)                         /* Deleted */
+    {
+        if (entry)
+            entry->key[0] = '\0';
+    }
+    else if (entry || (entry = kv_free_entry()))
+    {
+        strcpy(entry->key, key);
+        strcpy(entry->value, value);
+        entry->page = page;
+    }
+    return KV_RECORD_SIZE(header[1], header[2]);
+}
+
+/*
+** One pass: page headers, then every record from the oldest page to the newest
+*/
+void kv_init(void)
+{
+    uint16_t seq[KV_PAGES];
+    uint8_t valid = 0;                          /* Bit per page */
+    uint8_t newest = 0;
+
+    for (uint8_t i = 0; i < KV_ENTRIES; i++)
+        g_kv[i].key[0] = '\0';
+    g_kv_page = KV_PAGES - 1;
+    g_kv_seq = 0xFFFF;
+    g_kv_used = KV_PAGE_SIZE;
+    g_kv_ring_head = g_kv_ring_tail = 0;
+    g_kv_seg_head = g_kv_seg_tail = 0;
+
+    for (uint8_t page = 0; page < KV_PAGES; page++)
+    {
+        uint8_t header[KV_PAGE_HEADER];
+
+        kv_read(KV_PAGE_ADDR(page), header, KV_PAGE_HEADER);
+        if (header[0] != KV_VERSION)
+            continue;
+        seq[page] = header[1] | (header[2] << 8);
+        if (!valid || (int16_t)(seq[page] - seq[newest]) > 0)
+            newest = page;
+        valid |= (1 << page);
+    }
+    if (!valid)                                 /* Blank EEPROM: first write opens page 0 */
+        return;
+
+    /* The ring is written in page order: oldest = the page after the newest */
+    for (uint8_t n = 1; n <= KV_PAGES; n++)
+    {
+        uint8_t page = (newest + n) % KV_PAGES;
+        uint8_t offset = KV_PAGE_HEADER;
+        uint8_t size;
+
+        if (!(valid & (1 << page)))
+            continue;
+        while ((size = kv_load_record(page, seq[page], offset)))
+            offset += size;
+        if (page == newest)
+        {
+            g_kv_page = page;
+            g_kv_seq = seq[page];
+            g_kv_used = offset;                 /* A torn last record is written over */
+        }
+    }
+}
+
+/* Value in the cache, 0 -> not set */
+const char *kv_get(const char *key)
+{
+    t_kv_entry *entry = kv_find(key);
+
+    return entry ? entry->value : 0;
+}
+
+uint8_t kv_set(const char *key, const char *value)
+{
+    uint8_t klen = strlen(key);
+    uint8_t vlen = strlen(value);
+    t_kv_entry *entry;
+
+    if (klen == 0 || klen >= KV_KEY_SIZE || vlen == 0 || vlen >= KV_VALUE_SIZE)
+        return KV_ERR_SIZE;
+    entry = kv_find(key);
+    if (entry && strcmp(entry->value, value) == 0)
+        return KV_OK;                           /* Same value: nothing to write */
+    if (!entry)
+    {
+        if (!(entry = kv_free_entry()))
+            return KV_ERR_FULL;
+        entry->key[0] = '\0';                   /* Stays free if the write is refused */
+    }
+
+    uint8_t status = kv_write(entry, key, value);
+
+    if (status == KV_OK)
+    {
+        strcpy(entry->key, key);
+        strcpy(entry->value, value);
+    }
+    return status;
+}
+
+uint8_t kv_del(const char *key)
+{
+    t_kv_entry *entry = kv_find(key);
+    uint8_t status;
+
+    if (!entry)
+        return KV_OK;
+    status = kv_write(entry, key, "");
+    if (status == KV_OK)
+        entry->key[0] = '\0';
+    return status;
+}
+
+/* Walk the cache: index 0 ~ KV_ENTRIES - 1, 0 for a free entry */
+const char *kv_key(uint8_t index)
+{
+    if (index >= KV_ENTRIES || !g_kv[index].key[0])
+        return 0;
+    return g_kv[index].key;
+}
+
+const char *kv_value(uint8_t index)
+{
+    if (index >= KV_ENTRIES || !g_kv[index].key[0])
+        return 0;
+    return g_kv[index].value;
+}
+
+uint8_t kv_busy(void)
+{
+    return g_kv_seg_head != g_kv_seg_tail;
+}
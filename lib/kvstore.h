@@ -0,0 +1,70 @@
+#ifndef KVSTORE_H
+# define KVSTORE_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*
+** Key / value store in EEPROM (config, credentials, calibration)
+**
+** Layout: KV_EEPROM_SIZE bytes from KV_EEPROM_START, cut in pages written as a ring (log)
+**  - page   : version, sequence (16 bit), then records
+**  - record : version, key length, value length, key, value, CRC16 (CCITT)
+**             the CRC starts with the sequence of its page: records left over from an
+**             older round of the same page fail the check, so pages are never erased
+**  - value length 0 = key deleted
+**
+** Wear leveling: records are only appended, the ring goes through every page in turn
+**  - the page after the write page holds no live record (spare): opening it only loses
+**    garbage, then the live records of the oldest page (known from the RAM cache) are
+**    written again in it, so the oldest page becomes the next spare
+**  - a reset in the middle of that move loses nothing, the records are still in the oldest
+**    page (the next write finishes the move)
+**  - 4 pages of 128 bytes, 8 entries max -> 3 pages hold them all, one is spare
+**  - a byte with the same value already is not written again (no wear, no 3.4ms)
+**
+** Boot: kv_init() reads the pages once, oldest to newest, into the RAM cache
+** (last record of a key wins), a record with a bad CRC ends its page (power loss)
+**
+** Writes are asynchronous: kv_set() updates the cache and queues the bytes, one page at most
+** per step (opening a page, then the record),
+** EE_READY_vect writes one byte per interrupt (3.4ms each, page 29 8.4.3), through kv_ready()
+** (eeprom.c: the interrupt is shared with elog.c)
+** kv_busy() -> bytes still queued (wait for it before a power down or a reset)
+*/
+
+#ifndef KV_EEPROM_START
+# define KV_EEPROM_START    0
+#endif
+#ifndef KV_EEPROM_SIZE
+# define KV_EEPROM_SIZE     512         /* The other half of the 1KB is elog's (elog.h) */
+#endif
+
+#define KV_PAGE_SIZE        128
+#define KV_PAGES            (KV_EEPROM_SIZE / KV_PAGE_SIZE)
+#define KV_VERSION          0x01
+
+#define KV_ENTRIES          8
+#define KV_KEY_SIZE         12          /* 11 chars + '\0' */
+#define KV_VALUE_SIZE       20          /* 19 chars + '\0' */
+
+#if KV_EEPROM_SIZE % KV_PAGE_SIZE || KV_PAGES < 4 || KV_EEPROM_START + KV_EEPROM_SIZE > E2END + 1
+# error "kvstore: KV_EEPROM_SIZE must be 4 pages of 128 bytes or more, inside the EEPROM"
+#endif
+
+#define KV_OK               0
+#define KV_ERR_SIZE         1           /* Key empty / too long, value too long */
+#define KV_ERR_FULL         2           /* No free entry */
+#define KV_ERR_BUSY         3           /* Write queue full, try again later */
+#define KV_ERR_SPACE        4           /* No page to open (never with the sizes above) */
+
+void        kv_init(void);
+const char  *kv_get(const char *key);
+uint8_t     kv_set(const char *key, const char *value);
+uint8_t     kv_del(const char *key);
+const char  *kv_key(uint8_t index);
+const char  *kv_value(uint8_t index);
+uint8_t     kv_busy(void);
+uint8_t     kv_ready(void);
+
+#endif
@@ -0,0 +1,96 @@
+#include "load.h"
+#include <util/atomic.h>
+
+volatile uint8_t  g_load_current = LOAD_IDLE;
+volatile uint16_t g_load_stamp = 0;
+volatile uint32_t g_load_cycles[LOAD_ACCOUNTS];    /* Slot being filled, cycles */
+
+static uint16_t g_load_slot[LOAD_SLOTS][LOAD_ACCOUNTS];    /* Closed slots, 64 cycles */
+static uint32_t g_load_window[LOAD_ACCOUNTS];              /* Sum of the closed slots */
+static uint8_t  g_load_oldest = 0;
+static uint8_t  g_load_ovf = 0;
+static uint8_t  g_load_cost = 0;
+
+/*
+** After systime_init() (Timer1 running at clk/1)
+** Cost of one switch: two of them back to back, interrupts off
+*/
+void load_init(void)
+{
+    uint16_t start;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        g_load_stamp = TCNT1;
+        g_load_current = LOAD_IDLE;
+        start = TCNT1;
+        load_switch(LOAD_IDLE);
+        load_switch(LOAD_IDLE);
+        g_load_cost = (uint16_t)(TCNT1 - start) / 2;
+    }
+}
+
+/*
+** systime overflow interrupt (weak call, every 65536 cycles)
+** Closing a slot: the oldest one leaves the window, the one just filled comes in,
+** the cycles under 64 stay in the account for the next slot
+*/
+void load_overflow(void)
+{
+    load_switch(g_load_current);
+    if (++g_load_ovf < LOAD_SLOT_OVF)
+        return;
+    g_load_ovf = 0;
+
+    for (uint8_t id = 0; id < LOAD_ACCOUNTS; id++)
+    {
+        uint16_t units = g_load_cycles[id] >> LOAD_SLOT_SHIFT;
+
+        g_load_cycles[id] &= (1 << LOAD_SLOT_SHIFT) - 1;
+        g_load_window[id] += units - g_load_slot[g_load_oldest][id];
+        g_load_slot[g_load_oldest][id] = units;
+    }
+    g_load_oldest = (g_load_oldest + 1) % LOAD_SLOTS;
+}
+
+/* Window of one account and of all of them (64 cycles), read together */
+static uint32_t load_window(uint8_t id, uint32_t *total)
+{
+    uint32_t part;
+
+    *total = 0;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (uint8_t i = 0; i < LOAD_ACCOUNTS; i++)
+            *total += g_load_window[i];
+        part = g_load_window[id];
+    }
+    return part;
+}
+
+/* Share of the window of one account, 0 ~ 1000 (0 until the first slot is closed) */
+uint16_t load_permille(uint8_t id)
+{
+    uint32_t total;
+    uint32_t part = load_window(id, &total);
+
+    if (total == 0)
+        return 0;
+    return (part * 1000 + total / 2) / total;
+}
+
+/* Everything but idle */
+uint16_t load_busy_permille(void)
+{
+    uint32_t total;
+    uint32_t idle = load_window(LOAD_IDLE, &total);
+
+    if (total == 0)
+        return 0;
+    return ((total - idle) * 1000 + total / 2) / total;
+}
+
+uint8_t load_switch_cycles(void)
+{
+    return g_load_cost;
+}
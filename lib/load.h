@@ -0,0 +1,76 @@
+#ifndef LOAD_H
+# define LOAD_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*
+** CPU load: every cycle is charged to one account, over a sliding window of ~1s
+**  - Account LOAD_IDLE (0) is main when it has nothing to do (polling loop, sleep)
+**  - LOAD_ENTER(id) at the top of an ISR / around a task in main charges the cycles
+**    so far to the running account and switches to id, LOAD_EXIT() switches back:
+**    nested time is only counted once (exclusive), the accounts add up to 100%
+**  - Built in with -DLOAD=1 (make LOAD=1), the macros are empty otherwise
+**
+** Time: TCNT1, Timer1 at clk/1 from systime built with SYSTIME_CLK1 (one count = one cycle)
+**  - a switch takes the 16 bit difference, so no span may pass 65536 cycles: systime calls
+**    load_overflow() at every overflow (4.096ms), which charges the running account
+**  - every LOAD_SLOT_OVF overflows (131ms) the slot is closed, the window is the last
+**    LOAD_SLOTS slots (1.05s), kept as a running sum (no division in the interrupt)
+**
+** Cost: ~35 cycles per switch (interrupts off), two per instrumented ISR,
+** load_switch_cycles() gives the one measured by load_init()
+*/
+
+#ifndef LOAD
+# define LOAD 0
+#endif
+
+#define LOAD_ACCOUNTS   4           /* Ids 0 ~ 3 (load.c is built with this one) */
+#define LOAD_IDLE       0
+#define LOAD_SLOTS      8
+#define LOAD_SLOT_OVF   32          /* Overflows of 65536 cycles per slot */
+#define LOAD_SLOT_SHIFT 6           /* Slot sums in units of 64 cycles (< 32768) */
+
+extern volatile uint8_t  g_load_current;
+extern volatile uint16_t g_load_stamp;
+extern volatile uint32_t g_load_cycles[LOAD_ACCOUNTS];
+
+void        load_init(void);
+void        load_overflow(void);
+uint16_t    load_permille(uint8_t id);
+uint16_t    load_busy_permille(void);
+uint8_t     load_switch_cycles(void);
+
+#if LOAD && defined(SYSTIME_H) && (SYSTIME_TIMER != 1 || !SYSTIME_CLK1)
+# error "load: needs systime on Timer1 at clk/1, build it with -DSYSTIME_CLK1=1"
+#endif
+
+/* Charge the running account up to now and run id, the previous one is returned */
+static inline __attribute__((always_inline)) uint8_t load_switch(uint8_t id)
+{
+    uint8_t sreg = SREG;
+
+    cli();
+    uint16_t now = TCNT1;
+    uint8_t prev = g_load_current;
+
+    g_load_cycles[prev] += (uint16_t)(now - g_load_stamp);
+    g_load_stamp = now;
+    g_load_current = id;
+    __asm__ __volatile__ ("" ::: "memory");
+    SREG = sreg;
+    return prev;
+}
+
+#if LOAD
+# define LOAD_ENTER(id)     uint8_t load_prev_ = load_switch(id)
+# define LOAD_EXIT()        load_switch(load_prev_)
+# define LOAD_INIT()        load_init()
+#else
+# define LOAD_ENTER(id)     ((void)0)
+# define LOAD_EXIT()        ((void)0)
+# define LOAD_INIT()        ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,38 @@
+#include "mem.h"
+#include <stdint.h>
+
+/* Linker script symbols (avr-libc, avr5.x) */
+extern uint8_t __data_start;
+extern uint8_t __data_end;
+extern uint8_t __bss_start;
+extern uint8_t __heap_start;
+
+#define MEM_SP  ((uint8_t *)(uintptr_t)SP)
+
+/*
+** Runs before main, after the stack pointer is set (.init2) and before .data / .bss are
+** set up (.init4, below __heap_start, not painted): no RAM, no call
+** The stack is still empty: everything under SP is painted
+*/
+void mem_paint(void) __attribute__((naked, used, section(".init3")));
+void mem_paint(void)
+{
+    uint8_t *p = &__heap_start;
+
+    while (p < MEM_SP)
+        *p++ = MEM_CANARY;
+}
+
+void mem_stats(t_mem_stats *stats)
+{
+    const uint8_t *p = &__heap_start;
+
+    while (p < MEM_SP && *p == MEM_CANARY)
+        p++;
+
+    stats->data = &__data_end - &__data_start;
+    stats->bss = &__heap_start - &__bss_start;
+    stats->gap = p - &__heap_start;
+    stats->stack_peak = (uint8_t *)RAMEND - p + 1;
+    stats->stack_free = MEM_SP - &__heap_start;
+}
@@ -0,0 +1,34 @@
+#ifndef MEM_H
+# define MEM_H
+
+#include <avr/io.h>
+
+/*
+** SRAM use (2KB, page 18 8.3 SRAM Data Memory)
+**
+**  0x100  .data | .bss | .noinit | (heap: no malloc here) ... gap ... stack <- RAMEND 0x8FF
+**
+**  - At startup (.init3, before main) the space between the end of .noinit and the
+**    stack is painted with MEM_CANARY
+**  - mem_stats() counts the painted bytes still intact from the bottom: the gap the
+**    stack never reached, the stack high water mark is the rest
+**  - The paint is only linked in a program which calls mem_stats() (archive member)
+**
+** A stack byte which happens to hold MEM_CANARY at the edge makes the gap look one
+** or two bytes bigger: keep a margin (test/sim fails under STACK_MARGIN bytes)
+*/
+
+#define MEM_CANARY  0xC5
+
+typedef struct s_mem_stats
+{
+    uint16_t    data;           /* Initialized globals, strings not in PROGMEM */
+    uint16_t    bss;            /* Zeroed globals (+ .noinit) */
+    uint16_t    stack_peak;     /* Deepest stack since reset, bytes */
+    uint16_t    gap;            /* Never touched, between .bss and the stack peak */
+    uint16_t    stack_free;     /* Now: between .bss and the stack pointer */
+}   t_mem_stats;
+
+void    mem_stats(t_mem_stats *stats);
+
+#endif
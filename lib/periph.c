@@ -0,0 +1,63 @@
+#include "periph.h"
+#include <util/atomic.h>
+
+static uint8_t g_periph_users[8];       /* Users of each PRR bit */
+static uint8_t g_periph_adc_on = 0;     /* ADEN before the ADC was stopped */
+
+/*
+** Runs before main (and before .data / .bss are set up): no RAM, no call
+*/
+void periph_gate_all(void) __attribute__((naked, used, section(".init3")));
+void periph_gate_all(void)
+{
+    PRR = PERIPH_ALL;
+}
+
+/*
+** periph: one or more PERIPH_ bits
+*/
+void periph_claim(uint8_t periph)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            if (!(periph & (1 << bit) & PERIPH_ALL))
+                continue;
+            if (g_periph_users[bit]++ != 0)
+                continue;
+
+            PRR &= ~(1 << bit);                         /* Clock on */
+            if ((1 << bit) == PERIPH_ADC && g_periph_adc_on)
+                ADCSRA |= (1 << ADEN);                  /* Back as it was */
+        }
+    }
+}
+
+void periph_release(uint8_t periph)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            if (!(periph & (1 << bit) & PERIPH_ALL) || g_periph_users[bit] == 0)
+                continue;
+            if (--g_periph_users[bit] != 0)
+                continue;
+
+            if ((1 << bit) == PERIPH_ADC)
+            {
+                /* ADC must be disabled before PRADC is set (page 55) */
+                g_periph_adc_on = (ADCSRA & (1 << ADEN)) != 0;
+                ADCSRA &= ~(1 << ADEN);
+            }
+            PRR |= (1 << bit);                          /* Clock off */
+        }
+    }
+}
+
+/* Modules with their clock on (PERIPH_ bits) */
+uint8_t periph_running(void)
+{
+    return ~PRR & PERIPH_ALL;
+}
@@ -0,0 +1,36 @@
+#ifndef PERIPH_H
+# define PERIPH_H
+
+#include <avr/io.h>
+
+/*
+** Peripheral ownership and clock gating (PRR, page 54 9.11.3)
+**  - At startup (.init3, before main) every module of PRR is stopped
+**  - A driver claims its module in its init and releases it in its deinit
+**  - First claim -> clock on, last release -> clock off (users are counted)
+**  - ADC: ADEN is cleared before the clock is stopped and set back on the next claim
+**
+** Claim before touching the registers of the module: a stopped module keeps its state
+** but its registers cannot be written
+** USART: set it up again (uart_init) after its clock was stopped (page 55 PRUSART0)
+**
+** Every exercise links periph.c (-Wl,--undefined=periph_gate_all in its Makefile), even with no
+** driver calling it: a program must claim everything it uses, drivers and its own registers
+*/
+
+#define PERIPH_ADC      (1 << PRADC)
+#define PERIPH_USART0   (1 << PRUSART0)
+#define PERIPH_SPI      (1 << PRSPI)
+#define PERIPH_TIM1     (1 << PRTIM1)
+#define PERIPH_TIM0     (1 << PRTIM0)
+#define PERIPH_TIM2     (1 << PRTIM2)
+#define PERIPH_TWI      (1 << PRTWI)
+
+#define PERIPH_ALL      (PERIPH_ADC | PERIPH_USART0 | PERIPH_SPI | PERIPH_TIM1 | \
+                         PERIPH_TIM0 | PERIPH_TIM2 | PERIPH_TWI)
+
+void    periph_claim(uint8_t periph);
+void    periph_release(uint8_t periph);
+uint8_t periph_running(void);
+
+#endif
@@ -0,0 +1,179 @@
+#include "power.h"
+#include <util/atomic.h>
+
+#ifdef POWER_STATS_SYSTIME
+# include "systime.h"
+#endif
+
+static const uint8_t g_power_sleep_mode[POWER_MODES] =
+{
+    SLEEP_MODE_IDLE,
+    SLEEP_MODE_PWR_SAVE,
+    SLEEP_MODE_PWR_DOWN,
+};
+
+static uint32_t g_power_count[POWER_MODES];
+static uint32_t g_power_us[POWER_MODES];
+#ifdef POWER_STATS_SYSTIME
+static uint32_t g_power_start;
+#endif
+
+#define TIMER_CLOCKED(tccrb) ((tccrb) & ((1 << CS02) | (1 << CS01) | (1 << CS00)))
+
+/* INTn enabled on an edge / any change: needs the I/O clock (page 71 12.1), only a low level wakes from power down */
+#define INT_EDGE(n) ((EIMSK & (1 << INT##n)) && (EICRA & (3 << ISC##n##0)))
+
+/*
+** Deepest mode which does not stop a running peripheral
+**  - USART: receiver needs the I/O clock, a byte still in the transmitter too: in the data
+**    register (UDRE0 clear) or in the shift register (TXC0 clear, uart_tx() clears it before
+**    each byte; a transmitter which never sent anything also keeps idle)
+**  - Timer0 / Timer1: always on the I/O clock
+**  - INT0 / INT1 on an edge or any change: I/O clock
+**  - Timer2: asynchronous (AS2) keeps counting in power save, else I/O clock
+**  - ADC: only while converting (ADSC)
+**  - TWI idle, pin change, INT0/1 low level, watchdog: wake from power down
+*/
+uint8_t power_mode(void)
+{
+    if (UCSR0B & (1 << RXEN0))
+        return POWER_IDLE;
+    if ((UCSR0B & (1 << TXEN0)) && (UCSR0A & ((1 << UDRE0) | (1 << TXC0))) != ((1 << UDRE0) | (1 << TXC0)))
+        return POWER_IDLE;
+    if (INT_EDGE(0) || INT_EDGE(1))
+        return POWER_IDLE;
+    if (TIMER_CLOCKED(TCCR0B) || TIMER_CLOCKED(TCCR1B))
+        return POWER_IDLE;
+    if (ADCSRA & (1 << ADSC))
+        return POWER_IDLE;
+    if (TIMER_CLOCKED(TCCR2B))
+        return (ASSR & (1 << AS2)) ? POWER_SAVE : POWER_IDLE;
+    return POWER_DOWN;
+}
+
+static void power_enter(uint8_t mode)
+{
+    g_power_count[mode]++;
+    set_sleep_mode(g_power_sleep_mode[mode]);
+    sleep_enable();
+#ifdef POWER_STATS_SYSTIME
+    uint32_t start = micros();
+#endif
+    if (mode == POWER_DOWN)
+        sleep_bod_disable();                    /* BOD off while sleeping (timed sequence, page 45) */
+    sei();
+    sleep_cpu();
+    sleep_disable();
+#ifdef POWER_STATS_SYSTIME
+    if (mode != POWER_DOWN)                     /* Timers are stopped in power down */
+    {
+        uint32_t slept = micros() - start;
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            g_power_us[mode] += slept;
+        }
+    }
+#endif
+}
+
+/*
+** Call with interrupts off, returns with interrupts on
+*/
+void power_sleep(void)
+{
+    power_enter(power_mode());
+}
+
+/*
+** Power down whatever is running (watchdog wake up)
+** The caller stops what must not be cut: last UART byte sent, TWI stop done
+** Call with interrupts off, returns with interrupts on
+*/
+void power_down(void)
+{
+    power_enter(POWER_DOWN);
+}
+
+/*
+** For the empty main loops: sleep until the next interrupt
+*/
+void power_idle(void)
+{
+    cli();
+    power_sleep();
+}
+
+/* Time slept in power down, known by the wake source (watchdog period) */
+void power_add_sleep_us(uint8_t mode, uint32_t us)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        g_power_us[mode] += us;
+    }
+}
+
+void power_stats(t_power_stats *stats)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (uint8_t i = 0; i < POWER_MODES; i++)
+        {
+            stats->count[i] = g_power_count[i];
+            stats->us[i] = g_power_us[i];
+        }
+#ifdef POWER_STATS_SYSTIME
+        stats->total_us = micros() - g_power_start + g_power_us[POWER_SAVE] + g_power_us[POWER_DOWN];
+#else
+        stats->total_us = 0;
+#endif
+    }
+}
+
+void power_stats_reset(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (uint8_t i = 0; i < POWER_MODES; i++)
+        {
+            g_power_count[i] = 0;
+            g_power_us[i] = 0;
+        }
+#ifdef POWER_STATS_SYSTIME
+        g_power_start = micros();
+#endif
+    }
+}
+
+/*
+** Active part of the time (0 ~ 1000)
+*/
+uint16_t power_duty_permille(const t_power_stats *stats)
+{
+    uint32_t asleep = stats->us[POWER_IDLE] + stats->us[POWER_SAVE] + stats->us[POWER_DOWN];
+
+    if (stats->total_us == 0 || asleep > stats->total_us)
+        return 0;
+    return (uint16_t)(((uint64_t)(stats->total_us - asleep) * 1000ULL) / stats->total_us);
+}
+
+/*
+** Estimated average current: each mode weighted by its time
+*/
+uint32_t power_avg_ua(const t_power_stats *stats)
+{
+    static const uint16_t mode_ua[POWER_MODES] = { POWER_IDLE_UA, POWER_SAVE_UA, POWER_DOWN_UA };
+    uint32_t asleep = 0;
+    uint64_t charge = 0;
+
+    if (stats->total_us == 0)
+        return 0;
+    for (uint8_t i = 0; i < POWER_MODES; i++)
+    {
+        charge += (uint64_t)stats->us[i] * mode_ua[i];
+        asleep += stats->us[i];
+    }
+    if (asleep < stats->total_us)
+        charge += (uint64_t)(stats->total_us - asleep) * POWER_ACTIVE_UA;
+    return (uint32_t)(charge / stats->total_us);
+}
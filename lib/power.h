@@ -0,0 +1,59 @@
+#ifndef POWER_H
+# define POWER_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+/*
+** Sleep between interrupts (page 39 9. Power Management and Sleep Modes)
+**  - power_mode() looks at the running peripherals and picks the deepest mode that keeps them working
+**      IDLE       : USART on, Timer0 / Timer1 clocked, Timer2 on the I/O clock, ADC converting
+**      POWER_SAVE : only Timer2 in asynchronous mode (32kHz crystal) is left
+**      POWER_DOWN : only INT0 / INT1 on a low level, pin change, TWI address, watchdog can wake up
+**                   (INT0 / INT1 on an edge keep idle)
+**  - power_sleep() is race free: the caller checks its condition with interrupts off,
+**    "sei; sleep" then cannot lose an interrupt (the instruction after sei always runs first)
+**
+**      cli();
+**      if (!g_flag)
+**          power_sleep();  <- returns with interrupts on
+**      sei();
+**
+** Residency: every sleep is counted per mode
+** With POWER_STATS_SYSTIME (systime linked), the time in each mode is measured too (micros()),
+** in power down the timers stop, the wake source gives the slept time with power_add_sleep_us()
+*/
+
+#define POWER_IDLE      0
+#define POWER_SAVE      1
+#define POWER_DOWN      2
+#define POWER_MODES     3
+
+/*
+** Typical supply current at 5V 16MHz (uA, page 304 29. Typical Characteristics)
+** power down is counted with the watchdog on
+*/
+#define POWER_ACTIVE_UA 9000
+#define POWER_IDLE_UA   2700
+#define POWER_SAVE_UA   10
+#define POWER_DOWN_UA   5
+
+typedef struct s_power_stats
+{
+    uint32_t    count[POWER_MODES];     /* Number of sleeps */
+    uint32_t    us[POWER_MODES];        /* Time in each mode (POWER_STATS_SYSTIME) */
+    uint32_t    total_us;               /* Time since power_stats_reset() */
+}   t_power_stats;
+
+uint8_t     power_mode(void);
+void        power_sleep(void);
+void        power_down(void);
+void        power_idle(void);
+void        power_add_sleep_us(uint8_t mode, uint32_t us);
+void        power_stats(t_power_stats *stats);
+void        power_stats_reset(void);
+uint16_t    power_duty_permille(const t_power_stats *stats);
+uint32_t    power_avg_ua(const t_power_stats *stats);
+
+#endif
@@ -0,0 +1,64 @@
+#include "pwm.h"
+#include "periph.h"
+#include "board.h"
+
+/* Each color is on its timer output (page 12 1-1) */
+BOARD_ASSERT(RGB_R, D, 5);      /* OC0B */
+BOARD_ASSERT(RGB_G, D, 6);      /* OC0A */
+BOARD_ASSERT(RGB_B, D, 3);      /* OC2B */
+
+void init_rgb(void)
+{
+    periph_claim(PERIPH_TIM0 | PERIPH_TIM2);
+
+    BOARD_SETUP(BOARD_RGB);     /* Outputs, low until the timers take the pins */
+
+    OCR0B = 0;  /* Red */
+    OCR0A = 0;  /* Green */
+    OCR2B = 0;  /* Blue */
+
+    TCCR0A = (1 << COM0A1) | (1 << COM0B1) | (1 << WGM01) | (1 << WGM00);  /* Non-inverting, page 113 15-3 / 115 15-8 */
+    TCCR0B = (1 << CS00);                                                   /* No prescaler, page 116 */
+    TCCR2A = (1 << COM2B1) | (1 << WGM21) | (1 << WGM20);                  /* page 163 18-6 / 164 18-8 */
+    TCCR2B = (1 << CS20);                                                   /* No prescaler, page 165 */
+}
+
+void set_rgb(uint8_t r, uint8_t g, uint8_t b)
+{
+    OCR0B = r;  /* Red */
+    OCR0A = g;  /* Green */
+    OCR2B = b;  /* Blue */
+}
+
+/*
+** Color wheel: 0 ~ 255 -> red -> blue -> green -> red
+*/
+void wheel(uint8_t pos)
+{
+    pos = 255 - pos;
+
+    if (pos < 85)
+    {
+        set_rgb(255 - pos * 3, 0, pos * 3);
+    }
+    else if (pos < 170)
+    {
+        pos = pos - 85;
+        set_rgb(0, pos * 3, 255 - pos * 3);
+    }
+    else
+    {
+        pos = pos - 170;
+        set_rgb(pos * 3, 255 - pos * 3, 0);
+    }
+}
+
+void stop_rgb(void)
+{
+    TCCR0A = 0;                 /* Pins back to PORTD */
+    TCCR0B = 0;
+    TCCR2A = 0;
+    TCCR2B = 0;
+    BOARD_WRITE(BOARD_RGB, 0);
+    periph_release(PERIPH_TIM0 | PERIPH_TIM2);
+}
@@ -0,0 +1,22 @@
+#ifndef PWM_H
+# define PWM_H
+
+#include <avr/io.h>
+
+/*
+** RGB LED on hardware PWM, fast PWM 8 bit, no prescaler (62.5kHz, no flicker)
+**  - red   PD5 = OC0B (Timer0)
+**  - green PD6 = OC0A (Timer0)
+**  - blue  PD3 = OC2B (Timer2)
+**  - Timer0: page 115 15-8 mode 3, Timer2: page 164 18-8 mode 3, top 255
+**  - set_rgb() only writes the three OCR (double buffered by the hardware, new duty at the next BOTTOM)
+**
+** init_rgb() claims Timer0 and Timer2 (periph.h), stop_rgb() turns the pins off and gives them back
+*/
+
+void    init_rgb(void);
+void    set_rgb(uint8_t r, uint8_t g, uint8_t b);
+void    wheel(uint8_t pos);
+void    stop_rgb(void);
+
+#endif
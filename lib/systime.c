@@ -0,0 +1,163 @@
+#include "systime.h"
+#include "periph.h"
+#if LOAD
+# include "load.h"
+#endif
+
+/*
+** Per timer settings
+**  - TIME_US(ovf, cnt): microseconds from overflow count and counter value (at 16MHz)
+**  - one overflow = SYSTIME_OVF_US_TOTAL us at 16MHz
+*/
+#if SYSTIME_TIMER == 1
+# define SYSTIME_CNT        TCNT1
+# define SYSTIME_TIFR       TIFR1
+# define SYSTIME_TOV        TOV1
+# define SYSTIME_HALF       0x8000
+# define SYSTIME_OVF_vect   TIMER1_OVF_vect
+# if SYSTIME_CLK1
+#  define SYSTIME_OVF_US_TOTAL 4096UL
+#  define TIME_US(ovf, cnt) (((ovf) << 12) + ((cnt) >> 4))
+# else
+#  define SYSTIME_OVF_US_TOTAL 32768UL
+#  define TIME_US(ovf, cnt) (((ovf) << 15) + ((cnt) >> 1))
+# endif
+#else
+# define SYSTIME_CNT        TCNT2
+# define SYSTIME_TIFR       TIFR2
+# define SYSTIME_TOV        TOV2
+# define SYSTIME_HALF       0x80
+# define SYSTIME_OVF_vect   TIMER2_OVF_vect
+# define SYSTIME_OVF_US_TOTAL 1024UL
+# define TIME_US(ovf, cnt)  (((ovf) << 10) + ((uint32_t)(cnt) << 2))
+#endif
+
+static volatile uint32_t g_time_ovf = 0;    /* Overflow count (high part) */
+static volatile uint32_t g_time_ms = 0;     /* Whole ms at the last overflow */
+static volatile uint16_t g_time_frac = 0;   /* us left over (0 ~ 999) */
+
+/*
+** Clock prescaler (clock.c): the timer ticks (1 << shift) times slower
+**  - one overflow = SYSTIME_OVF_US_TOTAL << shift, split in ms + us for the ISR
+**  - at a change, the time so far is kept in g_time_base and the counter starts again from 0
+*/
+static uint8_t g_time_shift = 0;
+static uint32_t g_time_base = 0;            /* micros() at the last clock change */
+static uint16_t g_time_ovf_ms = SYSTIME_OVF_US_TOTAL / 1000;
+static uint16_t g_time_ovf_us = SYSTIME_OVF_US_TOTAL % 1000;
+
+void systime_init(void)
+{
+#if SYSTIME_TIMER == 1
+    periph_claim(PERIPH_TIM1);
+    TCCR1A = 0;                     /* Normal mode, page 141 16-4 mode 0 */
+# if SYSTIME_CLK1
+    TCCR1B = (1 << CS10);           /* clk/1, page 143 16-5 */
+# else
+    TCCR1B = (1 << CS11);           /* clk/8, page 143 16-5 */
+# endif
+    TCNT1 = 0;
+    TIFR1 = (1 << TOV1);
+    TIMSK1 |= (1 << TOIE1);
+#else
+    periph_claim(PERIPH_TIM2);
+    TCCR2A = 0;                     /* Normal mode, page 164 18-8 mode 0 */
+    TCCR2B = (1 << CS22);           /* clk/64, page 165 18-9 */
+    TCNT2 = 0;
+    TIFR2 = (1 << TOV2);
+    TIMSK2 |= (1 << TOIE2);
+#endif
+}
+
+ISR(SYSTIME_OVF_vect)
+{
+    uint16_t frac = g_time_frac + g_time_ovf_us;
+    uint32_t ms = g_time_ms + g_time_ovf_ms;
+
+    if (frac >= 1000)
+    {
+        frac -= 1000;
+        ms++;
+    }
+    g_time_frac = frac;
+    g_time_ms = ms;
+    g_time_ovf++;
+
+#if LOAD
+    load_overflow();    /* make LOAD=1 builds this file with the exercise: libemb's ISR calls nothing */
+#endif
+}
+
+/*
+** The counter is read after the overflow count, both with interrupts off
+** A small counter value with TOV still set means: wrapped, ISR not run yet -> count it here
+*/
+uint32_t micros(void)
+{
+    uint32_t ovf;
+    uint16_t cnt;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ovf = g_time_ovf;
+        cnt = SYSTIME_CNT;
+        if ((SYSTIME_TIFR & (1 << SYSTIME_TOV)) && cnt < SYSTIME_HALF)
+            ovf++;
+    }
+    return g_time_base + (TIME_US(ovf, cnt) << g_time_shift);
+}
+
+uint32_t millis(void)
+{
+    uint32_t ms;
+    uint16_t frac;
+    uint16_t cnt;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ms = g_time_ms;
+        frac = g_time_frac;
+        cnt = SYSTIME_CNT;
+        if ((SYSTIME_TIFR & (1 << SYSTIME_TOV)) && cnt < SYSTIME_HALF)
+        {
+            ms += g_time_ovf_ms;
+            frac += g_time_ovf_us;
+        }
+    }
+    /* us since the last overflow: at most 999 + (32767 << 4), the division is done outside the lock */
+    return ms + (frac + (TIME_US(0UL, cnt) << g_time_shift)) / 1000;
+}
+
+/*
+** Called by clock_set() (interrupts off) right after the prescaler change
+**  - the elapsed time is folded into the base (ms / frac for millis, base for micros)
+**  - the counter and the overflow count restart, so the old ticks are never scaled with the new shift
+*/
+void systime_clock(uint8_t div)
+{
+    uint32_t ms = g_time_ms;
+    uint32_t rest;
+    uint32_t span = SYSTIME_OVF_US_TOTAL << div;
+
+    g_time_base = micros();
+
+    if (SYSTIME_TIFR & (1 << SYSTIME_TOV))      /* Overflow the ISR did not count yet */
+    {
+        ms += g_time_ovf_ms;
+        rest = g_time_frac + g_time_ovf_us + (TIME_US(0UL, SYSTIME_CNT) << g_time_shift);
+    }
+    else
+    {
+        rest = g_time_frac + (TIME_US(0UL, SYSTIME_CNT) << g_time_shift);
+    }
+    g_time_ms = ms + rest / 1000;
+    g_time_frac = rest % 1000;
+
+    g_time_ovf = 0;
+    SYSTIME_CNT = 0;
+    SYSTIME_TIFR = (1 << SYSTIME_TOV);
+
+    g_time_shift = div;
+    g_time_ovf_ms = span / 1000;
+    g_time_ovf_us = span % 1000;
+}
@@ -0,0 +1,57 @@
+#ifndef SYSTIME_H
+# define SYSTIME_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+/*
+** System time: 32 bit micros() / millis() from one free running timer
+**  - The hardware counter gives the low part, the overflow interrupt counts the high part
+**  - Reading is atomic (interrupts off for a few cycles), from main or from an ISR
+**  - If the counter wrapped but the overflow ISR did not run yet (TOV flag pending),
+**    the reader adds the missing overflow itself -> no torn or backward reads
+**
+** SYSTIME_TIMER 1 (default): Timer1 normal mode, clk/8 -> 0.5us tick
+**  - overflow every 65536 * 0.5us = 32.768ms -> 30.5 interrupts/s, ~0.01% CPU
+** SYSTIME_TIMER 1 + SYSTIME_CLK1: Timer1 at clk/1 -> 62.5ns tick (TCNT1 shared with lib/trace.h,
+** lib/load.h: with LOAD=1 its load_overflow() is called from the overflow interrupt)
+**  - overflow every 65536 * 62.5ns = 4.096ms -> 244 interrupts/s, ~0.1% CPU
+** SYSTIME_TIMER 2: Timer2 normal mode, clk/64 -> 4us tick (when Timer1 is used for PWM, or by
+**  lib/icp.c: it defines TIMER1_OVF_vect too, the two cannot be linked on Timer1)
+**  - overflow every 256 * 4us = 1.024ms -> 977 interrupts/s, ~0.3% CPU
+**
+** micros() wraps after 71 minutes, millis() after 49 days
+**
+** Clock prescaler (clock.c): clock_set() calls systime_clock(), the tick grows with the clock divider
+** (0.5us at 16MHz, 8us at 1MHz for Timer1), times stay in us / ms
+*/
+
+#ifndef SYSTIME_TIMER
+# define SYSTIME_TIMER 1
+#endif
+
+#if F_CPU != 16000000UL
+# error "systime: tick sizes are computed for F_CPU = 16MHz"
+#endif
+
+#ifndef SYSTIME_CLK1
+# define SYSTIME_CLK1 0
+#endif
+
+#if SYSTIME_TIMER == 1 && SYSTIME_CLK1
+# define SYSTIME_TICK_NS    62          /* 62.5 */
+#elif SYSTIME_TIMER == 1
+# define SYSTIME_TICK_NS    500
+#elif SYSTIME_TIMER == 2
+# define SYSTIME_TICK_NS    4000
+#else
+# error "systime: SYSTIME_TIMER must be 1 or 2"
+#endif
+
+void        systime_init(void);
+uint32_t    micros(void);
+uint32_t    millis(void);
+void        systime_clock(uint8_t div);
+
+#endif
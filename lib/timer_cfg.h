@@ -0,0 +1,308 @@
+#ifndef TIMER_CFG_H
+# define TIMER_CFG_H
+
+#include <avr/io.h>
+#include "clock.h"
+
+/*
+** Compile time timer configuration
+**  - Before the include, give the frequency (and the mode) of each timer you use
+**  - The prescaler and TOP with the smallest error are chosen by the preprocessor
+**  - Registers get plain constants, nothing is computed at runtime
+**
+**      #define TIMER1_FREQ     TIMER_MHZ(500)      <- 0.5Hz (2 sec)
+**      #define TIMER1_MODE     TIMER_CTC           <- optional, CTC by default
+**      #define TIMER1_MAX_PPM  100                 <- optional, build fails above (5000 = 0.5% by default)
+**      #include "timer_cfg.h"
+**
+**      OCR1A = TIMER1_TOP;                         -> 31249
+**      TCCR1B = TIMER1_TCCRB;                      -> WGM12 | CS12 | CS10 (1024)
+**
+** Frequency is in mHz (milli Hertz) so slow timers work too: TIMER_HZ(100), TIMER_MHZ(500)
+**
+** Formula (page 126 16.9.2 / page 102 15.7.2)
+**  - f = F_CPU / (prescaler * (TOP + 1))
+**  - counts = TOP + 1 = F_CPU / (prescaler * f) (rounded)
+**  - valid when 2 <= counts <= 256 (Timer0/2) or 65536 (Timer1)
+**  - error (ppm) = |F_CPU - prescaler * counts * f| * 1000000 / (prescaler * counts * f)
+**
+** Results for timer n (0, 1, 2)
+**  - TIMERn_PRESCALER, TIMERn_CS, TIMERn_TOP, TIMERn_ERROR_PPM
+**  - TIMERn_TCCRA, TIMERn_TCCRB (WGM + CS bits, COM bits are up to the pin usage)
+**  - TIMERn_DUTY(pct) -> compare value for pct % of the period
+**  - TIMER_WGM_A(n, mode) / TIMER_WGM_B(n, mode) -> WGM bits only (set the mode, start the clock later)
+**
+** Static error report: #error when the frequency cannot be reached or is off by more than TIMERn_MAX_PPM,
+** TIMERn_ERROR_PPM is a constant, it can be printed or checked with _Static_assert
+**
+** Clock prescaler (clock.h): timerN_clock() is a clock_listen() listener, the same frequency
+** after a clock_set() (prescaler and TOP for the new clock, the compare of a fast PWM scaled
+** with TOP so the duty stays), a stopped timer is left stopped
+**      clock_listen(timer1_clock);
+*/
+
+#define TIMER_CTC       0   /* Clear Timer on Compare, TOP = OCRnA (Timer1 mode 4, Timer0/2 mode 2) */
+#define TIMER_FAST_PWM  1   /* Fast PWM, TOP = ICR1 (Timer1 mode 14) or OCRnA (Timer0/2 mode 7) */
+
+#define TIMER_HZ(x)     ((x) * 1000ULL)
+#define TIMER_MHZ(x)    ((x) * 1ULL)
+
+#define TIMER_DEFAULT_MAX_PPM 5000
+
+#define TCFG_CS_MASK    0x07    /* CSn2 ~ CSn0 of TCCRnB */
+
+/*
+** Prescalers
+**  - Timer0/1: 1, 8, 64, 256, 1024            (CS = index + 1, page 110 15-9 / page 143 16-5)
+**  - Timer2  : 1, 8, 32, 64, 128, 256, 1024   (CS = index + 1, page 165 18-9)
+*/
+#define TCFG_PRESC_T01(i)   ((i) == 0 ? 1ULL : (i) == 1 ? 8ULL : (i) == 2 ? 64ULL : (i) == 3 ? 256ULL : 1024ULL)
+#define TCFG_PRESC_T2(i)    ((i) == 0 ? 1ULL : (i) == 1 ? 8ULL : (i) == 2 ? 32ULL : (i) == 3 ? 64ULL : \
+                             (i) == 4 ? 128ULL : (i) == 5 ? 256ULL : 1024ULL)
+#define TCFG_PRESC(t, i)    ((t) == 2 ? TCFG_PRESC_T2(i) : TCFG_PRESC_T01(i))
+#define TCFG_NPRESC(t)      ((t) == 2 ? 7 : 5)
+#define TCFG_COUNTS_MAX(t)  ((t) == 1 ? 65536ULL : 256ULL)
+
+#define TCFG_CLK            (F_CPU * 1000ULL)   /* F_CPU in mHz */
+
+/* Rounded counts for one prescaler (at least 1, so the error formula never divides by 0) */
+#define TCFG_COUNTS_RAW(t, f, i)    ((TCFG_CLK + TCFG_PRESC(t, i) * (f) / 2) / (TCFG_PRESC(t, i) * (f)))
+#define TCFG_COUNTS(t, f, i)        (TCFG_COUNTS_RAW(t, f, i) ? TCFG_COUNTS_RAW(t, f, i) : 1ULL)
+
+#define TCFG_VALID(t, f, i)     ((i) < TCFG_NPRESC(t) && TCFG_COUNTS_RAW(t, f, i) >= 2 && \
+                                 TCFG_COUNTS_RAW(t, f, i) <= TCFG_COUNTS_MAX(t))
+
+#define TCFG_REAL(t, f, i)      (TCFG_PRESC(t, i) * TCFG_COUNTS(t, f, i) * (f))
+#define TCFG_DIFF(t, f, i)      (TCFG_CLK > TCFG_REAL(t, f, i) ? TCFG_CLK - TCFG_REAL(t, f, i) : TCFG_REAL(t, f, i) - TCFG_CLK)
+#define TCFG_ERR(t, f, i)       (TCFG_VALID(t, f, i) ? TCFG_DIFF(t, f, i) * 1000000ULL / TCFG_REAL(t, f, i) : ~0ULL)
+
+/*
+** WGM bits of the control registers (COM bits are not included)
+**  - Timer1 CTC      : WGM12                    (page 141 16-4 mode 4)
+**  - Timer1 Fast PWM : WGM11 + WGM12 + WGM13    (mode 14, TOP = ICR1)
+**  - Timer0/2 CTC    : WGMn1                    (page 115 15-8 mode 2)
+**  - Timer0/2 PWM    : WGMn0 + WGMn1 + WGMn2    (mode 7, TOP = OCRnA)
+*/
+#define TIMER_WGM_A(t, m)    ((t) == 1 ? ((m) == TIMER_FAST_PWM ? (1 << WGM11) : 0) : \
+                             ((m) == TIMER_FAST_PWM ? ((1 << WGM01) | (1 << WGM00)) : (1 << WGM01)))
+#define TIMER_WGM_B(t, m)    ((t) == 1 ? ((m) == TIMER_FAST_PWM ? ((1 << WGM13) | (1 << WGM12)) : (1 << WGM12)) : \
+                             ((m) == TIMER_FAST_PWM ? (1 << WGM02) : 0))
+
+#endif
+
+/*
+** Timer0
+** Prescaler scan: the smallest error wins, on a tie the smaller prescaler (better resolution) stays
+*/
+#if defined(TIMER0_FREQ) && !defined(TIMER0_PSEL)
+
+# ifndef TIMER0_MODE
+#  define TIMER0_MODE TIMER_CTC
+# endif
+# ifndef TIMER0_MAX_PPM
+#  define TIMER0_MAX_PPM TIMER_DEFAULT_MAX_PPM
+# endif
+
+# define TCFG_T0_S0 0
+# if TCFG_ERR(0, TIMER0_FREQ, 1) < TCFG_ERR(0, TIMER0_FREQ, TCFG_T0_S0)
+#  define TCFG_T0_S1 1
+# else
+#  define TCFG_T0_S1 TCFG_T0_S0
+# endif
+# if TCFG_ERR(0, TIMER0_FREQ, 2) < TCFG_ERR(0, TIMER0_FREQ, TCFG_T0_S1)
+#  define TCFG_T0_S2 2
+# else
+#  define TCFG_T0_S2 TCFG_T0_S1
+# endif
+# if TCFG_ERR(0, TIMER0_FREQ, 3) < TCFG_ERR(0, TIMER0_FREQ, TCFG_T0_S2)
+#  define TCFG_T0_S3 3
+# else
+#  define TCFG_T0_S3 TCFG_T0_S2
+# endif
+# if TCFG_ERR(0, TIMER0_FREQ, 4) < TCFG_ERR(0, TIMER0_FREQ, TCFG_T0_S3)
+#  define TCFG_T0_S4 4
+# else
+#  define TCFG_T0_S4 TCFG_T0_S3
+# endif
+# define TIMER0_PSEL TCFG_T0_S4
+
+# if TCFG_ERR(0, TIMER0_FREQ, TIMER0_PSEL) == ~0ULL
+#  error "timer_cfg: Timer0 cannot reach TIMER0_FREQ with any prescaler"
+# elif TCFG_ERR(0, TIMER0_FREQ, TIMER0_PSEL) > TIMER0_MAX_PPM
+#  error "timer_cfg: Timer0 error is bigger than TIMER0_MAX_PPM"
+# endif
+
+# define TIMER0_PRESCALER     TCFG_PRESC(0, TIMER0_PSEL)
+# define TIMER0_CS            (TIMER0_PSEL + 1)
+# define TIMER0_TOP           (TCFG_COUNTS(0, TIMER0_FREQ, TIMER0_PSEL) - 1)
+# define TIMER0_ERROR_PPM     TCFG_ERR(0, TIMER0_FREQ, TIMER0_PSEL)
+# define TIMER0_TCCRA         TIMER_WGM_A(0, TIMER0_MODE)
+# define TIMER0_TCCRB         (TIMER_WGM_B(0, TIMER0_MODE) | TIMER0_CS)
+# define TIMER0_DUTY(pct)     ((TIMER0_TOP + 1) * (pct) / 100)
+
+static inline void timer0_clock(uint8_t div)
+{
+    uint16_t top;
+    uint8_t cs = clock_timer(0, TIMER0_PRESCALER * (TIMER0_TOP + 1), div, &top);
+
+# if TIMER0_MODE == TIMER_FAST_PWM
+    OCR0B = (uint16_t)OCR0B * (top + 1) / (OCR0A + 1);
+# endif
+    OCR0A = top;
+    if (TCNT0 > top)                          /* Past the new TOP: would count up to the end first */
+        TCNT0 = 0;
+    if (TCCR0B & TCFG_CS_MASK)
+        TCCR0B = (TCCR0B & ~TCFG_CS_MASK) | cs;
+}
+
+#endif
+
+/*
+** Timer1
+** Prescaler scan: the smallest error wins, on a tie the smaller prescaler (better resolution) stays
+*/
+#if defined(TIMER1_FREQ) && !defined(TIMER1_PSEL)
+
+# ifndef TIMER1_MODE
+#  define TIMER1_MODE TIMER_CTC
+# endif
+# ifndef TIMER1_MAX_PPM
+#  define TIMER1_MAX_PPM TIMER_DEFAULT_MAX_PPM
+# endif
+
+# define TCFG_T1_S0 0
+# if TCFG_ERR(1, TIMER1_FREQ, 1) < TCFG_ERR(1, TIMER1_FREQ, TCFG_T1_S0)
+#  define TCFG_T1_S1 1
+# else
+#  define TCFG_T1_S1 TCFG_T1_S0
+# endif
+# if TCFG_ERR(1, TIMER1_FREQ, 2) < TCFG_ERR(1, TIMER1_FREQ, TCFG_T1_S1)
+#  define TCFG_T1_S2 2
+# else
+#  define TCFG_T1_S2 TCFG_T1_S1
+# endif
+# if TCFG_ERR(1, TIMER1_FREQ, 3) < TCFG_ERR(1, TIMER1_FREQ, TCFG_T1_S2)
+#  define TCFG_T1_S3 3
+# else
+#  define TCFG_T1_S3 TCFG_T1_S2
+# endif
+# if TCFG_ERR(1, TIMER1_FREQ, 4) < TCFG_ERR(1, TIMER1_FREQ, TCFG_T1_S3)
+#  define TCFG_T1_S4 4
+# else
+#  define TCFG_T1_S4 TCFG_T1_S3
+# endif
+# define TIMER1_PSEL TCFG_T1_S4
+
+# if TCFG_ERR(1, TIMER1_FREQ, TIMER1_PSEL) == ~0ULL
+#  error "timer_cfg: Timer1 cannot reach TIMER1_FREQ with any prescaler"
+# elif TCFG_ERR(1, TIMER1_FREQ, TIMER1_PSEL) > TIMER1_MAX_PPM
+#  error "timer_cfg: Timer1 error is bigger than TIMER1_MAX_PPM"
+# endif
+
+# define TIMER1_PRESCALER     TCFG_PRESC(1, TIMER1_PSEL)
+# define TIMER1_CS            (TIMER1_PSEL + 1)
+# define TIMER1_TOP           (TCFG_COUNTS(1, TIMER1_FREQ, TIMER1_PSEL) - 1)
+# define TIMER1_ERROR_PPM     TCFG_ERR(1, TIMER1_FREQ, TIMER1_PSEL)
+# define TIMER1_TCCRA         TIMER_WGM_A(1, TIMER1_MODE)
+# define TIMER1_TCCRB         (TIMER_WGM_B(1, TIMER1_MODE) | TIMER1_CS)
+# define TIMER1_DUTY(pct)     ((TIMER1_TOP + 1) * (pct) / 100)
+# if TIMER1_MODE == TIMER_FAST_PWM
+#  define TIMER1_TOP_REG      ICR1
+# else
+#  define TIMER1_TOP_REG      OCR1A
+# endif
+
+static inline void timer1_clock(uint8_t div)
+{
+    uint16_t top;
+    uint8_t cs = clock_timer(1, TIMER1_PRESCALER * (TIMER1_TOP + 1), div, &top);
+
+# if TIMER1_MODE == TIMER_FAST_PWM
+    OCR1A = (uint32_t)OCR1A * (top + 1UL) / (ICR1 + 1UL);
+    OCR1B = (uint32_t)OCR1B * (top + 1UL) / (ICR1 + 1UL);
+# endif
+    TIMER1_TOP_REG = top;
+    if (TCNT1 > top)                          /* Past the new TOP: would count up to the end first */
+        TCNT1 = 0;
+    if (TCCR1B & TCFG_CS_MASK)
+        TCCR1B = (TCCR1B & ~TCFG_CS_MASK) | cs;
+}
+
+#endif
+
+/*
+** Timer2
+** Prescaler scan: the smallest error wins, on a tie the smaller prescaler (better resolution) stays
+*/
+#if defined(TIMER2_FREQ) && !defined(TIMER2_PSEL)
+
+# ifndef TIMER2_MODE
+#  define TIMER2_MODE TIMER_CTC
+# endif
+# ifndef TIMER2_MAX_PPM
+#  define TIMER2_MAX_PPM TIMER_DEFAULT_MAX_PPM
+# endif
+
+# define TCFG_T2_S0 0
+# if TCFG_ERR(2, TIMER2_FREQ, 1) < TCFG_ERR(2, TIMER2_FREQ, TCFG_T2_S0)
+#  define TCFG_T2_S1 1
+# else
+#  define TCFG_T2_S1 TCFG_T2_S0
+# endif
+# if TCFG_ERR(2, TIMER2_FREQ, 2) < TCFG_ERR(2, TIMER2_FREQ, TCFG_T2_S1)
+#  define TCFG_T2_S2 2
+# else
+#  define TCFG_T2_S2 TCFG_T2_S1
+# endif
+# if TCFG_ERR(2, TIMER2_FREQ, 3) < TCFG_ERR(2, TIMER2_FREQ, TCFG_T2_S2)
+#  define TCFG_T2_S3 3
+# else
+#  define TCFG_T2_S3 TCFG_T2_S2
+# endif
+# if TCFG_ERR(2, TIMER2_FREQ, 4) < TCFG_ERR(2, TIMER2_FREQ, TCFG_T2_S3)
+#  define TCFG_T2_S4 4
+# else
+#  define TCFG_T2_S4 TCFG_T2_S3
+# endif
+# if TCFG_ERR(2, TIMER2_FREQ, 5) < TCFG_ERR(2, TIMER2_FREQ, TCFG_T2_S4)
+#  define TCFG_T2_S5 5
+# else
+#  define TCFG_T2_S5 TCFG_T2_S4
+# endif
+# if TCFG_ERR(2, TIMER2_FREQ, 6) < TCFG_ERR(2, TIMER2_FREQ, TCFG_T2_S5)
+#  define TCFG_T2_S6 6
+# else
+#  define TCFG_T2_S6 TCFG_T2_S5
+# endif
+# define TIMER2_PSEL TCFG_T2_S6
+
+# if TCFG_ERR(2, TIMER2_FREQ, TIMER2_PSEL) == ~0ULL
+#  error "timer_cfg: Timer2 cannot reach TIMER2_FREQ with any prescaler"
+# elif TCFG_ERR(2, TIMER2_FREQ, TIMER2_PSEL) > TIMER2_MAX_PPM
+#  error "timer_cfg: Timer2 error is bigger than TIMER2_MAX_PPM"
+# endif
+
+# define TIMER2_PRESCALER     TCFG_PRESC(2, TIMER2_PSEL)
+# define TIMER2_CS            (TIMER2_PSEL + 1)
+# define TIMER2_TOP           (TCFG_COUNTS(2, TIMER2_FREQ, TIMER2_PSEL) - 1)
+# define TIMER2_ERROR_PPM     TCFG_ERR(2, TIMER2_FREQ, TIMER2_PSEL)
+# define TIMER2_TCCRA         TIMER_WGM_A(2, TIMER2_MODE)
+# define TIMER2_TCCRB         (TIMER_WGM_B(2, TIMER2_MODE) | TIMER2_CS)
+# define TIMER2_DUTY(pct)     ((TIMER2_TOP + 1) * (pct) / 100)
+
+static inline void timer2_clock(uint8_t div)
+{
+    uint16_t top;
+    uint8_t cs = clock_timer(2, TIMER2_PRESCALER * (TIMER2_TOP + 1), div, &top);
+
+# if TIMER2_MODE == TIMER_FAST_PWM
+    OCR2B = (uint16_t)OCR2B * (top + 1) / (OCR2A + 1);
+# endif
+    OCR2A = top;
+    if (TCNT2 > top)                          /* Past the new TOP: would count up to the end first */
+        TCNT2 = 0;
+    if (TCCR2B & TCFG_CS_MASK)
+        TCCR2B = (TCCR2B & ~TCFG_CS_MASK) | cs;
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "trace.h"
+#include "periph.h"
+#include "uart.h"
+#include <util/crc16.h>
+#include <util/atomic.h>
+
+t_trace_event    g_trace_ring[TRACE_SIZE];
+volatile uint8_t g_trace_head = 0;     /* Next free slot (recorders) */
+volatile uint8_t g_trace_tail = 0;     /* Oldest event (trace_dump) */
+volatile uint8_t g_trace_lost = 0;     /* Events dropped on a full ring, up to 255 */
+
+static const char *g_trace_names[TRACE_IDS];   /* PSTR, sent with each dump */
+
+/*
+** Timer1 free running at clk/1 (normal mode, page 141 16-4 mode 0, page 143 16-5)
+** Already started (systime with SYSTIME_CLK1): only one more user, the counter is not touched
+*/
+void trace_init(void)
+{
+    periph_claim(PERIPH_TIM1);
+    if ((TCCR1B & 0x07) == 0)
+    {
+        TCCR1A = 0;
+        TCCR1B = (1 << CS10);
+    }
+}
+
+void trace_name(uint8_t id, const char *name_P)
+{
+    g_trace_names[id & TRACE_ID_MASK] = name_P;
+}
+
+uint8_t trace_full(void)
+{
+    return ((g_trace_head + 1) & (TRACE_SIZE - 1)) == g_trace_tail;
+}
+
+static uint16_t trace_tx(uint16_t crc, uint8_t byte)
+{
+    uart_tx(byte);
+    return _crc_ccitt_update(crc, byte);
+}
+
+/*
+** Binary dump (tools/trace_stats.py), every field little endian
+**   'T' 'R' | version 1 | F_CPU in MHz
+**   name count | { id, length, chars } ...
+**   lost | event count | { tag, time } ...
+**   CRC-16 CCITT (0xFFFF) of everything after 'T' 'R'
+**
+** Only the events stored when the dump starts are sent, the ones recorded meanwhile
+** stay for the next dump; each sent event frees its slot at once
+*/
+void trace_dump(void)
+{
+    uint16_t crc = 0xFFFF;
+    uint8_t head = g_trace_head;
+    uint8_t tail = g_trace_tail;
+    uint8_t names = 0;
+    uint8_t lost;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        lost = g_trace_lost;
+        g_trace_lost = 0;
+    }
+
+    uart_tx('T');
+    uart_tx('R');
+    crc = trace_tx(crc, 1);
+    crc = trace_tx(crc, F_CPU / 1000000UL);
+
+    for (uint8_t id = 0; id < TRACE_IDS; id++)
+        names += g_trace_names[id] != 0;
+    crc = trace_tx(crc, names);
+    for (uint8_t id = 0; id < TRACE_IDS; id++)
+    {
+        const char *name = g_trace_names[id];
+
+        if (!name)
+            continue;
+        crc = trace_tx(crc, id);
+        crc = trace_tx(crc, strlen_P(name));
+        for (char c; (c = pgm_read_byte(name)); name++)
+            crc = trace_tx(crc, c);
+    }
+
+    crc = trace_tx(crc, lost);
+    crc = trace_tx(crc, (head - tail) & (TRACE_SIZE - 1));
+    while (tail != head)
+    {
+        crc = trace_tx(crc, g_trace_ring[tail].tag);
+        crc = trace_tx(crc, g_trace_ring[tail].time & 0xFF);
+        crc = trace_tx(crc, g_trace_ring[tail].time >> 8);
+        tail = (tail + 1) & (TRACE_SIZE - 1);
+        g_trace_tail = tail;
+    }
+    uart_tx(crc & 0xFF);
+    uart_tx(crc >> 8);
+}
@@ -0,0 +1,114 @@
+#ifndef TRACE_H
+# define TRACE_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+/*
+** ISR / region trace: entry and exit timestamps in a RAM ring, dumped in binary over the UART
+**  - Built in with -DTRACE=1 (make TRACE=1), TRACE_ENTER / TRACE_EXIT are empty otherwise
+**  - Timestamp: TCNT1, Timer1 free running at clk/1 -> 62.5ns, wraps every 4.096ms
+**    (trace_init() starts it, or shares it with systime built with SYSTIME_CLK1)
+**  - One event: tag (id, exit bit, interrupts off bit) + 16 bit time, 3 bytes
+**  - Every event also notes the I bit: an ISR (or a cli section) blocks the other interrupts,
+**    tools/trace_stats.py charges the wait of the next interrupt to it
+**
+** Ring: the recorders (ISRs, main) only move the head, trace_dump() only moves the tail,
+** neither one waits for the other (a full ring drops the new events and counts them)
+** Recording is 20 ~ 25 cycles with interrupts off, the ISRs do not nest (I bit cleared)
+** so only a recorder in main really needs the cli
+**
+** TRACE_GPIO=1: ids 0 ~ 3 also drive PC0 ~ PC3 (A0 ~ A3) high during the span,
+** for a logic analyzer (no RAM, one sbi / cbi)
+**
+** Durations longer than 4.096ms (Timer1 wrap) are seen modulo 4.096ms
+*/
+
+#ifndef TRACE
+# define TRACE 0
+#endif
+
+#ifndef TRACE_GPIO
+# define TRACE_GPIO 0
+#endif
+
+#define TRACE_SIZE      64          /* Events, power of 2 (trace.c is built with this one) */
+#define TRACE_IDS       8           /* Ids 0 ~ 7, a name each */
+
+#define TRACE_EXIT_BIT  0x80
+#define TRACE_MASK_BIT  0x40        /* Interrupts were off (ISR, cli section) */
+#define TRACE_ID_MASK   0x07
+
+typedef struct s_trace_event
+{
+    uint8_t     tag;
+    uint16_t    time;               /* TCNT1 */
+}   t_trace_event;
+
+extern t_trace_event    g_trace_ring[TRACE_SIZE];
+extern volatile uint8_t g_trace_head;
+extern volatile uint8_t g_trace_tail;
+extern volatile uint8_t g_trace_lost;
+
+void    trace_init(void);
+void    trace_name(uint8_t id, const char *name_P);
+uint8_t trace_full(void);
+void    trace_dump(void);
+
+#if TRACE && defined(SYSTIME_H) && SYSTIME_TIMER == 1 && !SYSTIME_CLK1
+# error "trace: systime shares Timer1, build it with -DSYSTIME_CLK1=1"
+#endif
+
+/*
+** Time is taken with interrupts off: the events of an ISR which runs in the middle
+** of a recorder in main are never stored before it with a later time
+*/
+static inline __attribute__((always_inline)) void trace_event(uint8_t tag)
+{
+    uint8_t sreg = SREG;
+
+    cli();
+    uint16_t time = TCNT1;
+    uint8_t head = g_trace_head;
+    uint8_t next = (head + 1) & (TRACE_SIZE - 1);
+
+    if (next == g_trace_tail)
+    {
+        if (g_trace_lost != 0xFF)
+            g_trace_lost++;
+    }
+    else
+    {
+        g_trace_ring[head].tag = tag | ((sreg & (1 << SREG_I)) ? 0 : TRACE_MASK_BIT);
+        g_trace_ring[head].time = time;
+        g_trace_head = next;
+    }
+    __asm__ __volatile__ ("" ::: "memory");     /* Stores done before the I bit comes back */
+    SREG = sreg;
+}
+
+#if TRACE && TRACE_GPIO
+# define TRACE_PIN_INIT()   (DDRC |= 0x0F)
+# define TRACE_PIN_ON(id)   do { if ((id) < 4) PORTC |= (1 << (id)); } while (0)
+# define TRACE_PIN_OFF(id)  do { if ((id) < 4) PORTC &= ~(1 << (id)); } while (0)
+#else
+# define TRACE_PIN_INIT()   ((void)0)
+# define TRACE_PIN_ON(id)   ((void)0)
+# define TRACE_PIN_OFF(id)  ((void)0)
+#endif
+
+/* id: constant 0 ~ 7, first line of the ISR / last line before it returns */
+#if TRACE
+# define TRACE_ENTER(id)    do { TRACE_PIN_ON(id); trace_event(id); } while (0)
+# define TRACE_EXIT(id)     do { trace_event((id) | TRACE_EXIT_BIT); TRACE_PIN_OFF(id); } while (0)
+# define TRACE_NAME(id, s)  trace_name(id, PSTR(s))
+# define TRACE_INIT()       do { trace_init(); TRACE_PIN_INIT(); } while (0)
+#else
+# define TRACE_ENTER(id)    ((void)0)
+# define TRACE_EXIT(id)     ((void)0)
+# define TRACE_NAME(id, s)  ((void)0)
+# define TRACE_INIT()       ((void)0)
+#endif
+
+#endif
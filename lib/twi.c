@@ -0,0 +1,77 @@
+#include "twi.h"
+#include "periph.h"
+#include "clock.h"
+
+static uint8_t i2c_wait(void)
+{
+    while (!(TWCR & (1 << TWINT)))      /* Set by the hardware at the end of each step (page 225) */
+    {
+        ;
+    }
+    return TW_STATUS;                   /* TWSR without the prescaler bits */
+}
+
+void i2c_init(void)
+{
+    periph_claim(PERIPH_TWI);           /* TWI clock on (gated at startup) */
+
+    /*
+    ** SCL frequency = CPU clock / (16 + 2 * TWBR * prescaler) (page 222)
+    ** TWBR = ((F_CPU / SCL) - 16) / (2 * prescaler)
+    */
+    TWSR = 0x00;                        /* Prescaler value = 1 */
+    TWBR = CLOCK_TWBR(clock_div(), I2C_SCL_HZ);     /* The clock of now: an init after clock_set() too */
+    TWCR = (1 << TWEN);                 /* Enable TWI - page 240 */
+}
+
+void i2c_deinit(void)
+{
+    TWCR = 0;
+    periph_release(PERIPH_TWI);
+}
+
+/* New CPU clock (clock_set): 100kHz from the new clock (2MHz: TWBR = 2, 1MHz: 62.5kHz max) */
+void i2c_clock(uint8_t div)
+{
+    TWBR = CLOCK_TWBR(div, I2C_SCL_HZ);
+}
+
+/* START (or repeated START): TW_START / TW_REP_START */
+uint8_t i2c_start(void)
+{
+    TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN);
+    return i2c_wait();
+}
+
+/* SLA+R/W or data byte: TW_MT_SLA_ACK, TW_MR_SLA_ACK, TW_MT_DATA_ACK... */
+uint8_t i2c_write(uint8_t data)
+{
+    TWDR = data;
+    TWCR = (1 << TWINT) | (1 << TWEN);
+    return i2c_wait();
+}
+
+/* Receive a byte and ACK it: more bytes wanted */
+uint8_t i2c_read_ack(void)
+{
+    TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWEA);
+    i2c_wait();
+    return TWDR;
+}
+
+/* Receive the last byte, NACK: end of the read */
+uint8_t i2c_read_nack(void)
+{
+    TWCR = (1 << TWINT) | (1 << TWEN);
+    i2c_wait();
+    return TWDR;
+}
+
+void i2c_stop(void)
+{
+    TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWSTO);
+    while (TWCR & (1 << TWSTO))         /* Cleared when the STOP is on the bus (page 241) */
+    {
+        ;
+    }
+}
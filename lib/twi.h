@@ -0,0 +1,30 @@
+#ifndef TWI_H
+# define TWI_H
+
+#include <avr/io.h>
+#include <util/twi.h>
+
+/*
+** TWI (I2C) master polling driver, 100kHz (page 215 ~)
+**  - every step waits for TWINT and returns the status (TW_STATUS, page 227 22-2),
+**    the caller checks it against <util/twi.h>: TW_START, TW_MT_SLA_ACK, TW_MT_DATA_ACK...
+**  - address byte: (7 bit address << 1) | TW_READ / TW_WRITE
+**  - i2c_stop() returns once the STOP is on the bus (TWSTO cleared, page 241):
+**    the bus is free, the CPU can sleep or change its clock
+**  - i2c_clock() is a clock_listen() listener: 100kHz after a clock_set()
+**
+** i2c_init() claims the TWI clock (periph.h), i2c_deinit() gives it back
+*/
+
+#define I2C_SCL_HZ  100000UL
+
+void    i2c_init(void);
+void    i2c_deinit(void);
+void    i2c_clock(uint8_t div);
+uint8_t i2c_start(void);
+uint8_t i2c_write(uint8_t data);
+uint8_t i2c_read_ack(void);
+uint8_t i2c_read_nack(void);
+void    i2c_stop(void);
+
+#endif
@@ -0,0 +1,102 @@
+#include "uart.h"
+#include "periph.h"
+
+static uint16_t g_uart_ubrr;            /* Divisor at the full clock, for uart_clock() */
+
+void uart_init(uint16_t ubrr)
+{
+    periph_claim(PERIPH_USART0);            /* USART clock on (gated at startup) */
+
+    g_uart_ubrr = ubrr;
+    UBRR0 = ubrr;                           /* Baud rate, page 182 20-1 */
+
+    UCSR0A = (1 << U2X0);                   /* Double speed: divide by 8 instead of 16 (lower error) */
+    UCSR0C = (3 << UCSZ00);                 /* 8N1: 8 data bits, no parity, 1 stop bit (page 202) */
+    UCSR0B |= (1 << RXEN0) | (1 << TXEN0);  /* Enable Receiver and Transmitter */
+}
+
+void uart_tx(char c)
+{
+    while (!(UCSR0A & (1 << UDRE0)))        /* Wait for empty transmit buffer */
+    {
+        ;
+    }
+
+    UCSR0A |= (1 << TXC0);                  /* Clear Transmit Complete (write 1), see uart_flush() */
+    UDR0 = c;
+}
+
+void uart_puts(const char *str)
+{
+    while (*str)
+    {
+        uart_tx(*str++);
+    }
+}
+
+/* String in flash (PSTR), no copy in RAM */
+void uart_puts_P(const char *str)
+{
+    char c;
+
+    while ((c = pgm_read_byte(str++)))
+    {
+        uart_tx(c);
+    }
+}
+
+void uart_put_u32(uint32_t value)
+{
+    char digits[10];
+    uint8_t len = 0;
+
+    do
+    {
+        digits[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (len)
+    {
+        uart_tx(digits[--len]);
+    }
+}
+
+void uart_put_hex8(uint8_t value)
+{
+    static const char hex[] PROGMEM = "0123456789ABCDEF";
+
+    uart_tx(pgm_read_byte(&hex[value >> 4]));
+    uart_tx(pgm_read_byte(&hex[value & 0x0F]));
+}
+
+char uart_rx(void)
+{
+    while (!(UCSR0A & (1 << RXC0)))         /* Wait for receive buffer */
+    {
+        ;
+    }
+
+    return UDR0;
+}
+
+/* Wait until the last byte has left the shift register (before power down or a clock change, page 186) */
+void uart_flush(void)
+{
+    while (!(UCSR0A & (1 << TXC0)))
+    {
+        ;
+    }
+}
+
+/*
+** New CPU clock (clock_set): divisor of the full clock scaled down, rounded
+** (ubrr + 1) is the clock / (8 * baud) ratio, it is divided by 2^div like the clock
+** 115200 baud: +2.1% at 16MHz (UBRR 16, page 199 20-7), -3.5% at 8MHz (UBRR 8),
+** +8.5% at 2MHz: only send at 16MHz
+*/
+void uart_clock(uint8_t div)
+{
+    uint16_t ratio = ((g_uart_ubrr + 1) + ((1 << div) >> 1)) >> div;
+
+    UBRR0 = ratio ? ratio - 1 : 0;
+}
@@ -0,0 +1,30 @@
+#ifndef UART_H
+# define UART_H
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+/*
+** USART0 polling driver, 8N1, double speed (U2X0, page 182 20-1)
+**  - uart_init() claims the USART clock (periph.h) and enables the receiver and the transmitter
+**  - uart_tx() waits for UDRE0, uart_rx() waits for RXC0: no buffer, no interrupt
+**    (exercises with their own RX / UDRE interrupt only set RXCIE0 / UDRIE0 after uart_init())
+**  - uart_clock() is a clock_listen() listener: the same baud rate after a clock_set()
+*/
+
+#define UART_BAUDRATE   115200
+
+/* Rounded divisor for U2X0 at F_CPU (115200 -> 16, 2.1% error, 1000000 -> 1, 0%) */
+#define UART_UBRR(baud) ((F_CPU + 4UL * (baud)) / (8UL * (baud)) - 1)
+
+void    uart_init(uint16_t ubrr);
+void    uart_tx(char c);
+void    uart_puts(const char *str);
+void    uart_puts_P(const char *str);
+void    uart_put_u32(uint32_t value);
+void    uart_put_hex8(uint8_t value);
+char    uart_rx(void);
+void    uart_flush(void);
+void    uart_clock(uint8_t div);
+
+#endif
@@ -0,0 +1,77 @@
+#include "wakeup.h"
+#include "power.h"
+#include <avr/wdt.h>
+#include <util/atomic.h>
+
+static volatile uint8_t g_wakeup_fired = 0;
+static uint32_t g_wakeup_slept_ms = 0;
+
+ISR(WDT_vect)
+{
+    g_wakeup_fired = 1;
+}
+
+/*
+** Timed sequence (page 61): WDCE + WDE, then the new value within 4 cycles
+** WDRF is cleared first, it forces WDE on (page 60)
+*/
+static void wakeup_set(uint8_t wdtcsr)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        wdt_reset();
+        MCUSR &= ~(1 << WDRF);
+        WDTCSR = (1 << WDCE) | (1 << WDE);
+        WDTCSR = wdtcsr;
+    }
+}
+
+/*
+** period: WAKEUP_16MS ~ WAKEUP_8S
+** Returns with interrupts on
+*/
+void wakeup_sleep(uint8_t period)
+{
+    if (period > WAKEUP_8S)
+        period = WAKEUP_8S;
+
+    g_wakeup_fired = 0;
+    /* WDP3 is not next to WDP2:0 (page 61 10-3) */
+    wakeup_set((1 << WDIE) | ((period & 0x08) ? (1 << WDP3) : 0) | (period & 0x07));
+
+    cli();
+    while (!g_wakeup_fired)
+    {
+        power_down();
+        cli();
+    }
+    sei();
+
+    wakeup_set(0);                              /* Watchdog off */
+
+    power_add_sleep_us(POWER_DOWN, WAKEUP_MS(period) * 1000UL);
+    g_wakeup_slept_ms += WAKEUP_MS(period);
+}
+
+/*
+** Longest periods first: 80ms -> 64ms + 16ms
+** Rounded down to 16ms (less than 16ms -> no sleep)
+*/
+void wakeup_sleep_ms(uint16_t ms)
+{
+    uint8_t period = WAKEUP_8S;
+
+    while (ms >= WAKEUP_MIN_MS)
+    {
+        while (WAKEUP_MS(period) > ms)
+            period--;
+        wakeup_sleep(period);
+        ms -= WAKEUP_MS(period);
+    }
+}
+
+/* Time spent in wakeup_sleep() since boot */
+uint32_t wakeup_slept_ms(void)
+{
+    return g_wakeup_slept_ms;
+}
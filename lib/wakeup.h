@@ -0,0 +1,42 @@
+#ifndef WAKEUP_H
+# define WAKEUP_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*
+** Watchdog wake up timer (page 60 10.9 Watchdog Timer)
+**  - Watchdog in interrupt mode only (WDIE, no WDE): it never resets the chip
+**  - 128kHz oscillator, runs in power down -> the only timer left when every clock is off
+**  - period n = 2K << n cycles = 16ms << n (16ms ~ 8s, page 61 10-2)
+**  - the oscillator is +/-10% (voltage, temperature): fine for sampling, not for a clock
+**
+** wakeup_sleep(): power down for one period (power_down(), BOD off)
+**  - the CPU and its timers are stopped: systime (micros/millis) does not count the slept time
+**  - the slept time is given to power_add_sleep_us() and added to wakeup_slept_ms()
+**  - another wake source (pin change...) only ends the sleep early if it is the watchdog,
+**    other interrupts run and the CPU goes back to sleep
+**
+** The caller stops what the power down would cut: last UART byte sent (TXC0), TWI stop done
+*/
+
+#define WAKEUP_16MS     0
+#define WAKEUP_32MS     1
+#define WAKEUP_64MS     2
+#define WAKEUP_125MS    3
+#define WAKEUP_250MS    4
+#define WAKEUP_500MS    5
+#define WAKEUP_1S       6
+#define WAKEUP_2S       7
+#define WAKEUP_4S       8
+#define WAKEUP_8S       9
+
+#define WAKEUP_MIN_MS   16
+#define WAKEUP_MAX_MS   8192
+#define WAKEUP_MS(p)    (16UL << (p))           /* Nominal period */
+
+void        wakeup_sleep(uint8_t period);
+void        wakeup_sleep_ms(uint16_t ms);
+uint32_t    wakeup_slept_ms(void);
+
+#endif
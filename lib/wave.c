@@ -0,0 +1,140 @@
+#include "wave.h"
+
+/* Sine, starts and ends at 0: 127.5 - 127.5 * cos(2 * PI * i / 256) */
+const uint8_t g_wave_sine[WAVE_SAMPLES] PROGMEM =
+{
+      0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   4,   5,   5,   6,   7,   9,
+     10,  11,  12,  14,  15,  17,  18,  20,  21,  23,  25,  27,  29,  31,  33,  35,
+     37,  40,  42,  44,  47,  49,  52,  54,  57,  59,  62,  65,  67,  70,  73,  76,
+     79,  82,  85,  88,  90,  93,  97, 100, 103, 106, 109, 112, 115, 118, 121, 124,
+    127, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 162, 165, 167, 170, 173,
+    176, 179, 182, 185, 188, 190, 193, 196, 198, 201, 203, 206, 208, 211, 213, 215,
+    218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 238, 240, 241, 243, 244,
+    245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+    255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+    245, 244, 243, 241, 240, 238, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+    218, 215, 213, 211, 208, 206, 203, 201, 198, 196, 193, 190, 188, 185, 182, 179,
+    176, 173, 170, 167, 165, 162, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131,
+    128, 124, 121, 118, 115, 112, 109, 106, 103, 100,  97,  93,  90,  88,  85,  82,
+     79,  76,  73,  70,  67,  65,  62,  59,  57,  54,  52,  49,  47,  44,  42,  40,
+     37,  35,  33,  31,  29,  27,  25,  23,  21,  20,  18,  17,  15,  14,  12,  11,
+     10,   9,   7,   6,   5,   5,   4,   3,   2,   2,   1,   1,   1,   0,   0,   0
+};
+
+/* Exponential breath: (exp(-cos(2 * PI * i / 256)) - 1/e) * 255 / (e - 1/e) */
+const uint8_t g_wave_breath[WAVE_SAMPLES] PROGMEM =
+{
+      0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   2,   2,   2,   3,
+      3,   4,   4,   4,   5,   6,   6,   7,   7,   8,   9,   9,  10,  11,  12,  13,
+     14,  15,  16,  17,  18,  19,  20,  21,  22,  24,  25,  26,  28,  29,  31,  32,
+     34,  36,  38,  39,  41,  43,  45,  47,  49,  52,  54,  56,  58,  61,  63,  66,
+     69,  71,  74,  77,  80,  83,  86,  89,  92,  95,  98, 102, 105, 109, 112, 116,
+    119, 123, 126, 130, 134, 138, 142, 145, 149, 153, 157, 161, 165, 169, 172, 176,
+    180, 184, 188, 191, 195, 199, 202, 206, 209, 213, 216, 219, 222, 225, 228, 231,
+    233, 236, 238, 240, 243, 245, 246, 248, 249, 251, 252, 253, 254, 254, 255, 255,
+    255, 255, 255, 254, 254, 253, 252, 251, 249, 248, 246, 245, 243, 240, 238, 236,
+    233, 231, 228, 225, 222, 219, 216, 213, 209, 206, 202, 199, 195, 191, 188, 184,
+    180, 176, 172, 169, 165, 161, 157, 153, 149, 145, 142, 138, 134, 130, 126, 123,
+    119, 116, 112, 109, 105, 102,  98,  95,  92,  89,  86,  83,  80,  77,  74,  71,
+     69,  66,  63,  61,  58,  56,  54,  52,  49,  47,  45,  43,  41,  39,  38,  36,
+     34,  32,  31,  29,  28,  26,  25,  24,  22,  21,  20,  19,  18,  17,  16,  15,
+     14,  13,  12,  11,  10,   9,   9,   8,   7,   7,   6,   6,   5,   4,   4,   4,
+      3,   3,   2,   2,   2,   1,   1,   1,   1,   1,   0,   0,   0,   0,   0,   0
+};
+
+/* Sawtooth: i */
+const uint8_t g_wave_sawtooth[WAVE_SAMPLES] PROGMEM =
+{
+      0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,
+     16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,
+     32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,
+     48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,
+     64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,
+     80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,
+     96,  97,  98,  99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111,
+    112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126, 127,
+    128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141, 142, 143,
+    144, 145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156, 157, 158, 159,
+    160, 161, 162, 163, 164, 165, 166, 167, 168, 169, 170, 171, 172, 173, 174, 175,
+    176, 177, 178, 179, 180, 181, 182, 183, 184, 185, 186, 187, 188, 189, 190, 191,
+    192, 193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207,
+    208, 209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222, 223,
+    224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 239,
+    240, 241, 242, 243, 244, 245, 246, 247, 248, 249, 250, 251, 252, 253, 254, 255
+};
+
+/* Output of a wave refused by wave_init(): wave_tick() writes here, never through NULL */
+static volatile uint8_t g_wave_none;
+
+uint8_t wave_init(t_wave *w, const uint8_t *table, volatile uint8_t *ocr8, volatile uint16_t *ocr16)
+{
+    w->table = table;
+    w->phase = 0;
+    w->step = 0;            /* Stopped until wave_set_period() */
+    w->amplitude = 255;
+    w->offset = 0;
+    w->ocr8 = ocr8;
+    w->ocr16 = ocr16;
+    if (!ocr8 && !ocr16)
+    {
+        w->ocr8 = &g_wave_none;
+        return WAVE_ERR_OUTPUT;
+    }
+    return WAVE_OK;
+}
+
+/*
+** The ISR can run between two writes of a 16 bit value (8 bit CPU)
+** so everything shared with wave_tick() is written with interrupts off
+*/
+void wave_set_table(t_wave *w, const uint8_t *table)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        w->table = table;
+    }
+}
+
+/*
+** step = 65536 / (ticks per period) = 65536 * 1000 / (period_ms * WAVE_TICK_HZ)
+** 0 -> waveform frozen
+*/
+void wave_set_period(t_wave *w, uint16_t period_ms)
+{
+    uint16_t step = 0;
+
+    if (period_ms != 0)
+    {
+        uint32_t s = (65536UL * 1000UL) / ((uint32_t)period_ms * WAVE_TICK_HZ);
+
+        step = (s > 0xFFFF) ? 0xFFFF : (uint16_t)s;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        w->step = step;
+    }
+}
+
+/*
+** offset + amplitude is kept under 256 (no wrap of the 8 bit output)
+*/
+void wave_set_amplitude(t_wave *w, uint8_t amplitude, uint8_t offset)
+{
+    if ((uint16_t)amplitude + offset > 255)
+        amplitude = 255 - offset;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        w->amplitude = amplitude;
+        w->offset = offset;
+    }
+}
+
+void wave_set_phase(t_wave *w, uint8_t index)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        w->phase = (uint16_t)index << 8;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef WAVE_H
+# define WAVE_H
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include <stddef.h>
+
+/*
+** Table driven waveform generator
+**  - One period = 256 samples in flash (PROGMEM, page 16 8.3 no RAM used)
+**  - Phase is 8.8 fixed point: high byte = table index, low byte = fraction
+**  - Each tick: phase += step, sample = table[phase >> 8], scaled by amplitude (hardware mul)
+**  - No division in the ISR, the step is computed once in main by wave_set_period()
+**
+** Channel output
+**  - ocr16 -> 16 bit compare register (OCR1A / OCR1B)
+**  - ocr8  -> 8 bit compare register (OCR0A / OCR0B / OCR2A / OCR2B, RGB channels of pwm.h)
+**  - Same tables and same tick can drive the 3 RGB channels (use phase offsets for colors)
+**  - wave_init() refuses a wave with no output (WAVE_ERR_OUTPUT), its ticks then go nowhere
+**
+** libemb is built with WAVE_TICK_HZ 100: another rate -> lib/wave.c in the SRC of the
+** exercise with -DWAVE_TICK_HZ=n (lib/Makefile)
+*/
+
+#ifndef WAVE_TICK_HZ
+# define WAVE_TICK_HZ 100      /* How many times wave_tick() is called per second */
+#endif
+
+#define WAVE_SAMPLES 256
+
+#define WAVE_OK         0
+#define WAVE_ERR_OUTPUT 1       /* ocr8 and ocr16 both NULL */
+
+typedef struct s_wave
+{
+    const uint8_t       *table;     /* PROGMEM table, 256 samples (0 ~ 255) */
+    uint16_t            phase;      /* 8.8 fixed point index */
+    uint16_t            step;       /* Phase increment per tick */
+    uint8_t             amplitude;  /* 0 ~ 255 (255 -> full scale) */
+    uint8_t             offset;     /* Added after scaling */
+    volatile uint8_t    *ocr8;      /* 8 bit output register (or NULL) */
+    volatile uint16_t   *ocr16;     /* 16 bit output register (or NULL) */
+}   t_wave;
+
+extern const uint8_t g_wave_sine[WAVE_SAMPLES] PROGMEM;
+extern const uint8_t g_wave_breath[WAVE_SAMPLES] PROGMEM;
+extern const uint8_t g_wave_sawtooth[WAVE_SAMPLES] PROGMEM;
+
+uint8_t wave_init(t_wave *w, const uint8_t *table, volatile uint8_t *ocr8, volatile uint16_t *ocr16);
+void    wave_set_table(t_wave *w, const uint8_t *table);
+void    wave_set_period(t_wave *w, uint16_t period_ms);
+void    wave_set_amplitude(t_wave *w, uint8_t amplitude, uint8_t offset);
+void    wave_set_phase(t_wave *w, uint8_t index);
+
+/*
+** Called from the timer ISR (inline, so the ISR does not save every register for a call)
+** value = offset + sample * (amplitude + 1) / 256  -> two 8x8 mul and a shift
+*/
+static inline void wave_tick(t_wave *w)
+{
+    w->phase += w->step;
+
+    uint8_t sample = pgm_read_byte(&w->table[w->phase >> 8]);
+    uint8_t value = w->offset + (uint8_t)(((uint16_t)sample * w->amplitude + sample) >> 8);
+
+    if (w->ocr16)
+        *w->ocr16 = value;
+    else
+        *w->ocr8 = value;
+}
+
+#endif
@@ -1,20 +1,21 @@
 #include <avr/io.h>
+#include "board.h"
 
 int main(void)
 {
     /*
-    ** Pin mode setting. (Port B 0 pin set to output)
-    ** DDRB: Data Direction Register for Port B
-    ** DDB0: Data Direction B port 0
+    ** Pin mode setting. (LED D1 set to output, PB0 in lib/board.h)
+    ** DDRx: Data Direction Register of the LED port
+    ** PIN_OUTPUT: DDRB |= (1 << DDB0), one sbi
     */
-    DDRB |= (1 << DDB0);
+    PIN_OUTPUT(LED_D1);
 
 
     /*
     ** Change pin status
-    ** PORTB (PORT B Data Register)
+    ** PORTx (PORT Data Register), PIN_SET: PORTB |= (1 << PORTB0)
     */
-    PORTB |= (1 << PORTB0);
+    PIN_SET(LED_D1);
 
     while (1)
     {
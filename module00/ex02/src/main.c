@@ -1,27 +1,36 @@
 #include <avr/io.h>
 #include <util/delay.h>
+#include "input.h"
+#include "board.h"
 
 int main(void)
 {
     /*
-    ** Pin mode setting. (Port B 0 pin set to output)
-    ** DDRB: Data Direction Register for Port B
-    ** DDB0: Data Direction B port 0
+    ** Pin mode setting. (LED D1 set to output, PB0 in lib/board.h)
+    ** DDRx: Data Direction Register of the LED port
     */
-    DDRB |= (1 << DDB0);
+    PIN_OUTPUT(LED_D1);
+
+    systime_init();
+    input_watch(PIN_PORT(SW1), PIN_MASK(SW1));    // SW1 change -> event (PCINT18 on PD2)
+    sei();
 
     /*
-    ** PIND - The Port D Input Pins Address
+    ** event.level: PINx of the switch port (PIND - The Port D Input Pins Address)
+    ** CPU sleeps until SW1 changes (no more polling)
     */
     while (1)
     {
-        if (!(PIND & (1 << PIND2)))
+        t_input_event event;
+
+        input_wait(&event);
+        if (!(event.level & PIN_MASK(SW1)))
         {
-            PORTB |= (1 << PORTB0); // B port 0 -> HIGH(5V) --> LED ON 
+            PIN_SET(LED_D1);    // LED pin -> HIGH(5V) --> LED ON
         }
         else
         {
-            PORTB &= ~(1 << PORTB0);    // B port 0 --> LOW(0V) --> LED OFF
+            PIN_CLR(LED_D1);    // LED pin --> LOW(0V) --> LED OFF
         }
     }
 
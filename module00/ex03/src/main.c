@@ -1,30 +1,30 @@
 #include <avr/io.h>
 #include <util/delay.h>
+#include "input.h"
+#include "board.h"
 
 
 /*
 **  Debouncing: Noise filttering
 **  Noise come from chattering (bounced multiple time)
+**  First edge is taken, the next ones are ignored for 20ms (input.h lockout)
 */
 int main(void)
 {
-    DDRB |= (1 << DDB0);    // Pin mode setting (like init the variable)
+    PIN_OUTPUT(LED_D1);     // Pin mode setting (like init the variable)
+
+    systime_init();
+    input_watch(PIN_PORT(SW1), PIN_MASK(SW1));
+    sei();
 
     while (1)
     {
-        if (!(PIND & (1 << PIND2)))
-        {
-            _delay_ms(20);   // to avoid bound effect
+        t_input_event event;
 
-            if (!(PIND & (1 << PIND2))) // Checking buttons pressed after 20ms
-            {
-                PORTB ^= (1 << PORTB0); // Used XOR operator (effective way to turn on(off) the machine)
-                
-                while (!(PIND & (1 << PIND2)))  // When the button is pushed, do nothing
-                {
-                    ;
-                }
-            }
+        input_wait(&event);     // Sleep until SW1 changes
+        if (INPUT_FELL(&event, PIN_MASK(SW1)))   // Pressed (active low)
+        {
+            PIN_TOGGLE(LED_D1);     // 1 written to PINx toggles the pin (page 60), one out instead of PORTB ^=
         }
     }
 }
\ No newline at end of file
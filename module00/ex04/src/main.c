@@ -1,5 +1,32 @@
 #include <avr/io.h>
 #include <util/delay.h>
+#include "bam.h"
+#include "input.h"
+#include "debounce.h"
+#include "gesture.h"
+#include "gpio.h"       /* LEDs D1 ~ D4, SW1 / SW2 (lib/board.h) */
+#include <avr/sleep.h>
+
+#define LED_LEVEL 255   /* Brightness of a LED which is ON (0 ~ 255, bit angle modulation) */
+#define LED_MASK BOARD_GROUP_MASK(BOARD_LED)
+#define SW_MASK BOARD_GROUP_MASK(BOARD_SW)
+#define TICK_MS 10      // Debounce + gesture tick
+
+_Static_assert(BOARD_ONE_PORT(BOARD_LED), "board.h: bam drives the LEDs on one port");
+
+/*
+** Gestures (ticks of 10ms)
+**  - press: one step, hold 500ms: auto repeat from 200ms down to 30ms
+**  - double click: SW1 -> 15, SW2 -> 0
+*/
+const t_gesture_cfg g_button_cfg[2] =
+{
+    /* mask, double, long, repeat start, repeat min, repeat step */
+    { PIN_MASK(SW1), 30, 50, 20, 3, 3 },
+    { PIN_MASK(SW2), 30, 50, 20, 3, 3 },
+};
+t_gesture g_button[2];
+t_debounce g_switch;
 
 /*
 ** DDB3: Special functions
@@ -8,44 +35,86 @@
 */
 void update_leds(unsigned char count)
 {
-    PORTB = 0;  // Vide canvas
+    // Re-mapping (bit i -> pin of LED D(i + 1), lib/board.h)
+    bam_set(PIN_BIT(LED_D1), (count & 0b0001) ? LED_LEVEL : 0);
+    bam_set(PIN_BIT(LED_D2), (count & 0b0010) ? LED_LEVEL : 0);
+    bam_set(PIN_BIT(LED_D3), (count & 0b0100) ? LED_LEVEL : 0);
+    bam_set(PIN_BIT(LED_D4), (count & 0b1000) ? LED_LEVEL : 0);
 
-    // Re-mapping
-    if (count & 0b1000)  // if 4th bit is 1? (the value is over than 8)
-    {
-        PORTB |= (1 << PORTB4); // turn on the 4th bit
-        count ^= 0b1000; // 4th bit count 0
-    }
-    PORTB |= count; // Basic part, 0th 2nd bit send to 0th 2nd pin
+    bam_commit();   // Shown at the next frame, all LEDs at once
+}
+
+/*
+** Nothing to do until a switch moves: levels settled and no gesture in progress
+*/
+uint8_t buttons_idle(void)
+{
+    return ((gpio_switches() ^ g_switch.state) & SW_MASK) == 0 &&
+           !gesture_busy(&g_button[0]) && !gesture_busy(&g_button[1]);
+}
+
+unsigned char buttons_tick(unsigned char count)
+{
+    debounce_tick(&g_switch, gpio_switches());
+
+    uint8_t sw1 = gesture_tick(&g_button_cfg[0], &g_button[0], debounce_state(&g_switch, SW_MASK));
+    uint8_t sw2 = gesture_tick(&g_button_cfg[1], &g_button[1], debounce_state(&g_switch, SW_MASK));
+
+    if ((sw1 & (GESTURE_PRESS | GESTURE_REPEAT)) && count < 15)
+        count++;
+    if (sw1 & GESTURE_DOUBLE)
+        count = 15;
+    if ((sw2 & (GESTURE_PRESS | GESTURE_REPEAT)) && count > 0)
+        count--;
+    if (sw2 & GESTURE_DOUBLE)
+        count = 0;
+    return count;
 }
 
 int main(void)
 {
     unsigned char count = 0;
+    unsigned char shown = 0;
+    uint32_t next_tick;
+
+    gpio_leds_init();   // Only the LED pins (DDB3 assigned for)
+    bam_init(&BOARD_GROUP_REG(PORT, BOARD_LED), LED_MASK);
+    systime_init();     // Timer1 (Timer2 is used by bam)
+    input_watch(PIN_PORT(SW1), SW_MASK);
+    sei();
+    debounce_init(&g_switch, gpio_switches());
+    gesture_init(&g_button[0]);
+    gesture_init(&g_button[1]);
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    next_tick = millis();
 
-    DDRB |= (1 << DDB0) | (1 << DDB1) | (1 << DDB2) | (1 << DDB4);   // DDB3 assigned for
     while (1)
     {
-        _delay_ms(20);   // to avoid bound effect
-        if (!(PIND & (1 << PIND2)) && count < 15)
-        {
-            count++;
-            update_leds(count);
+        t_input_event event;
 
-            while (!(PIND & (1 << PIND2)))
-            {
-                ;
-            }
+        if (buttons_idle())
+        {
+            input_wait(&event);     // Sleep until SW1 or SW2 changes (no busy wait for release)
+            next_tick = millis();
         }
-        else if (!(PIND & (1 << PIND4)) && count > 0)
+        else
         {
-            count--;
-            update_leds(count);
+            sleep_mode();           // Sleep until the next interrupt (bam slot, ~0.5ms)
+        }
+        while (input_poll(&event))  // Edges are only used to wake up
+        {
+            ;
+        }
+
+        if ((int32_t)(millis() - next_tick) < 0)
+            continue;
+        next_tick += TICK_MS;
 
-            while (!(PIND & (1 << PIND4)))
-            {
-                ;
-            }
+        count = buttons_tick(count);
+        if (count != shown)
+        {
+            shown = count;
+            update_leds(count);
         }
     }
-}
\ No newline at end of file
+}
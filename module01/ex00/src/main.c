@@ -1,4 +1,5 @@
 #include <avr/io.h>
+#include "board.h"
 
 /*
 ** Calculation
@@ -24,11 +25,11 @@ void ft_delay_ms(uint16_t ms)
 
 int main(void)
 {
-    DDRB = (1 << DDB1);
+    PIN_OUTPUT(LED_D2);     /* Only the LED pin (was DDRB = (1 << DDB1)) */
 
     while (1)
     {
         ft_delay_ms(500);
-        PORTB ^= (1 << PORTB1);
+        PIN_TOGGLE(LED_D2);
     }
 }
\ No newline at end of file
@@ -1,9 +1,19 @@
 #include <avr/io.h>
+#include "periph.h"
+#include "board.h"
+
+#define TIMER1_FREQ TIMER_HZ(2)     /* Toggle twice a second -> LED blinks at 1Hz */
+#define TIMER1_MAX_PPM 0            /* Exact */
+#include "timer_cfg.h"
+
+BOARD_ASSERT(LED_D2, B, 1);    /* Toggled by OC1A */
 
 int main(void)
 {
-    // DDB1 as an output - settings
-    DDRB |= (1 << DDB1);
+    // LED D2 (PB1, OC1A) as an output - settings
+    PIN_OUTPUT(LED_D2);
+
+    periph_claim(PERIPH_TIM1);  /* Timer1 clock on (everything is gated at startup) */
     
     /*
     ** TCCR - timer register
@@ -12,23 +22,18 @@ int main(void)
     **  - Timer/Counter2: 8bit, support async (TCCR2A, TCCR2B ...)
     ** WGM12 - CTC mode (Clear Timer on Compare Match)
     */
-    TCCR1B |= (1 << WGM12);
+    TCCR1B |= TIMER1_TCCRB;    /* WGM12 + prescaler chosen by timer_cfg.h (256) */
 
     /*
     ** COM1A0 - Compare Output Mode 1 A, bit 0. Define the action when Compare match (OC1A / PORTB)
     */
     TCCR1A |= (1 << COM1A0);
 
-    /*
-    ** CS12 - Clock Select 1, bit 2 - declare speed (Prescaler)
-    */
-    TCCR1B |= ((1 << CS12));
-
     /*
     ** OCR1A - Output Compare Register 1A -> set the limit
-    ** 31249 -> (F_CPU / (FREQUENCY * PRESCALE)) - 1
+    ** 31249 -> (F_CPU / (FREQUENCY * PRESCALE)) - 1 (computed by timer_cfg.h)
     */
-    OCR1A = 31249;
+    OCR1A = TIMER1_TOP;
 
     while (1)
     {
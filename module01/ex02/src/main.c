@@ -1,23 +1,31 @@
 #include <avr/io.h>
+#include "periph.h"
+#include "board.h"
 
+#define TIMER1_FREQ TIMER_HZ(1)     /* PWM period 1 sec */
+#define TIMER1_MODE TIMER_FAST_PWM  /* TOP = ICR1 (mode 14) */
+#define TIMER1_MAX_PPM 0
+#include "timer_cfg.h"
 
-#define SET_MODE(x, num) DDR##x |= (1 << DD##x##num) /* Setting the output mode */
+
+BOARD_ASSERT(LED_D2, B, 1);    /* Driven by OC1A */
 
 
 int main(void)
 {
-    SET_MODE(B, 1);
+    PIN_OUTPUT(LED_D2);     /* Setting the output mode */
+
+    periph_claim(PERIPH_TIM1);  /* Timer1 clock on (everything is gated at startup) */
 
     TCCR1A |= (1 << COM1A1);    /* Compare Output Mode 1 A, bit 1 */
-    TCCR1B |= ((1 << CS12));    /* Define Scale (256) */
 
     /* 
     ** Fast mode setting set each wgm to 1 (Creation of Wave, NOT CTC mode)
     ** WGM11 -> TCCR1A (dataset)
     ** WGM12/WGM13 -> TCCR1B (dataset)
     */
-    TCCR1A |= (1 << WGM11);
-    TCCR1B |= (1 << WGM13) | (1 << WGM12);
+    TCCR1A |= TIMER1_TCCRA;
+    TCCR1B |= TIMER1_TCCRB;     /* WGM13 WGM12 + prescaler (256) */
     
 
     /*
@@ -29,8 +37,8 @@ int main(void)
     ** OCR1A - Output Compare Register 1A -> setting the limit
     **  - Here I will define 10% of ICR1
     */
-    ICR1 = 62499;   /* F_CPU(16000000) / prescaler(256) - 1 (counter) */
-    OCR1A = 6250;
+    ICR1 = TIMER1_TOP;   /* F_CPU(16000000) / prescaler(256) - 1 (counter) */
+    OCR1A = TIMER1_DUTY(10);
 
     while (1)
     {
@@ -1,71 +1,122 @@
 #include <avr/io.h>
+#include "periph.h"
+
+#define TIMER1_FREQ TIMER_HZ(1)     /* PWM period 1 sec */
+#define TIMER1_MODE TIMER_FAST_PWM  /* TOP = ICR1 (mode 14) */
+#define TIMER1_MAX_PPM 0
+#include "timer_cfg.h"
 #include <util/delay.h>
+#include "input.h"
+#include "debounce.h"
+#include "gesture.h"
+#include "gpio.h"       /* LED D2, SW1 / SW2 (lib/board.h) */
+#include <avr/sleep.h>
 
-#define PIN_PRESS(num) (PIND & (1 << num)) /* Define SW1 and SW2 pressed PID2 == 2(bit) // PIND4 == 4(bit) */
-#define SET_MODE(x, num) DDR##x |= (1 << DD##x##num)  /* Define output */
 #define MAX_COUNT 10    /* Define max duty recycle (100%) */
 #define MIN_COUNT 1     /* Define min duty recycle (10%) */
-#define TEN_PERC 6250   /* 10% of TOP value (ICR1) */
+#define TEN_PERC TIMER1_DUTY(10)   /* 10% of TOP value (ICR1) */
+#define SW_MASK BOARD_GROUP_MASK(BOARD_SW)
+#define TICK_MS 10      /* Debounce + gesture tick */
+
+BOARD_ASSERT(LED_D2, B, 1);    /* Driven by OC1A */
 
-void anti_bounce(int num)
+/*
+** Gestures (ticks of 10ms)
+**  - press: one step, hold 500ms: auto repeat from 200ms down to 60ms
+**  - double click: SW1 -> 100%, SW2 -> 10%
+*/
+const t_gesture_cfg g_button_cfg[2] =
 {
-    while (!PIN_PRESS(num))
-    {
-        ;
-    }
-    _delay_ms(20);
-}
+    /* mask, double, long, repeat start, repeat min, repeat step */
+    { PIN_MASK(SW1), 30, 50, 20, 6, 3 },
+    { PIN_MASK(SW2), 30, 50, 20, 6, 3 },
+};
+t_gesture g_button[2];
+t_debounce g_switch;
 
+/*
+** Nothing to do until a switch moves: levels settled and no gesture in progress
+*/
+uint8_t buttons_idle(void)
+{
+    return ((gpio_switches() ^ g_switch.state) & SW_MASK) == 0 &&
+           !gesture_busy(&g_button[0]) && !gesture_busy(&g_button[1]);
+}
 
-void is_pressed(int num, uint8_t *counter)
+/*
+** SW1 -> +10%, SW2 -> -10% (press and auto repeat), double click -> 100% / 10%
+*/
+void buttons_tick(uint8_t *counter)
 {
-    if (num == 2 && (*counter) < MAX_COUNT) 
-    {
-        if (!PIN_PRESS(num)) 
-        {
-            (*counter)++;
-            OCR1A = (*counter) * TEN_PERC;
-            anti_bounce(num);
-        }
-    }
-    else if (num == 4 && (*counter) > MIN_COUNT)
-    {
-        if (!PIN_PRESS(num))
-        {
-            (*counter)--;
-            OCR1A = (*counter) * TEN_PERC;
-            anti_bounce(num);
-        }
-    }
-    else
-    {
-        return;
-    }
-    
+    debounce_tick(&g_switch, gpio_switches());
+
+    uint8_t sw1 = gesture_tick(&g_button_cfg[0], &g_button[0], debounce_state(&g_switch, SW_MASK));
+    uint8_t sw2 = gesture_tick(&g_button_cfg[1], &g_button[1], debounce_state(&g_switch, SW_MASK));
+
+    if ((sw1 & (GESTURE_PRESS | GESTURE_REPEAT)) && (*counter) < MAX_COUNT)
+        (*counter)++;
+    if (sw1 & GESTURE_DOUBLE)
+        (*counter) = MAX_COUNT;
+    if ((sw2 & (GESTURE_PRESS | GESTURE_REPEAT)) && (*counter) > MIN_COUNT)
+        (*counter)--;
+    if (sw2 & GESTURE_DOUBLE)
+        (*counter) = MIN_COUNT;
+
+    OCR1A = (*counter) * TEN_PERC;
 }
 
 
 int main(void)
 {
-    SET_MODE(B, 1);
+    PIN_OUTPUT(LED_D2);     /* Define output */
+
+    periph_claim(PERIPH_TIM1);  /* Timer1 clock on (everything is gated at startup) */
 
     TCCR1A |= (1 << COM1A1);    /* Define output */
-    TCCR1B |= ((1 << CS12));    /* Define prescaler as 256 (cycle) */
     
     /* Fast mode setting */
-    TCCR1A |= (1 << WGM11);
-    TCCR1B |= (1 << WGM13) | (1 << WGM12);
+    TCCR1A |= TIMER1_TCCRA;
+    TCCR1B |= TIMER1_TCCRB;     /* WGM13 WGM12 + prescaler (256) */
 
     uint8_t counter = MIN_COUNT;
     
     // TOP value
-    ICR1 = 62499;   /* F_CPU(16000000) / prescaler(256) - 1 (counter) */
+    ICR1 = TIMER1_TOP;   /* F_CPU(16000000) / prescaler(256) - 1 (counter) */
     
     OCR1A = (counter) * TEN_PERC;
     
+    systime_init();     /* Timer2 (SYSTIME_TIMER=2), Timer1 is the PWM */
+    input_watch(PIN_PORT(SW1), SW_MASK);
+    debounce_init(&g_switch, gpio_switches());
+    gesture_init(&g_button[0]);
+    gesture_init(&g_button[1]);
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sei();
+
+    uint32_t next_tick = millis();
+
     while (1)
     {
-        is_pressed(2, &counter);
-        is_pressed(4, &counter);
+        t_input_event event;
+
+        if (buttons_idle())
+        {
+            input_wait(&event);     /* Sleep until SW1 / SW2 changes */
+            next_tick = millis();
+        }
+        else
+        {
+            sleep_mode();           /* Sleep until the next interrupt (systime, ~1ms) */
+        }
+        while (input_poll(&event))  /* Edges are only used to wake up */
+        {
+            ;
+        }
+
+        if ((int32_t)(millis() - next_tick) < 0)
+            continue;
+        next_tick += TICK_MS;
+
+        buttons_tick(&counter);
     }
 }
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include "emb.h"
+#include "shell.h"
+#include "systime.h"
+#include "pwm.h"
+#include "adc.h"
+#include "twi.h"
+#include "mem.h"
+#include "load.h"
+#include <string.h>
+#include <stdlib.h>
+
+/*
+**-------------------------------
+** help / logout
+**-------------------------------
+*/
+void cmd_help(t_shell_args *args)
+{
+    (void)args;
+    shell_help();
+}
+
+void cmd_logout(t_shell_args *args)
+{
+    (void)args;
+    logout();
+}
+
+/*
+**-------------------------------
+** rgb - lib/pwm.c (Timer0 / Timer2), started on the first use
+**-------------------------------
+*/
+static uint8_t g_rgb_ready = 0;
+
+void cmd_rgb(t_shell_args *args)
+{
+    uint16_t color[3];
+
+    if (args->argc != 4)
+    {
+        uart_puts_P(PSTR("usage: rgb <r> <g> <b>\r\n"));
+        return;
+    }
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        if (!shell_parse_u16(args->argv[i + 1], &color[i]) || color[i] > 255)
+        {
+            uart_puts_P(PSTR("rgb: 0 ~ 255\r\n"));
+            return;
+        }
+    }
+    if (!g_rgb_ready)
+    {
+        init_rgb();
+        g_rgb_ready = 1;
+    }
+    set_rgb(color[0], color[1], color[2]);
+}
+
+/*
+**-------------------------------
+** adc / temp - lib/adc.c, the ADC clock only runs during the command
+**-------------------------------
+*/
+static uint16_t adc_sample(uint8_t admux)
+{
+    init_adc();
+    uint16_t value = adc_read(admux);
+    adc_stop();                         /* ADEN off, clock off until the next command */
+    return value;
+}
+
+void cmd_adc(t_shell_args *args)
+{
+    uint16_t channel = 0;
+
+    if (args->argc > 1 && (!shell_parse_u16(args->argv[1], &channel) || channel > 7))
+    {
+        uart_puts_P(PSTR("adc: channel 0 ~ 7\r\n"));
+        return;
+    }
+    uart_put_u32(adc_sample(ADC_CHANNEL(channel)));
+    uart_puts_P(PSTR("\r\n"));
+}
+
+/*
+** Internal sensor: channel 8 with the 1.1V reference (page 256 24.8)
+** Same rough conversion as module05/ex03: 1.08mV per step, 1mV per K
+** Offset of each chip (up to +/-10C, page 256) saved with "set temp_off <C>"
+*/
+void cmd_temp(t_shell_args *args)
+{
+    (void)args;
+    int32_t celsius = ((int32_t)adc_sample(ADC_TEMPERATURE) * 108) / 100 - 273;
+    const char *offset = kv_get("temp_off");
+
+    if (offset)
+        celsius += atoi(offset);    /* Calibration (set temp_off <C>) */
+
+    if (celsius < 0)
+    {
+        uart_tx('-');
+        celsius = -celsius;
+    }
+    uart_put_u32(celsius);
+    uart_puts_P(PSTR(" C\r\n"));
+}
+
+/*
+**-------------------------------
+** i2c scan - SLA+W on every 7 bit address, ACK -> a device is there (page 225)
+**-------------------------------
+*/
+void cmd_i2c(t_shell_args *args)
+{
+    uint8_t found = 0;
+
+    if (args->argc != 2 || strcmp_P(args->argv[1], PSTR("scan")) != 0)
+    {
+        uart_puts_P(PSTR("usage: i2c scan\r\n"));
+        return;
+    }
+    i2c_init();
+
+    for (uint8_t address = 0x08; address < 0x78; address++)   /* 0x00 ~ 0x07 / 0x78 ~ reserved */
+    {
+        if (i2c_start() != TW_START)
+            break;
+        if (i2c_write((address << 1) | TW_WRITE) == TW_MT_SLA_ACK)
+        {
+            uart_puts_P(PSTR("0x"));
+            uart_put_hex8(address);
+            uart_puts_P(PSTR("\r\n"));
+            found++;
+        }
+        i2c_stop();
+    }
+    i2c_deinit();
+
+    uart_put_u32(found);
+    uart_puts_P(PSTR(" device(s)\r\n"));
+}
+
+/*
+**-------------------------------
+** stats
+**-------------------------------
+*/
+void cmd_stats(t_shell_args *args)
+{
+    (void)args;
+    uart_puts_P(PSTR("uptime: "));
+    uart_put_u32(millis());
+    uart_puts_P(PSTR(" ms\r\nlines: "));
+    uart_put_u32(g_shell_stats.lines);
+    uart_puts_P(PSTR("\r\nunknown: "));
+    uart_put_u32(g_shell_stats.unknown);
+    uart_puts_P(PSTR("\r\ndropped: "));
+    uart_put_u32(g_shell_stats.dropped);
+    uart_puts_P(PSTR("\r\n"));
+}
+
+/*
+**-------------------------------
+** load - lib/load.c, share of the last ~1s of each account (emb.h), in 0.1%
+**-------------------------------
+*/
+#if LOAD
+static void load_line(const char *name, uint16_t permille)
+{
+    uart_puts_P(name);
+    uart_put_u32(permille / 10);
+    uart_tx('.');
+    uart_tx('0' + permille % 10);
+    uart_puts_P(PSTR(" %\r\n"));
+}
+#endif
+
+void cmd_load(t_shell_args *args)
+{
+    (void)args;
+#if LOAD
+    load_line(PSTR("busy: "), load_busy_permille());
+    load_line(PSTR("  USART_RX_vect: "), load_permille(LOAD_RX));
+    load_line(PSTR("  shell: "), load_permille(LOAD_SHELL));
+    load_line(PSTR("idle: "), load_permille(LOAD_IDLE));
+    uart_puts_P(PSTR("switch: "));
+    uart_put_u32(load_switch_cycles());
+    uart_puts_P(PSTR(" cycles\r\n"));
+#else
+    uart_puts_P(PSTR("load: not built in (make LOAD=1)\r\n"));
+#endif
+}
+
+/*
+**-------------------------------
+** mem - lib/mem.c, stack painted at startup: the peak is the deepest since reset
+**-------------------------------
+*/
+static void mem_line(const char *name, uint16_t bytes)
+{
+    uart_puts_P(name);
+    uart_put_u32(bytes);
+    uart_puts_P(PSTR(" bytes\r\n"));
+}
+
+void cmd_mem(t_shell_args *args)
+{
+    t_mem_stats mem;
+
+    (void)args;
+    mem_stats(&mem);
+    mem_line(PSTR("data: "), mem.data);
+    mem_line(PSTR("bss: "), mem.bss);
+    mem_line(PSTR("stack peak: "), mem.stack_peak);
+    mem_line(PSTR("gap: "), mem.gap);
+    mem_line(PSTR("free now: "), mem.stack_free);
+}
+
+/*
+**-------------------------------
+** set / get - key / value store (lib/kvstore.c, EEPROM)
+**  - user / pass: login
+**  - temp_off: calibration added to "temp" (C)
+**-------------------------------
+*/
+static void var_print(const char *key, const char *value)
+{
+    uart_puts(key);
+    uart_puts_P(PSTR(" = "));
+    if (strcmp_P(key, PSTR("pass")) == 0)
+        uart_puts_P(PSTR("****"));
+    else
+        uart_puts(value);
+    uart_puts_P(PSTR("\r\n"));
+}
+
+void cmd_set(t_shell_args *args)
+{
+    if (args->argc != 3)
+    {
+        uart_puts_P(PSTR("usage: set <key> <value>\r\n"));
+        return;
+    }
+    switch (kv_set(args->argv[1], args->argv[2]))
+    {
+        case KV_ERR_SIZE:
+            uart_puts_P(PSTR("set: key 11 / value 19 chars max\r\n"));
+            break;
+        case KV_ERR_FULL:
+            uart_puts_P(PSTR("set: table full\r\n"));
+            break;
+        case KV_ERR_BUSY:
+            uart_puts_P(PSTR("set: EEPROM busy, try again\r\n"));
+            break;
+        case KV_ERR_SPACE:
+            uart_puts_P(PSTR("set: EEPROM full\r\n"));
+            break;
+    }
+}
+
+void cmd_get(t_shell_args *args)
+{
+    const char *value;
+
+    if (args->argc == 1)
+    {
+        for (uint8_t i = 0; i < KV_ENTRIES; i++)
+        {
+            if (kv_key(i))
+                var_print(kv_key(i), kv_value(i));
+        }
+        return;
+    }
+    if ((value = kv_get(args->argv[1])))
+        var_print(args->argv[1], value);
+    else
+    {
+        uart_puts(args->argv[1]);
+        uart_puts_P(PSTR(": not set\r\n"));
+    }
+}
+
+/*
+**-------------------------------
+** trace - lib/trace.c ring in binary, read by tools/trace_stats.py (make TRACE=1)
+**-------------------------------
+*/
+void cmd_trace(t_shell_args *args)
+{
+    (void)args;
+#if TRACE
+    trace_dump();
+    uart_puts_P(PSTR("\r\n"));
+#else
+    uart_puts_P(PSTR("trace: not built in (make TRACE=1)\r\n"));
+#endif
+}
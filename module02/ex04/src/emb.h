@@ -1,9 +1,20 @@
 #ifndef EMB_H
 # define EMB_H
 
+#ifndef F_CPU
+# define F_CPU 16000000UL     /* Normally given by the Makefile (-DF_CPU) */
+#endif
+
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
+#include "periph.h"
+#include "board.h"      /* LED_D1: on while logged in */
+#include "systime.h"
+#include "kvstore.h"
+#include "uart.h"
+#include "trace.h"      /* make TRACE=1 */
+#include "load.h"       /* make LOAD=1 */
 
 typedef enum e_state
 {
@@ -14,10 +25,17 @@ typedef enum e_state
     STATE_ERROR
 }   t_state;
 
-#define F_CPU 16000000UL
-#define UART_BAUDERATE 115200
-#define UBRRN ((F_CPU / (8 * UART_BAUDERATE)) - 1)   /* UBRRN value (F_CPU / (8 * UART_BAUDERATE)) - 1 // document - p.182 20-1 */
-#define SET_MODE(x, num) DDR##x |= (1 << DD##x##num)
-#define PRINT_MODE(x, num) PORT##x |= (1 << PORT##x##num);
+/* Trace ids (make TRACE=1, "trace" command) */
+#define TRACE_RX        0
+#define TRACE_SHELL     1
+
+/* CPU load accounts (make LOAD=1, "load" command), 0 is LOAD_IDLE: the polling loop */
+#define LOAD_RX         1
+#define LOAD_SHELL      2
+
+#define DEFAULT_USER "spectre"   /* Until "set user" / "set pass" */
+#define DEFAULT_PASS "spectre"
+
+void logout(void);
 
 #endif
\ No newline at end of file
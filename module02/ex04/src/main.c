@@ -1,86 +1,21 @@
 #include "emb.h"
+#include "shell.h"
 
 char g_username_buffer[32];
 char g_password_buffer[32];
+char g_line[SHELL_LINE_SIZE];   /* Shell line (logged in) */
 
-int g_input_ready = 0;  /* 0: not complete / 1: completed */
+volatile uint8_t g_input_ready = 0;  /* 0: not complete / 1: completed */
 
 volatile uint8_t g_buffer_index = 0;    /* To check index of string */
 
 volatile t_state g_current_state = STATE_WAIT_USERNAME; /* To check current state of machine */
 
 /*
-* Wait 2~3 sec, beacase of reset
+* Wait 2~3 sec, beacase of reset (Arduino bootloader: opening the port resets the board)
+* With bootloader/ (make flash BOOT=1) the wait is 0.5 sec, none at power-on
 */
 
-void uart_init(unsigned int ubrr)
-{
-    /* Set baud rate */
-    UBRR0H = (unsigned char)(ubrr >> 8);    /* Upper Rate part */
-    UBRR0L = (unsigned char)(ubrr);         /* Lower Rate part */
-
-    /*
-    ** UCSR0B - USART Control and Status Register 0 B
-    ** RXEN0 - Receiver Enable
-    ** TXENO - Transmitter Enable
-    */
-    UCSR0B |= (1 << RXEN0) | (1 << TXEN0);  /* Enable Receiver and Transmitter */
-    
-    /*
-    ** Set frame format: 8N1 (8 data bits, No Parity, 1 stop bit)
-    ** UCSR0C - USART Control and Status Register 0 C
-    **
-    ** (3 << UCSZ00) sets UCSZ01=1 and UCSZ00=1. Combined with UCSZ02=0 (default in UCSR0B),
-    ** this selects 8-bit character size.
-    **
-    ** UPM0n bits (Parity) are 0 by default -> No Parity.
-    ** USBS0 bit (Stop Bit) is 0 by default -> 1 Stop Bit.
-    */
-    UCSR0C = (3 << UCSZ00);  /* Format to 8N1 (N - No parity, and Data is 8 bits)*/
-
-    /*
-    ** UCSR0A - USART Control and Status Register 0 A
-    ** U2X0 - USART Double Speed 0 (Data speed optimization)
-    */
-    UCSR0A |= (1 << U2X0); /* Enabling double transfer speed, and divide by two baudrate (Reduce Error Rate) */
-}
-
-void uart_tx(char c)
-{
-    /*
-    ** UCSR0A - USART Control and Status Register 0 A
-    ** UDRE0 - USART Data Register Empty 0
-    */
-    while (!(UCSR0A & (1 << UDRE0)))   /* Wait for empty transmit buffer */
-    {
-        ;
-    }
-
-    /* UDR0 - USART Data Register 0  (REAL BOX which put the data)*/
-    UDR0 = c;                           /* Put data into buffer, sends the data */
-}
-
-void uart_puts(const char *str)
-{
-    while (*str)
-    {
-        uart_tx(*str++);
-    }
-}
-
-char uart_rx(void)
-{
-    /*
-    ** RXC0 - USART Receive Complete
-    */
-    while (!(UCSR0A & (1 << RXC0)))   /* Wait for receive buffer */
-    {
-        ;
-    }
-
-    return UDR0;
-}
-
 int	ft_strncmp(const char *s1, const char *s2, int n)
 {
 	int	i;
@@ -100,13 +35,41 @@ int	ft_strncmp(const char *s1, const char *s2, int n)
 }
 
 /*
-** Interrupt Service Routine for receiving data
-** USART_RX_vect - Receive controller
-** ISR - Interrupt Service Routine (Stop while(1) and jump to this function)
+** One received byte: login echo / mask or shell line editing
+** Inlined in the ISR, split out so the trace exit is taken on every return
 */
-ISR(USART_RX_vect)
+static inline __attribute__((always_inline)) void rx_byte(char c)
 {
-    char c = UDR0;
+    if (g_input_ready)  /* Line not handled yet (command running): drop */
+    {
+        g_shell_stats.dropped++;
+        return;
+    }
+
+    if (g_current_state == STATE_LOGGED_IN)
+    {
+        if (c == '\r' || c == '\n')
+        {
+            g_line[g_buffer_index] = '\0';
+            g_buffer_index = 0;
+            g_input_ready = 1;
+            uart_puts("\r\n");
+        }
+        else if (c == 127 || c == 8)
+        {
+            if (g_buffer_index > 0)
+            {
+                g_buffer_index--;
+                uart_puts("\b \b");
+            }
+        }
+        else if (g_buffer_index < (SHELL_LINE_SIZE - 1))
+        {
+            g_line[g_buffer_index++] = c;
+            uart_tx(c);
+        }
+        return;
+    }
 
     if (c == '\r' || c == '\n') /* When user puts enter */
     {
@@ -155,21 +118,61 @@ ISR(USART_RX_vect)
     }
 }
 
+/*
+** Interrupt Service Routine for receiving data
+** USART_RX_vect - Receive controller
+** ISR - Interrupt Service Routine (Stop while(1) and jump to this function)
+*/
+ISR(USART_RX_vect)
+{
+    TRACE_ENTER(TRACE_RX);
+    LOAD_ENTER(LOAD_RX);
+    rx_byte(UDR0);
+    LOAD_EXIT();
+    TRACE_EXIT(TRACE_RX);
+}
+
+/* Shell "logout": back to the first state of the machine */
+void logout(void)
+{
+    PIN_CLR(LED_D1);
+    g_current_state = STATE_WAIT_USERNAME;
+    uart_puts("Username: ");
+}
+
 int main(void)
 {
-    const char *correct_user = "spectre";
-    const char *correct_pass = "spectre";
+    const char *correct_user;
+    const char *correct_pass;
 
-    uart_init(UBRRN);
+    uart_init(UART_UBRR(UART_BAUDRATE));    /* lib/uart.c, 115200 8N1 */
     UCSR0B |= (1 << RXCIE0);    /* Enable the RX Complete Interrupt */
+    systime_init();             /* Uptime (stats) */
+    kv_init();                  /* Saved settings (EEPROM) -> RAM */
+    LOAD_INIT();                /* make LOAD=1: after systime, Timer1 at clk/1 (SYSTIME_CLK1) */
+    TRACE_INIT();               /* make TRACE=1: Timer1 shared with systime (SYSTIME_CLK1) */
+    TRACE_NAME(TRACE_RX, "USART_RX_vect");
+    TRACE_NAME(TRACE_SHELL, "shell_exec");
     sei();
 
-    SET_MODE(B, 0);
+    PIN_OUTPUT(LED_D1);
 
     uart_puts("Username: ");
 
     while (1)
         {
+            if (g_input_ready == 1 && g_current_state == STATE_LOGGED_IN)
+            {
+                LOAD_ENTER(LOAD_SHELL);
+                TRACE_ENTER(TRACE_SHELL);
+                shell_exec(g_line);     /* Parsed in place: the ISR drops bytes until the flag is reset */
+                TRACE_EXIT(TRACE_SHELL);
+                if (g_current_state == STATE_LOGGED_IN)
+                    shell_prompt();
+                g_input_ready = 0;
+                LOAD_EXIT();
+            }
+
             if (g_input_ready == 1)
             {
                 g_input_ready = 0;  /* Flag reset */
@@ -180,6 +183,9 @@ int main(void)
                 }
                 else if (g_current_state == STATE_CHECKING)
                 {
+                    /* "set user <name>" / "set pass <word>" change them (kept in EEPROM) */
+                    correct_user = kv_get("user") ? kv_get("user") : DEFAULT_USER;
+                    correct_pass = kv_get("pass") ? kv_get("pass") : DEFAULT_PASS;
                     if (ft_strncmp(g_username_buffer, correct_user, 32) == 0 &&
                         ft_strncmp(g_password_buffer, correct_pass, 32) == 0)
                     {
@@ -189,6 +195,8 @@ int main(void)
                         uart_puts(correct_user);
                         uart_puts("\r\n");
                         uart_puts("Shall we play a game?\r\n");
+                        uart_puts("(help: list of commands)\r\n");
+                        shell_prompt();
                     }
                     else
                     {
@@ -201,7 +209,7 @@ int main(void)
 
             if (g_current_state == STATE_LOGGED_IN)
             {
-                PRINT_MODE(B, 0);
+                PIN_SET(LED_D1);
             }
         }
 }
@@ -0,0 +1,117 @@
+#include "emb.h"
+#include "shell.h"
+#include "shell_cmds.h"
+
+t_shell_stats g_shell_stats;
+
+/*
+** Same hash as tools/gen_cmd_hash.py (8 bit, odd multiplier, no division)
+*/
+#define SHELL_HASH_STEP(h, c) ((uint8_t)((h) * SHELL_HASH_MUL + (uint8_t)(c)))
+
+/*
+** Cut the line in words (space / tab separated), in place
+** The hash of the first word is computed on the way (no second pass over it)
+*/
+static uint8_t shell_split(char *line, t_shell_args *args)
+{
+    uint8_t hash = SHELL_HASH_SEED;
+
+    args->argc = 0;
+    while (*line)
+    {
+        while (*line == ' ' || *line == '\t')
+            *line++ = '\0';
+        if (!*line)
+            break;
+        if (args->argc == SHELL_MAX_ARGS)       /* Extra words are ignored */
+            break;
+        args->argv[args->argc] = line;
+        while (*line && *line != ' ' && *line != '\t')
+        {
+            if (args->argc == 0)
+                hash = SHELL_HASH_STEP(hash, *line);
+            line++;
+        }
+        args->argc++;
+    }
+    return hash & (SHELL_HASH_SIZE - 1);
+}
+
+void shell_exec(char *line)
+{
+    t_shell_args args;
+    t_shell_cmd cmd;
+    uint8_t slot = shell_split(line, &args);
+
+    if (args.argc == 0)
+        return;
+    g_shell_stats.lines++;
+
+    memcpy_P(&cmd, &g_shell_cmds[slot], sizeof(cmd));
+    if (cmd.name == 0 || strcmp_P(args.argv[0], cmd.name) != 0)
+    {
+        g_shell_stats.unknown++;
+        uart_puts(args.argv[0]);
+        uart_puts_P(PSTR(": unknown command (help)\r\n"));
+        return;
+    }
+    cmd.handler(&args);
+}
+
+void shell_prompt(void)
+{
+    uart_puts_P(PSTR("> "));
+}
+
+/* Table order (hash order) */
+void shell_help(void)
+{
+    t_shell_cmd cmd;
+
+    for (uint8_t i = 0; i < SHELL_HASH_SIZE; i++)
+    {
+        memcpy_P(&cmd, &g_shell_cmds[i], sizeof(cmd));
+        if (cmd.name == 0)
+            continue;
+        uart_puts_P(cmd.name);
+        uart_puts_P(PSTR("\t"));
+        uart_puts_P(cmd.help);
+        uart_puts_P(PSTR("\r\n"));
+    }
+}
+
+/*
+** Decimal, or hex with 0x
+** 0 -> not a number or more than 16 bit
+*/
+uint8_t shell_parse_u16(const char *str, uint16_t *value)
+{
+    uint32_t result = 0;
+    uint8_t base = 10;
+
+    if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+    {
+        base = 16;
+        str += 2;
+    }
+    if (!*str)
+        return 0;
+    while (*str)
+    {
+        uint8_t digit;
+
+        if (*str >= '0' && *str <= '9')
+            digit = *str - '0';
+        else if (base == 16 && (*str | 0x20) >= 'a' && (*str | 0x20) <= 'f')
+            digit = (*str | 0x20) - 'a' + 10;
+        else
+            return 0;
+        result = result * base + digit;
+        if (result > 0xFFFF)
+            return 0;
+        str++;
+    }
+    *value = (uint16_t)result;
+    return 1;
+}
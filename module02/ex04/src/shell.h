@@ -0,0 +1,51 @@
+#ifndef SHELL_H
+# define SHELL_H
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+/*
+** Line shell behind the login
+**  - The RX interrupt fills the line (echo, backspace), Enter hands it to the main loop
+**  - Zero copy parsing: the words are cut in place ('\0' written over the spaces),
+**    argv points into the line buffer
+**  - Dispatch: perfect hash of the first word (computed while cutting it) -> one slot
+**    of the PROGMEM table -> one strcmp_P() -> handler
+**    Cost depends on the length of the word, not on the number of commands
+**
+** The table is generated (shell_cmds.h, tools/gen_cmd_hash.py from commands.txt)
+*/
+
+#define SHELL_LINE_SIZE     64
+#define SHELL_MAX_ARGS      6
+
+typedef struct s_shell_args
+{
+    uint8_t     argc;
+    char        *argv[SHELL_MAX_ARGS];      /* argv[0] = command */
+}   t_shell_args;
+
+typedef struct s_shell_cmd
+{
+    PGM_P       name;
+    PGM_P       help;
+    void        (*handler)(t_shell_args *args);
+}   t_shell_cmd;
+
+typedef struct s_shell_stats
+{
+    uint16_t    lines;          /* Lines run */
+    uint16_t    unknown;        /* First word not in the table */
+    uint16_t    dropped;        /* Bytes received while a line was waiting */
+}   t_shell_stats;
+
+extern t_shell_stats g_shell_stats;
+
+void        shell_exec(char *line);
+void        shell_prompt(void);
+void        shell_help(void);
+
+/* Output: uart_puts_P / uart_put_u32 / uart_put_hex8 (lib/uart.c) */
+uint8_t     shell_parse_u16(const char *str, uint16_t *value);
+
+#endif
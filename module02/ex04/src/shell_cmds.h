@@ -0,0 +1,67 @@
+/* Generated by tools/gen_cmd_hash.py from commands.txt, do not edit */
+#ifndef SHELL_CMDS_H
+# define SHELL_CMDS_H
+
+#include "shell.h"
+
+#define SHELL_HASH_SIZE     32
+#define SHELL_HASH_SEED     0x02
+#define SHELL_HASH_MUL      3
+#define SHELL_CMD_COUNT     12
+
+void cmd_help(t_shell_args *args);
+void cmd_rgb(t_shell_args *args);
+void cmd_adc(t_shell_args *args);
+void cmd_temp(t_shell_args *args);
+void cmd_i2c(t_shell_args *args);
+void cmd_stats(t_shell_args *args);
+void cmd_set(t_shell_args *args);
+void cmd_get(t_shell_args *args);
+void cmd_load(t_shell_args *args);
+void cmd_mem(t_shell_args *args);
+void cmd_trace(t_shell_args *args);
+void cmd_logout(t_shell_args *args);
+
+static const char g_cmd_name_help[] PROGMEM = "help";
+static const char g_cmd_help_help[] PROGMEM = "list the commands";
+static const char g_cmd_name_rgb[] PROGMEM = "rgb";
+static const char g_cmd_help_rgb[] PROGMEM = "rgb <r> <g> <b> (0 ~ 255) - RGB LED color";
+static const char g_cmd_name_adc[] PROGMEM = "adc";
+static const char g_cmd_help_adc[] PROGMEM = "adc [channel] (0 ~ 7) - raw 10 bit value";
+static const char g_cmd_name_temp[] PROGMEM = "temp";
+static const char g_cmd_help_temp[] PROGMEM = "internal temperature sensor (C)";
+static const char g_cmd_name_i2c[] PROGMEM = "i2c";
+static const char g_cmd_help_i2c[] PROGMEM = "i2c scan - addresses which ACK";
+static const char g_cmd_name_stats[] PROGMEM = "stats";
+static const char g_cmd_help_stats[] PROGMEM = "uptime and shell counters";
+static const char g_cmd_name_set[] PROGMEM = "set";
+static const char g_cmd_help_set[] PROGMEM = "set <key> <value> - saved in EEPROM (user, pass, temp_off)";
+static const char g_cmd_name_get[] PROGMEM = "get";
+static const char g_cmd_help_get[] PROGMEM = "get [key] - one value or every value";
+static const char g_cmd_name_load[] PROGMEM = "load";
+static const char g_cmd_help_load[] PROGMEM = "CPU load over the last second, per account (make LOAD=1)";
+static const char g_cmd_name_mem[] PROGMEM = "mem";
+static const char g_cmd_help_mem[] PROGMEM = "RAM: .data / .bss, stack high water mark, free gap";
+static const char g_cmd_name_trace[] PROGMEM = "trace";
+static const char g_cmd_help_trace[] PROGMEM = "binary ISR trace dump (make TRACE=1, tools/trace_stats.py)";
+static const char g_cmd_name_logout[] PROGMEM = "logout";
+static const char g_cmd_help_logout[] PROGMEM = "back to the login";
+
+/* Index = hash of the name, empty slots are { 0 } */
+static const t_shell_cmd g_shell_cmds[SHELL_HASH_SIZE] PROGMEM =
+{
+    [0] = { g_cmd_name_i2c, g_cmd_help_i2c, cmd_i2c },
+    [2] = { g_cmd_name_temp, g_cmd_help_temp, cmd_temp },
+    [4] = { g_cmd_name_set, g_cmd_help_set, cmd_set },
+    [7] = { g_cmd_name_mem, g_cmd_help_mem, cmd_mem },
+    [12] = { g_cmd_name_logout, g_cmd_help_logout, cmd_logout },
+    [14] = { g_cmd_name_adc, g_cmd_help_adc, cmd_adc },
+    [15] = { g_cmd_name_rgb, g_cmd_help_rgb, cmd_rgb },
+    [20] = { g_cmd_name_load, g_cmd_help_load, cmd_load },
+    [23] = { g_cmd_name_trace, g_cmd_help_trace, cmd_trace },
+    [24] = { g_cmd_name_get, g_cmd_help_get, cmd_get },
+    [27] = { g_cmd_name_help, g_cmd_help_help, cmd_help },
+    [29] = { g_cmd_name_stats, g_cmd_help_stats, cmd_stats },
+};
+
+#endif
@@ -1,38 +1,36 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
+#include "board.h"
 
-#define PORT_CHECK(x, num) PORT##x & (1 << PORT##x##num)    /* Verification of the port is turned-on */
-#define PORT_ON(x, num) PORT##x = (1 << PORT##x##num)   /* Allocation of the port (different with |= )*/
+#define RGB_ON(name) BOARD_WRITE(BOARD_RGB, 1 << PIN_INDEX(name))   /* Only this color on (the other RGB pins off) */
 
 void next_color(void)
 {
-    if (PORT_CHECK(D, 5))
+    if (PIN_READ(RGB_R))    /* Verification of the pin is turned-on */
     {
-        PORT_ON(D, 6);
+        RGB_ON(RGB_G);
     }
-    else if (PORT_CHECK(D, 6))
+    else if (PIN_READ(RGB_G))
     {
-        PORT_ON(D, 3);
+        RGB_ON(RGB_B);
     }
-    else if (PORT_CHECK(D, 3))
+    else if (PIN_READ(RGB_B))
     {
-        PORT_ON(D, 5);
+        RGB_ON(RGB_R);
     }
     else
     {
-        PORT_ON(D, 5);
+        RGB_ON(RGB_R);
     }
 }
 
 int main()
 {
     /*
-    ** D5 - red
-    ** D6 - green
-    ** D3 - blue
+    ** RGB_R / RGB_G / RGB_B (lib/board.h: D5 - red, D6 - green, D3 - blue)
     */
-    DDRD |= (1 << DDD5) | (1 << DDD6) | (1 << DDD3);    /* Register to write */
+    BOARD_SETUP(BOARD_RGB);     /* Register to write, all off */
 
     while (1)
     {
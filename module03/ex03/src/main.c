@@ -1,255 +1,440 @@
+#ifndef F_CPU
+# define F_CPU 16000000UL     /* Normally given by the Makefile (-DF_CPU) */
+#endif
+
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "power.h"
+#include "periph.h"
+#include "uart.h"
+#include "pwm.h"
+
+/*
+** 1Mbaud: UBRR = 16MHz / (8 * 1M) - 1 = 1 exactly with U2X (0% error, page 199 20-7)
+** 100 000 bytes/s, 7 bytes per color (#RRGGBB, end of line optional) -> 14 285 colors/s
+*/
+#ifndef UART_BAUDERATE
+# define UART_BAUDERATE 1000000
+#endif
 
-#define F_CPU 16000000UL
-#define UART_BAUDERATE 115200
-#define UBRRN ((F_CPU / (8 * UART_BAUDERATE)) - 1)
+#define TIMER1_FREQ TIMER_HZ(1000)      /* Binary stream frame tick: 1ms */
+#define TIMER1_MAX_PPM 0
+#include "timer_cfg.h"
 
 /*
-** Hexadecimal color representation string buffers
-** Global variables to store received hex color codes
+** Character classes for the stream (one PROGMEM read per byte, no range compares)
+**  - HEX_DIGIT | value (0 ~ 15)
+**  - HEX_HASH  : start of a color
+**  - HEX_END   : '\r' / '\n', allowed after a color, ignored
+**  - HEX_QUERY : '?' -> one acknowledgement ("OK <colors>" or "ERR <errors>")
+**  - HEX_BINARY: STX (0x02) -> binary stream mode (see below)
+**  - 0         : anything else, invalid
 */
-char    g_hex_buffer[9]; // #RRGGBB + \r + \0 (total 9 bytes)
-uint8_t g_buffer_index = 0;
+#define HEX_DIGIT   0x10
+#define HEX_HASH    0x20
+#define HEX_END     0x40
+#define HEX_QUERY   0x80
+#define HEX_BINARY  0x01        /* No HEX_DIGIT bit: STX must not be taken for a digit */
+#define HEX_VALUE   0x0F
 
-void uart_puts(const char *str);
+#define HEX_D(v)    (HEX_DIGIT | (v))
 
-void init_rgb()
+static const uint8_t g_hex_class[256] PROGMEM =
 {
-    DDRD |= (1 << DDD3) | (1 << DDD5) | (1 << DDD6); /* Set out mode */
+    ['0'] = HEX_D(0), ['1'] = HEX_D(1), ['2'] = HEX_D(2), ['3'] = HEX_D(3),
+    ['4'] = HEX_D(4), ['5'] = HEX_D(5), ['6'] = HEX_D(6), ['7'] = HEX_D(7),
+    ['8'] = HEX_D(8), ['9'] = HEX_D(9),
+    ['A'] = HEX_D(10), ['B'] = HEX_D(11), ['C'] = HEX_D(12), ['D'] = HEX_D(13), ['E'] = HEX_D(14), ['F'] = HEX_D(15),
+    ['a'] = HEX_D(10), ['b'] = HEX_D(11), ['c'] = HEX_D(12), ['d'] = HEX_D(13), ['e'] = HEX_D(14), ['f'] = HEX_D(15),
+    ['#'] = HEX_HASH,
+    ['\r'] = HEX_END, ['\n'] = HEX_END,
+    ['?'] = HEX_QUERY,
+    [0x02] = HEX_BINARY,
+};
 
-    TCCR0A |= (1 << COM0A1) | (1 << COM0B1); /* page 113 15-3 / page 114 15-6  Setting pwm mode (Non-inverting PWM) */
-    TCCR0A |= (1 << WGM01) | (1 << WGM00);  /* page 115 - 15-8 mode 3 top 255 (counter 0 to 255 (rgb value)) */
+/*
+** Parser state, only used by the RX interrupt
+**  - g_nibble: 0 = waiting for '#', 1 ~ 6 = nibbles received + 1
+**  - the color is filled in g_color[g_fill], the 6th nibble hands it to the PWM
+**  - the frame player has its own pair (2 ~ 3): a frame started while a text color is
+**    half received never writes into it
+*/
+#define COLOR_PLAY  2                   /* First buffer of the frame player */
 
-    TCCR0B |= (1 << CS00);  /* Do not prescaling (to avoid Flicker) page 116 */
+static uint8_t g_nibble = 0;
+static uint8_t g_color[4][3];           /* Double buffers: 0 ~ 1 text parser, 2 ~ 3 frame player */
+static uint8_t g_fill = 0;
+static uint8_t g_play = 0;              /* Next buffer of the frame player (0 ~ 1) */
+static volatile uint8_t g_show = 0;
 
-    /*
-    ** Timer 2 setting
-    ** D3 pin connect with timer2
-    */
-    TCCR2A |= (1 << COM2B1); /* page 163 18-6 set OC2B at bottom*/
+/*
+** Binary stream mode (host light shows)
+**  - frame: R, G, B, duration (1 ~ 255 ticks of 1ms), 4 bytes, no framing byte
+**  - duration 0: end of the stream, the parser is back in text mode
+**    (frames already queued still play), "END <frames> <underruns>" once the queue is empty
+**  - frames go straight into a queue slot, Timer1 (1ms CTC) plays them: the color of a frame
+**    is shown at the tick its predecessor ends, whatever the UART timing was
+**  - credit flow control: the device sends one byte n (1 ~ FRAME_QUEUE - 1) = "n more frames"
+**      at the start: the free slots (FRAME_QUEUE - 1), then every FRAME_CREDIT frames played (or when the queue runs dry)
+**    the host never sends more frames than credits it has, so the queue never overflows
+**  - queue empty at the end of a frame (underrun): the color stays, the next frame starts when it comes
+*/
+#define FRAME_QUEUE     32              /* Power of 2 */
+#define FRAME_CREDIT    8
 
-    TCCR2A |= (1 << WGM21) | (1 << WGM20);  /* page 164 18-8 model 3 */
-    
-    /*
-    ** page 165 sheet of TCCR2B
-    */
-    TCCR2B |= (1 << CS20); /* Do not prescaling page 165 */
+typedef struct s_frame
+{
+    uint8_t rgb[3];
+    uint8_t ticks;
+}   t_frame;
+
+static t_frame g_frame[FRAME_QUEUE];
+static volatile uint8_t g_frame_head = 0;   /* Next frame to play (Timer1) */
+static volatile uint8_t g_frame_tail = 0;   /* Slot being received (RX) */
+static uint8_t g_frame_byte = 0;            /* Bytes of the slot received */
+static uint8_t g_binary = 0;                /* RX parser in binary mode */
+static volatile uint8_t g_stream_end = 0;   /* End frame received, report when the queue is empty */
+static uint8_t g_frame_left = 0;            /* Ticks left of the frame on show */
+static uint8_t g_playing = 0;
+static uint8_t g_credit = 0;                /* Slots freed, not given back yet */
+static uint16_t g_frames = 0;
+static uint16_t g_underruns = 0;
+
+/* Counters for the acknowledgement */
+static uint16_t g_colors = 0;
+static uint16_t g_errors = 0;           /* Invalid bytes + receiver overruns (DOR0) */
 
-    /*
-    ** OCR - Output Compare Register (page 108 15.7.3)
-    */
-    OCR0B = 0;  /* Red */
-    OCR0A = 0;  /* Green */
-    OCR2B = 0;  /* Blue */
-}
+/*
+** Reports: the interrupts latch the numbers, the main loop writes them out
+** A 16 bit number in decimal costs more than 1000 cycles: far over the 160 cycles of a byte
+*/
+#define REPORT_ACK  0x01                /* '?' received: "OK <colors>" or "ERR <errors>" */
+#define REPORT_END  0x02                /* End frame played: "END <frames> <underruns>" */
 
-void set_rgb(uint8_t r, uint8_t g, uint8_t b)
-{
-    OCR0B = r;  /* Red */
-    OCR0A = g;  /* Green */
-    OCR2B = b;  /* Blue */
-}
+static volatile uint8_t g_report = 0;
+static uint16_t g_ack_count = 0;
+static uint8_t g_ack_errors = 0;
+static uint16_t g_end_frames = 0;
+static uint16_t g_end_underruns = 0;
 
 /*
-** UART Initialization Function (Setting Baudrate, Frame format, Enable RX/TX) 
-** We need to serialize #RRGGBB format
+** Transmit ring, drained by USART_UDRE_vect (the RX interrupt never waits for the transmitter)
+** uart_tx() of lib/uart.c waits for UDRE0: not usable from the receive interrupt at 1Mbaud
 */
-void uart_init(unsigned int ubrr)
-{
-    /* Set baud rate */
-    UBRR0H = (unsigned char)(ubrr >> 8);    /* Upper Rate part */
-    UBRR0L = (unsigned char)(ubrr);         /* Lower Rate part */
-
-    /*
-    ** UCSR0B - USART Control and Status Register 0 B
-    ** RXEN0 - Receiver Enable
-    ** TXENO - Transmitter Enable
-    */
-    UCSR0B |= (1 << RXEN0) | (1 << TXEN0);  /* Enable Receiver and Transmitter */
-    
-    /*
-    ** Set frame format: 8N1 (8 data bits, No Parity, 1 stop bit)
-    ** UCSR0C - USART Control and Status Register 0 C
-    **
-    ** (3 << UCSZ00) sets UCSZ01=1 and UCSZ00=1. Combined with UCSZ02=0 (default in UCSR0B),
-    ** this selects 8-bit character size.
-    **
-    ** UPM0n bits (Parity) are 0 by default -> No Parity.
-    ** USBS0 bit (Stop Bit) is 0 by default -> 1 Stop Bit.
-    */
-    UCSR0C = (3 << UCSZ00);  /* Format to 8N1 (N - No parity, and Data is 8 bits)*/
-
-    /*
-    ** UCSR0A - USART Control and Status Register 0 A
-    ** U2X0 - USART Double Speed 0 (Data speed optimization)
-    */
-    UCSR0A |= (1 << U2X0); /* Enabling double transfer speed, and divide by two baudrate (Reduce Error Rate) */
-}
+#define TX_SIZE 32     /* 31 bytes: a credit byte, "ERR 65535\r\n" and "END 65535 65535\r\n" at once */
+static char g_tx[TX_SIZE];
+static volatile uint8_t g_tx_head = 0;
+static volatile uint8_t g_tx_tail = 0;
 
-void uart_tx(char c)
+/*
+** Queue one byte, dropped when the ring is full (acknowledgements are short)
+** Called by the interrupts (credits) and by the main loop (reports)
+*/
+static void tx_put(char c)
 {
-    /*
-    ** UCSR0A - USART Control and Status Register 0 A
-    ** UDRE0 - USART Data Register Empty 0
-    */
-    while (!(UCSR0A & (1 << UDRE0)))   /* Wait for empty transmit buffer */
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
     {
-        ;
-    }
+        uint8_t next = (g_tx_tail + 1) & (TX_SIZE - 1);
 
-    /* UDR0 - USART Data Register 0  (REAL BOX which put the data)*/
-    UDR0 = c;                           /* Put data into buffer, sends the data */
+        if (next == g_tx_head)
+            return;
+        g_tx[g_tx_tail] = c;
+        g_tx_tail = next;
+        UCSR0B |= (1 << UDRIE0);   /* Data Register Empty interrupt sends it (page 194) */
+    }
 }
 
-uint8_t hex_char_to_int(char c)
+static void tx_puts(const char *str)
 {
-    if (c >= '0' && c <= '9')
-    {
-        return (c - '0');
-    }
-    else if (c >= 'A' && c <= 'F')
+    while (*str)
     {
-        return (c - 'A' + 10);
+        tx_put(*str++);
     }
-    else if (c >= 'a' && c <= 'f')
+}
+
+ISR(USART_UDRE_vect)
+{
+    UDR0 = g_tx[g_tx_head];
+    g_tx_head = (g_tx_head + 1) & (TX_SIZE - 1);
+    if (g_tx_head == g_tx_tail)
+        UCSR0B &= ~(1 << UDRIE0);
+}
+
+static void tx_put_u16(uint16_t value)
+{
+    char buffer[6];
+    uint8_t i = 0;
+
+    do
     {
-        return (c - 'a' + 10);
-    }
-    return (0);
+        buffer[i++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (i)
+        tx_put(buffer[--i]);
+}
+
+uint8_t hex_char_to_int(char c)
+{
+    return pgm_read_byte(&g_hex_class[(uint8_t)c]) & HEX_VALUE;   /* 0 for a non hex char, as before */
 }
 
 /*
-** Convert hex string to decimal integer (format #RRGGBB -> R, G, B values (divide by high and low))
+** Check if the received char is valid at this index of #RRGGBB\r
+** Return 1 if valid, 0 if invalid
 */
-uint8_t convert_to_dec(char *str)
-{
-    uint8_t high;
-    uint8_t low;
-    uint8_t result;
-
-    high = hex_char_to_int(str[0]);
-    low = hex_char_to_int(str[1]);
-
-    /*
-    ** - 1 << 1 = 2 (1 * 2)
-    ** - 1 << 2 = 4 (1 * 4)
-    ** - 1 << 3 = 8 (1 * 8)
-    ** - 1 << 4 = 16 (1 * 16)
-    ** EXAMPLE:
-    **    11110000  (high << 4)
-    **    00000111  (low)
-    **   ------------
-    **   11110111  (Total 8 bit value)
-    */
-    result = (high << 4) | low;
-
-    return result;
+int check_color_format(char c, uint8_t index)
+{
+    uint8_t class = pgm_read_byte(&g_hex_class[(uint8_t)c]);
+
+    if (index == 0)
+        return class == HEX_HASH;
+    if (index <= 6)
+        return (class & HEX_DIGIT) != 0;
+    if (index == 7)
+        return c == '\r';
+    return 1;
 }
 
-void hex_to_rgb(void)
+/*
+** Latch: the new color is written at the Timer0 overflow (start of a PWM period),
+** so the 3 channels change together, never in the middle of a period
+** The interrupt is only on while a color is waiting
+*/
+ISR(TIMER0_OVF_vect)
 {
-    uint8_t r;
-    uint8_t g;
-    uint8_t b;
+    const uint8_t *color = g_color[g_show];
 
-    r = convert_to_dec(&g_hex_buffer[1]); /* Skip '#' character */
-    g = convert_to_dec(&g_hex_buffer[3]);
-    b = convert_to_dec(&g_hex_buffer[5]);
+    set_rgb(color[0], color[1], color[2]);
+    TIMSK0 &= ~(1 << TOIE0);
+}
 
-    set_rgb(r, g, b);
+/* g_color[buffer] is complete: show it at the next PWM period */
+static inline void latch_color(uint8_t buffer)
+{
+    g_show = buffer;
+    TIFR0 = (1 << TOV0);                        /* Next overflow, not one already pending */
+    TIMSK0 |= (1 << TOIE0);
+}
 
-    /* Send success message */
-    uart_puts("\r\nColor displayed\r\n");
+/* Start the frame at the head of the queue (queue not empty) */
+static inline void frame_start(void)
+{
+    t_frame *frame = &g_frame[g_frame_head];
+    uint8_t buffer = COLOR_PLAY + g_play;
+    uint8_t *color = g_color[buffer];
+
+    color[0] = frame->rgb[0];
+    color[1] = frame->rgb[1];
+    color[2] = frame->rgb[2];
+    latch_color(buffer);
+    g_play ^= 1;
+    g_frame_left = frame->ticks;
+    g_frame_head = (g_frame_head + 1) & (FRAME_QUEUE - 1);
+    g_credit++;
+    g_frames++;
+    g_playing = 1;
 }
 
 /*
-** Check if the received string is in valid #RRGGBB format
-** Return 1 if valid, 0 if invalid
-** checking with 16
+** Frame clock, 1ms
+** An idle tick costs a compare and a return
 */
-int check_color_format(char c, uint8_t index)
+ISR(TIMER1_COMPA_vect)
 {
-    if (c != '#' && index == 0)
-        return 0;
+    if (g_frame_left && --g_frame_left)
+        return;
+
+    uint8_t dry = (g_frame_head == g_frame_tail);
 
-    if (index >= 1 && index <= 6)
+    if (!dry)
+        frame_start();
+    else if (g_playing)                         /* Frame over, nothing after it */
     {
-        if ((c >= '0' && c <= '9') ||
-            (c >= 'A' && c <= 'F') ||
-            (c >= 'a' && c <= 'f'))
-        {
-            return 1;
-        }
-        else
-            return 0;
+        g_playing = 0;
+        if (g_binary)
+            g_underruns++;
+    }
+
+    if (g_credit && (g_credit >= FRAME_CREDIT || dry))
+    {
+        if (g_binary)
+            tx_put(g_credit);
+        g_credit = 0;
+    }
+    if (dry && g_stream_end)
+    {
+        g_stream_end = 0;
+        g_end_frames = g_frames;
+        g_end_underruns = g_underruns;
+        g_report |= REPORT_END;
     }
-    
-    if (index == 7 && c != '\r')
-        return 0;
-    return 1;
 }
 
-void uart_puts(const char *str)
+/* Binary mode byte: straight into the slot at the tail */
+static inline void binary_rx(uint8_t byte)
 {
-    while (*str)
+    uint8_t tail = g_frame_tail;
+    uint8_t next = (tail + 1) & (FRAME_QUEUE - 1);
+    uint8_t index = g_frame_byte;
+
+    ((uint8_t *)&g_frame[tail])[index] = byte;
+    if (++index < sizeof(t_frame))
+    {
+        g_frame_byte = index;
+        return;
+    }
+    g_frame_byte = 0;
+    if (byte == 0)                              /* End of the stream */
     {
-        uart_tx(*str++);
+        g_binary = 0;
+        g_stream_end = 1;
+        return;
     }
+    if (next == g_frame_head)                   /* Host sent more than its credits: frame lost */
+    {
+        g_errors++;
+        return;
+    }
+    g_frame_tail = next;
 }
 
 /*
-** Interrupt Service Routine for receiving data
-** USART_RX_vect - Receive controller
-** ISR - Interrupt Service Routine (Stop while(1) and jump to this function)
+** One byte per interrupt, no wait, no output except the first credits ('?' is only latched)
+** Budget at 1Mbaud: one byte every 10us = 160 cycles
 */
 ISR(USART_RX_vect)
 {
-    char c = UDR0; /* Get and store the received data from UDR0 register */
+    uint8_t overrun = UCSR0A & (1 << DOR0);     /* Read before UDR0 (page 195) */
+    uint8_t byte = UDR0;
 
-    if (!check_color_format(c, g_buffer_index))
+    if (overrun)
+        g_errors++;
+    if (g_binary)
     {
-        uart_puts("\r\nInvalid format!\r\n");
-
-        g_buffer_index = 0; /* Reset index for next reception */
-        
+        binary_rx(byte);
         return;
     }
 
-    uart_tx(c); /* Echo back the received character */
+    uint8_t class = pgm_read_byte(&g_hex_class[byte]);
+    uint8_t nibble = g_nibble;
 
-    g_hex_buffer[g_buffer_index] = c; /* Store received character in buffer and increment index */
+    if (class & HEX_DIGIT)
+    {
+        if (nibble == 0)                        /* Digit without '#' */
+        {
+            g_errors++;
+            return;
+        }
+        uint8_t *channel = &g_color[g_fill][(nibble - 1) >> 1];
 
-    if (g_buffer_index == 7) /* If we have received 8 characters (#RRGGBB\r) */
+        *channel = (*channel << 4) | (class & HEX_VALUE);
+        if (nibble == 6)                        /* Color complete: swap and latch */
+        {
+            latch_color(g_fill);
+            g_fill ^= 1;
+            g_colors++;
+            nibble = 0;
+        }
+        else
+            nibble++;
+    }
+    else if (class == HEX_HASH)
+    {
+        if (nibble != 0)                        /* Color cut short */
+            g_errors++;
+        nibble = 1;
+    }
+    else if (class == HEX_QUERY)
+    {
+        g_ack_errors = (g_errors != 0);
+        g_ack_count = g_errors ? g_errors : g_colors;
+        g_report |= REPORT_ACK;
+        g_colors = 0;
+        g_errors = 0;
+    }
+    else if (class == HEX_BINARY)
     {
-        g_hex_buffer[8] = '\0'; /* Null-terminate the string */
+        uint8_t used = (g_frame_tail - g_frame_head) & (FRAME_QUEUE - 1);
+
+        g_binary = 1;
+        g_frame_byte = 0;
+        g_frames = 0;
+        g_underruns = 0;
+        g_stream_end = 0;
+        g_credit = 0;                           /* Freed slots are in the first credits */
+        tx_put(FRAME_QUEUE - 1 - used);        /* First credits: the free slots */
+        nibble = 0;
+    }
+    else if (class != HEX_END)
+    {
+        g_errors++;
+        nibble = 0;
+    }
+    g_nibble = nibble;
+}
 
-        hex_to_rgb(); /* Convert hex to RGB and set the color */
+/*
+** Main loop side of the reports: the numbers are taken with interrupts off, written with
+** them on (the RX interrupt keeps up with the stream while the digits are computed)
+*/
+static void send_reports(void)
+{
+    uint8_t report;
+    uint8_t errors;
+    uint16_t count;
+    uint16_t frames;
+    uint16_t underruns;
 
-        g_buffer_index = 0; /* Reset index for next reception */
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        report = g_report;
+        g_report = 0;
+        errors = g_ack_errors;
+        count = g_ack_count;
+        frames = g_end_frames;
+        underruns = g_end_underruns;
     }
-    else
+    if (report & REPORT_ACK)
     {
-        g_buffer_index++;
+        tx_puts(errors ? "ERR " : "OK ");
+        tx_put_u16(count);
+        tx_puts("\r\n");
+    }
+    if (report & REPORT_END)
+    {
+        tx_puts("END ");
+        tx_put_u16(frames);
+        tx_put(' ');
+        tx_put_u16(underruns);
+        tx_puts("\r\n");
     }
-    
-    
-    
 }
 
-
 int main(void)
 {
-    uart_init(UBRRN); /* Initialize UART with calculated UBRR value */
-    init_rgb();
+    uart_init(UART_UBRR(UART_BAUDERATE));   /* lib/uart.c, only the set up: bytes go out through the ring */
+    init_rgb();                             /* lib/pwm.c */
 
     UCSR0B |= (1 << RXCIE0); /* Enable RX Complete Interrupt */
 
+    /* Frame clock for the binary stream: Timer1 CTC 1ms, page 141 16-4 mode 4 */
+    periph_claim(PERIPH_TIM1);
+    OCR1A = TIMER1_TOP;
+    TCCR1B = TIMER1_TCCRB;
+    TIMSK1 = (1 << OCIE1A);
+
     sei();          /* Enable global interrupts */
 
     while (1)
     {
-
+        cli();
+        if (!g_report)
+            power_sleep();  /* Idle (UART receiver on), PWM timers and UART keep running */
+        sei();
+        send_reports();
     }
-}
\ No newline at end of file
+}
@@ -1,9 +1,9 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
+#include "board.h"
 
-#define SET_MODE(x, num) DDR##x |= (1 << DD##x##num)
-#define PORT_TOGGLE(x, num) PORT##x ^= (1 << PORT##x##num)
+BOARD_ASSERT(SW1, D, 2);    /* INT0 */
 
 volatile int g_flag = 0;
 
@@ -29,7 +29,7 @@ void enable_interrupts(void)
 
 int main(void)
 {
-    SET_MODE(B, 0); /* Set PB0 as output */
+    PIN_OUTPUT(LED_D1); /* Set LED D1 as output */
 
     enable_interrupts();
 
@@ -39,7 +39,7 @@ int main(void)
     {
         if (g_flag == 1)
         {
-            PORT_TOGGLE(B, 0); /* Toggle PB0 */
+            PIN_TOGGLE(LED_D1); /* Toggle LED D1 */
             
             _delay_ms(42);
 
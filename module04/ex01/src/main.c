@@ -1,50 +1,48 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
+#include "power.h"
+#include "periph.h"
+#include "wave.h"
+#include "board.h"
 
-#define SET_PB1_AS_OUTPUT() (DDRB |= (1 << PB1))
+#define TIMER0_FREQ TIMER_HZ(WAVE_TICK_HZ)   /* Waveform tick (100Hz) */
+#include "timer_cfg.h"
 
-volatile uint8_t g_duty_percent = 0;    /* 0 - 100% duty cycle */
-volatile int8_t g_step = 2;    /* Timer0 interrupt -> 100HZ */
+BOARD_ASSERT(LED_D2, B, 1);    /* Driven by OC1A */
 
-ISR(TIMER0_COMPA_vect)  /* Timer0 Compare A Match interrupt (send the PWM signal) */
-{
-    g_duty_percent += g_step;
+#define BREATH_PERIOD_MS 1000    /* One full breath (dark -> bright -> dark) */
 
-    if (g_duty_percent >= 100)
-    {
-        g_duty_percent = 100;
-        g_step = -2;    /* Change direction */
-    }
+t_wave g_breath;    /* LED D2 (OC1A) waveform */
 
-    if (g_duty_percent == 0)
-    {
-        g_step = 2;    /* Change direction */
-    }
-
-    /* 
-    ** Update OCR1A register
-    ** 8-bit resolution: 0 - 255
-    ** duty_percent: 0 - 100
-    ** Scaling formula: (duty_percent * 255) / 100
+ISR(TIMER0_COMPA_vect)  /* Timer0 Compare A Match interrupt (100Hz, next sample of the waveform) */
+{
+    /*
+    ** Next sample of the table is written directly to OCR1A
+    ** 8-bit resolution: 0 - 255 (no division, table is already in PWM scale)
     */
-    OCR1A = ((uint16_t)g_duty_percent * 255) / 100;
-
+    wave_tick(&g_breath);
 }
 
 int main(void)
 {
-    // OC1A (PB1) as output
-    SET_PB1_AS_OUTPUT();
+    // OC1A (LED D2) as output
+    PIN_OUTPUT(LED_D2);
+
+    periph_claim(PERIPH_TIM0 | PERIPH_TIM1);  /* Timer clocks on (everything is gated at startup) */
 
     /* Timer1 initialization */
     TCCR1A = (1 << COM1A1) | (1 << WGM10);    /* Non-inverting mode, 8-bit PWM page 140 (part of mode 5) */
     TCCR1B = (1 << WGM12) | (1 << CS11);    /* PWM mode, prescaler = 8 page 142 (part of mode 5) */
 
 
+    /* Waveform: exponential breath on OCR1A */
+    wave_init(&g_breath, g_wave_breath, NULL, &OCR1A);
+    wave_set_period(&g_breath, BREATH_PERIOD_MS);
+
     /* Timer0 initialization */
-    TCCR0A = (1 << WGM01);    /* CTC mode page 115 15-8 */
-    OCR0A = 155;    /* 16MHz CPU / 1024 prescaler / 156 (OCR0A+1) = 99.8Hz (approx 100Hz) */
+    TCCR0A = TIMER0_TCCRA;    /* CTC mode page 115 15-8 */
+    OCR0A = TIMER0_TOP;    /* 16MHz CPU / 1024 prescaler / 156 (OCR0A+1) = 100.16Hz (approx 100Hz) */
 
     TIMSK0 = (1 << OCIE0A);    /* Enable Timer0 Compare A Match interrupt page 118 */
 
@@ -52,13 +50,16 @@ int main(void)
     ** We set frequency of Timer0 to 100Hz
     ** So the duty cycle will be updated every 10ms
     ** if we use 1024 prescaler:
-    ** f_timer0 = f_cpu / prescaler = 16,000,000 / 1024 ~= 16000Hz
-    ** To get 100Hz, we need to set OCR0A to 155
+    ** f_timer0 = f_cpu / prescaler = 16,000,000 / 1024 ~= 15625Hz
+    ** To get 100Hz, we need to set OCR0A to 155 (timer_cfg.h, 1602ppm error)
     */
-    TCCR0B = (1 << CS02) | (1 << CS00); /* page 117 15-9 1024 scaler */
+    TCCR0B = TIMER0_TCCRB; /* page 117 15-9 1024 scaler */
 
     sei();    /* Enable global interrupts */
 
-    while (1) {}
+    while (1)
+    {
+        power_idle();   /* Sleep (idle, Timer0 / Timer1 keep running) until the next tick */
+    }
 
 }
\ No newline at end of file
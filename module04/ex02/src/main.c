@@ -1,93 +1,109 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
-
-#define SET_MODE_OUTPUT_MULTIPLE() DDRB |= (1 << PB0) | (1 << PB1) | (1 << PB2) | (1 << PB4)
-#define SET_MODE_PIN_READ(x, num) PIN##x & (1 << P##x##num)
-#define CLEAR_PORTB() (PORTB &= ~((1 << PB0) | (1 << PB1) | (1 << PB2) | (1 << PB4)))
-#define CLEAR_DDRX(x) (DDR##x &= ~((1 << PD2) | (1 << PD4)))
-#define SET_SW_INPUT(x) PORT##x |= (1 << P##x##2) | (1 << P##x##4)
-
-/* Store previous switch states */
-volatile uint8_t g_prev_sw1_state;
-volatile uint8_t g_prev_sw2_state;
+#include "power.h"
+#include "periph.h"
+
+#define TIMER0_FREQ TIMER_HZ(100)   /* Switch sampling every 10ms */
+#include "timer_cfg.h"
+#include "debounce.h"
+#include "gesture.h"
+#include "gpio.h"       /* LEDs D1 ~ D4, SW1 / SW2 (lib/board.h) */
+#include "uart.h"
+#include "trace.h"      /* make TRACE=1: tick duration, dumped when the ring is full */
+
+#define TRACE_TICK  0
+
+/* Debounced switches (vertical counters, 4 ticks = 40ms) */
+t_debounce g_switch;
+
+/*
+** Gestures (ticks of 10ms)
+**  - press: one step, hold 500ms: auto repeat from 200ms down to 30ms
+**  - double click: SW1 -> 15, SW2 -> 0
+*/
+const t_gesture_cfg g_button_cfg[2] =
+{
+    /* mask, double, long, repeat start, repeat min, repeat step */
+    { PIN_MASK(SW1), 30, 50, 20, 3, 3 },
+    { PIN_MASK(SW2), 30, 50, 20, 3, 3 },
+};
+t_gesture g_button[2];
 
 /* Store LED state */
 volatile uint8_t g_led_state = 0;
 
 ISR(TIMER0_COMPA_vect)
 {
-    uint8_t current_sw1_state = SET_MODE_PIN_READ(D, 2);
-    uint8_t current_sw2_state = SET_MODE_PIN_READ(D, 4);
+    TRACE_ENTER(TRACE_TICK);
+
+    /*
+    ** Switches are active low -> gpio_switches() gives ~PINx (1 = pressed)
+    ** Both switches debounced at once, no delay in the interrupt anymore
+    */
+    debounce_tick(&g_switch, gpio_switches());
+
+    uint8_t sw1 = gesture_tick(&g_button_cfg[0], &g_button[0], debounce_state(&g_switch, BOARD_GROUP_MASK(BOARD_SW)));
+    uint8_t sw2 = gesture_tick(&g_button_cfg[1], &g_button[1], debounce_state(&g_switch, BOARD_GROUP_MASK(BOARD_SW)));
 
-    if (current_sw1_state == 0 && g_prev_sw1_state != 0)
+    if ((sw1 & (GESTURE_PRESS | GESTURE_REPEAT)) && g_led_state < 15)   /* limited to 15 (avoid overflow) */
     {
-        if (g_led_state < 15)   /* limited to 15 (avoid overflow) */
-        {
-            g_led_state++;
-        }
-        _delay_ms(150); /* Simple debouncing */
+        g_led_state++;
     }
-
-    if (current_sw2_state == 0 && g_prev_sw2_state != 0)
+    if (sw1 & GESTURE_DOUBLE)
     {
-        if (g_led_state > 0)   /* limited to 0 (avoid underflow) */
-        {
-            g_led_state--;
-        }
-        _delay_ms(150); /* Simple debouncing */
+        g_led_state = 15;
     }
 
-    /* Save current values as previous values */
-    g_prev_sw1_state = current_sw1_state;
-    g_prev_sw2_state = current_sw2_state;
-
-    /*
-    ** Prepare LED output value
-    ** 3 LSBs for 3 LEDs, 4th bit for another LED (to pb0, pb1, pb2)
-    */
-    uint8_t led_output = g_led_state & 0x07; // Limit to 3 bits
-
-    if (g_led_state & 0x08) /* if 4th bit (the '8's place, 0x08) is set */
+    if ((sw2 & (GESTURE_PRESS | GESTURE_REPEAT)) && g_led_state > 0)   /* limited to 0 (avoid underflow) */
     {
-        led_output |= (1 << PB4);   /* Set PB4 */
+        g_led_state--;
+    }
+    if (sw2 & GESTURE_DOUBLE)
+    {
+        g_led_state = 0;
     }
 
-    CLEAR_PORTB();
-    PORTB |= led_output;
-
-    _delay_ms(10);
+    gpio_leds(g_led_state);     /* 4 bits -> D1 ~ D4 (bit 3 on PB4), one store */
 
+    TRACE_EXIT(TRACE_TICK);
 }
 
 
 int main(void)
 {
-    SET_MODE_OUTPUT_MULTIPLE();
+    gpio_leds_init();       /* Outputs, all off */
+    gpio_switches_init();   /* Inputs with pull-ups */
 
-    CLEAR_PORTB();  /* Clear resource for sure */
+    debounce_init(&g_switch, gpio_switches());
+    gesture_init(&g_button[0]);
+    gesture_init(&g_button[1]);
 
-    CLEAR_DDRX(D);  /* Clear DDRD for sure */
+    /* Timer0 configuration (clock on first: periph.o comes with uart.o / trace.o) */
+    periph_claim(PERIPH_TIM0);
+    TCCR0A = TIMER0_TCCRA; /* CTC mode page 115 15-8 */
 
-    SET_SW_INPUT(D);
-
-    g_prev_sw1_state = SET_MODE_PIN_READ(D, 2);
-    g_prev_sw2_state = SET_MODE_PIN_READ(D, 4);
-
-    /* Timer0 configuration */
-    TCCR0A = (1 << WGM01); /* CTC mode page 115 15-8 */
-
-    TCCR0B = (1 << CS02) | (1 << CS00); /* Prescaler 1024 page 117 15-9 */
+    TCCR0B = TIMER0_TCCRB; /* Prescaler 1024 page 117 15-9 */
 
     /* Set compare match value */
-    OCR0A = 156; /* 10ms at 16MHz with 1024 prescaler */
+    OCR0A = TIMER0_TOP; /* 10ms at 16MHz with 1024 prescaler (155) */
 
     TIMSK0 = (1 << OCIE0A); /* Enable compare match interrupt */
 
+#if TRACE
+    uart_init(UART_UBRR(UART_BAUDRATE));    /* Trace dump only (tools/trace_stats.py) */
+#endif
+    TRACE_INIT();           /* Timer1 free running at clk/1: the timestamps */
+    TRACE_NAME(TRACE_TICK, "TIMER0_COMPA_vect");
+
     sei(); /* Enable global interrupts */
 
     while (1)
     {
-
+#if TRACE
+        if (trace_full())
+            trace_dump();   /* ~20ms at 115200, the ticks go on into the freed slots */
+#endif
+        power_idle();   /* Sleep (idle, Timer0 keeps running) until the next tick */
     }
 }
\ No newline at end of file
@@ -1,125 +1,69 @@
+#ifndef F_CPU
+# define F_CPU 16000000UL     /* Normally given by the Makefile (-DF_CPU) */
+#endif
+
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
-
-#define F_CPU 16000000UL
-#define UART_BAUDERATE 115200
-#define UBRRN ((F_CPU / (8 * UART_BAUDERATE)) - 1)
+#include "uart.h"
+#include "adc.h"
+#include "systime.h"
+#include "elog.h"
 
 /*
-** UART Initialization Function (Setting Baudrate, Frame format, Enable RX/TX) 
-** We need to serialize #RRGGBB format
+** EEPROM log (lib/elog.h): the 3 readings every LOG_PERIOD_MS, kept without a host
+**  - LOG_FLUSH: samples per flush, the ones not flushed yet are lost on a reset (5 min)
+**  - wear: ~4 bytes per sample (LDR noise), a round of the 4 pages every ~18 min,
+**    100000 writes of a byte last ~3 years
+**  - tools/elog_dump.py --names rv1,ldr,ntc: LOG_DUMP -> binary dump, between two lines
 */
-void uart_init(unsigned int ubrr)
-{
-    /* Set baud rate */
-    UBRR0H = (unsigned char)(ubrr >> 8);    /* Upper Rate part */
-    UBRR0L = (unsigned char)(ubrr);         /* Lower Rate part */
-
-    /*
-    ** UCSR0B - USART Control and Status Register 0 B
-    ** RXEN0 - Receiver Enable
-    ** TXENO - Transmitter Enable
-    */
-    UCSR0B |= (1 << RXEN0) | (1 << TXEN0);  /* Enable Receiver and Transmitter */
-    
-    /*
-    ** Set frame format: 8N1 (8 data bits, No Parity, 1 stop bit)
-    ** UCSR0C - USART Control and Status Register 0 C
-    **
-    ** (3 << UCSZ00) sets UCSZ01=1 and UCSZ00=1. Combined with UCSZ02=0 (default in UCSR0B),
-    ** this selects 8-bit character size.
-    **
-    ** UPM0n bits (Parity) are 0 by default -> No Parity.
-    ** USBS0 bit (Stop Bit) is 0 by default -> 1 Stop Bit.
-    */
-    UCSR0C = (3 << UCSZ00);  /* Format to 8N1 (N - No parity, and Data is 8 bits)*/
+#define LOG_PERIOD_MS   10000
+#define LOG_FLUSH       30
+#define LOG_DUMP        'D'
 
-    /*
-    ** UCSR0A - USART Control and Status Register 0 A
-    ** U2X0 - USART Double Speed 0 (Data speed optimization)
-    */
-    UCSR0A |= (1 << U2X0); /* Enabling double transfer speed, and divide by two baudrate (Reduce Error Rate) */
-}
-
-void uart_tx(char c)
+/*
+** Format a byte value as a hexadecimal string.
+*/
+void format_hex(uint8_t value, uint8_t *buffer)
 {
-    /*
-    ** UCSR0A - USART Control and Status Register 0 A
-    ** UDRE0 - USART Data Register Empty 0
-    */
-    while (!(UCSR0A & (1 << UDRE0)))   /* Wait for empty transmit buffer */
-    {
-        ;
-    }
-
-    /* UDR0 - USART Data Register 0  (REAL BOX which put the data)*/
-    UDR0 = c;                           /* Put data into buffer, sends the data */
+    const char hex_chars[] = "0123456789ABCDEF";
+    buffer[0] = hex_chars[value >> 4];  /* High nibble */
+    buffer[1] = hex_chars[value & 0x0F];         /* Low nibble */
+    buffer[2] = '\0';                            /* Null-terminate the string */
 }
 
-void uart_puts(char *str)
+/* Every LOG_PERIOD_MS, a flush every LOG_FLUSH samples */
+void log_sample(uint8_t rv1, uint8_t ldr, uint8_t ntc)
 {
-    while (*str)
+    static uint32_t next = 0;
+    static uint8_t count = 0;
+    int16_t values[3] = { rv1, ldr, ntc };
+    uint32_t now = millis();
+
+    if ((int32_t)(now - next) < 0)
+        return;
+    next = now + LOG_PERIOD_MS;
+    elog_add(now, values);
+    if (++count == LOG_FLUSH)
     {
-        uart_tx(*str++);
+        count = 0;
+        elog_flush();
     }
 }
 
-void init_adc(void)
+/* LOG_DUMP received: binary dump (tools/elog_dump.py) */
+void log_command(void)
 {
-    /*
-    ** ADC Initialization
-    ** ADMUX - ADC Multiplexer Selection Register
-    ** REFS0 - Reference Selection Bit 0 -> AVCC with external capacitor at AREF pin (page 257 24-3) Voltage Reference Selection
-    **       - set in AVCC
-    ** ADLAR - ADC Left Adjust Result (page 257) (for 8 bit resolution we need left adjust result)
-    ** RESF0 - INPUT / ADLAR - OUTPUT
-    */
-    ADMUX = (1 << REFS0) | (1 << ADLAR); /* AVcc with external capacitor at AREF pin */
-
-    /*
-    ** ADCSRA - ADC Control and Status Register A
-    ** ADEN - ADC Enable
-    ** ADPS2:0 - ADC Prescaler Select Bits (page 259 24-5)
-    */
-    ADCSRA |= (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0); /* Enable ADC and set prescaler to 128 (16MHz/128 = 125KHz) (page 259 24-5) */
-}
+    if (!(UCSR0A & (1 << RXC0)))
+        return;
 
-uint8_t read_adc_channel(uint8_t channel)
-{
-    /*
-    ** We need to select the ADC channel by modifying the MUX bits in ADMUX register.
-    ** MUX bits are the lowest 3 bits of ADMUX (MUX2:MUX0).
-    ** 0xF8 = 0b11111000
-    ** 0x07 = 0b00000111
-    */
-    ADMUX = (ADMUX & 0xF8) | (channel & 0x07); /* Select ADC channel, keep other bits intact */
-    
-    /*
-    ** We initiate the ADLAR to 1 in init_adc() so we can read only the high byte (8 bits resolution)
-    ** So we read only ADSC
-    ** ADCSRA - ADC Control and Status Register A (page 258)
-    ** ADSC - ADC Start Conversion
-    */
-    ADCSRA |= (1 << ADSC);               /* Start single conversion */
+    char c = UDR0;
 
-    while (ADCSRA & (1 << ADSC))       /* Wait for conversion to complete */
+    if (c == LOG_DUMP)
     {
-        ;
+        elog_dump();
+        uart_flush();
     }
-
-    return ADCH;                        /* Return the high byte */
-}
-
-/*
-** Format a byte value as a hexadecimal string.
-*/
-void format_hex(uint8_t value, uint8_t *buffer)
-{
-    const char hex_chars[] = "0123456789ABCDEF";
-    buffer[0] = hex_chars[value >> 4];  /* High nibble */
-    buffer[1] = hex_chars[value & 0x0F];         /* Low nibble */
-    buffer[2] = '\0';                            /* Null-terminate the string */
 }
 
 /*
@@ -127,8 +71,11 @@ void format_hex(uint8_t value, uint8_t *buffer)
 */
 int main(void)
 {
-    uart_init(UBRRN);  /* Initialize UART with calculated UBRR value */
+    uart_init(UART_UBRR(UART_BAUDRATE));    /* lib/uart.c, 115200 8N1 */
     init_adc();        /* Initialize ADC */
+    systime_init();    /* Log timestamps (Timer1) */
+    elog_init(3, 1000);    /* Rv1, LDR, NTC, time in s */
+    sei();
 
     // create a buffer for the string "0xXX" plus the null terminator.
     uint8_t buffer_rv1[5] = {'0', 'x', 0, 0, '\0'};
@@ -137,9 +84,9 @@ int main(void)
 
     while (1)
     {
-        uint8_t rv1_value = read_adc_channel(0);  /* Read ADC value from channel 0 (ADC0) */
-        uint8_t ldr_value = read_adc_channel(1);  /* Read ADC value from channel 1 (ADC1) */
-        uint8_t ntc_value = read_adc_channel(2);  /* Read ADC value from channel 2 (ADC2) */
+        uint8_t rv1_value = adc_read8(ADC_CHANNEL(0));  /* Read ADC value from channel 0 (ADC0) */
+        uint8_t ldr_value = adc_read8(ADC_CHANNEL(1));  /* Read ADC value from channel 1 (ADC1) */
+        uint8_t ntc_value = adc_read8(ADC_CHANNEL(2));  /* Read ADC value from channel 2 (ADC2) */
 
         format_hex(rv1_value, &buffer_rv1[2]); /* Format ADC value to hex string */
         format_hex(ldr_value, &buffer_ldr[2]); /* Format ADC value to hex string */
@@ -151,6 +98,8 @@ int main(void)
         uart_puts(", ");
         uart_puts((char *)buffer_ntc);                /* Transmit ADC value over UART */
         uart_puts("\r\n");                  /* New line for readability */
+        log_sample(rv1_value, ldr_value, ntc_value);
+        log_command();
         _delay_ms(20);                  /* Delay for stability */
     }
 
@@ -1,20 +1,67 @@
 #ifndef MACRO_H
 #define MACRO_H
 
+#ifndef F_CPU
+# define F_CPU 16000000UL     /* Normally given by the Makefile (-DF_CPU) */
+#endif
+
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
-#include <util/twi.h>
 #include <stdlib.h>
+#include "systime.h"
+#include "periph.h"
+#include "wakeup.h"
+#include "clock.h"
+#include "uart.h"
+#include "twi.h"
+#include "adc.h"
+#include "elog.h"
 
-#define F_CPU 16000000UL
-#define UART_BAUDERATE 115200
-#define UBRRN ((F_CPU / (8 * UART_BAUDERATE)) - 1)
 #define I2C_ADDRESS_AHT20 (0x38 << 1) /* 7-bit address + Write/Read bit (0) so we need to shift left by 1 */
 #define MEASUREMENT_CMD 0xAC
 #define RESOLUTION 1048576.0
 #define TEMPERATURE_SCALE 200.0
 #define HUMIDITY_SCALE 100.0
 #define OFFSET 50.0
+#define AHT20_BUSY 0x80 /* Status bit 7: measurement in progress */
+#define AHT20_CONVERSION_MS 80
+
+/*
+** Node mode (battery, make NODE=1): power down between samples, watchdog wake up
+**  - NODE_PERIOD_MS: time asleep per sample (96 ~ 8192ms, 16ms steps), the sleep through the
+**    AHT20 conversion included (AHT20_CONVERSION_MS, then NODE_PERIOD_MS - AHT20_CONVERSION_MS),
+**    awake time comes on top
+**  - NODE_BATCH: samples per UART burst
+**  - NODE_ADC_CHANNELS: ADC0 ~ ADC2 of the board (RV1, LDR, NTC) read with each sample,
+**    NODE_ADC_OVERSAMPLE conversions averaged, ADC off again before the power down
+**  - NODE_MODE 0 (default) -> awake loop, one line every 2s
+*/
+#ifndef NODE_MODE
+# define NODE_MODE 0
+#endif
+#define NODE_PERIOD_MS 1000
+#define NODE_BATCH 8
+#define NODE_CLOCK CLOCK_2MHZ   /* Awake between bursts (I2C, ADC), 16MHz for the UART burst */
+#define NODE_ADC_CHANNELS 3
+#define NODE_ADC_OVERSAMPLE 4
+
+/*
+** EEPROM log (lib/elog.h): the filtered sample in tenths of C / %RH, kept without a host
+**  - LOG_EVERY: one sample logged out of LOG_EVERY (node mode: ~10s)
+**  - LOG_FLUSH: samples per flush, the ones not flushed yet are lost on a reset (~5 min)
+**  - wear: ~2 bytes per sample, a round of the 4 pages every ~35 min, 100000 writes of a
+**    byte last ~6 years
+**  - tools/elog_dump.py --names temperature,humidity --scale 0.1: 'D' -> binary dump
+**    (node mode: read during a burst, the dump follows it)
+*/
+#define LOG_EVERY 10
+#define LOG_FLUSH 30
+#define LOG_TICK_MS 1000
+#define LOG_DUMP 'D'
+
+#if NODE_PERIOD_MS < AHT20_CONVERSION_MS + WAKEUP_MIN_MS || NODE_PERIOD_MS > WAKEUP_MAX_MS
+# error "NODE_PERIOD_MS: 96 ~ 8192ms"
+#endif
 
 #endif /* MACRO_H */
@@ -13,10 +13,8 @@ static float g_temperature[3] = {0};
 static float g_humidity[3] = {0};
 int g_measurement_index = 0;
 
-/* Function prototype */
-void uart_puts(char *str);
-void i2c_write(unsigned char data);
-void i2c_stop(void);
+static uint8_t g_log_skip = 0;		/* Samples since the last one logged */
+static uint8_t g_log_count = 0;		/* Logged since the last flush */
 
 /*
 **-------------------------------
@@ -49,103 +47,93 @@ void compute_average(float *temperature, float *humidity)
 		uart_puts("No measurements available.\r\n");
 		return;
 	}
-	*temperature = (temperature[0] + temperature[1] + temperature[2]) / count;
-	*humidity = (humidity[0] + humidity[1] + humidity[2]) / count;
+	/* Empty slots are still 0, so the sum of the 3 is the sum of the last count values */
+	*temperature = (g_temperature[0] + g_temperature[1] + g_temperature[2]) / count;
+	*humidity = (g_humidity[0] + g_humidity[1] + g_humidity[2]) / count;
 }
 
 /*
 **-------------------------------
-** UART Initialization Function
+** EEPROM log (lib/elog.c)
 **-------------------------------
 */
-void uart_init(unsigned int ubrr)
+
+/* Tenths, rounded to the nearest */
+int16_t log_tenths(float value)
 {
-    /* Set baud rate */
-    UBRR0H = (unsigned char)(ubrr >> 8);    /* Upper Rate part */
-    UBRR0L = (unsigned char)(ubrr);         /* Lower Rate part */
-
-    UCSR0B |= (1 << RXEN0) | (1 << TXEN0);  /* Enable Receiver and Transmitter */
-    
-    UCSR0C = (3 << UCSZ00);  /* Format to 8N1 (N - No parity, and Data is 8 bits)*/
-    UCSR0A |= (1 << U2X0); /* Enabling double transfer speed, and divide by two baudrate (Reduce Error Rate) */
+	return (int16_t)(value * 10.0f + (value < 0 ? -0.5f : 0.5f));
 }
 
-void uart_tx(char c)
+/* One sample out of LOG_EVERY, a flush every LOG_FLUSH logged */
+void log_sample(uint32_t time, float temperature, float humidity)
 {
-    while (!(UCSR0A & (1 << UDRE0)))   /* Wait for empty transmit buffer */
-    {
-        ;
-    }
+	int16_t values[2];
 
-    /* UDR0 - USART Data Register 0  (REAL BOX which put the data)*/
-    UDR0 = c;                           /* Put data into buffer, sends the data */
+	if (++g_log_skip < LOG_EVERY)
+		return;
+	g_log_skip = 0;
+	values[0] = log_tenths(temperature);
+	values[1] = log_tenths(humidity);
+	elog_add(time, values);
+	if (++g_log_count == LOG_FLUSH)
+	{
+		g_log_count = 0;
+		elog_flush();
+	}
 }
 
-void uart_puts(char *str)
+/* LOG_DUMP received: binary dump (tools/elog_dump.py), the bytes sent behind it are dropped */
+void log_command(void)
 {
-    while (*str)
-    {
-        uart_tx(*str++);
-    }
+	if (!(UCSR0A & (1 << RXC0)))
+		return;
+	char c = UDR0;
+
+	if (c == LOG_DUMP)
+	{
+		elog_dump();
+		uart_flush();
+		while (UCSR0A & (1 << RXC0))
+			c = UDR0;
+	}
 }
 
 /*
 **-------------------------------
-** I2C Function
+** AHT20 (I2C: lib/twi.c)
 **-------------------------------
 */
-void i2c_init(void)
-{
-	/*
-	** TWSR - TWI Status Register 
-	** TWBR - TWI Bit Rate Register (SCL frequency setting) - I2C standard Clock Speed -> 100kHz
-	** TWCR - TWI Control Register
-	*/
-	TWSR = 0x00;             /* Prescaler value = 1 */
-	/*
-	** Additional Note:
-	** SCL frequency = CPU clock / (16 + 2 * TWBR * prescaler)
-	** TWBR = ((F_CPU / SCL) - 16) / (2 * prescaler)
-	*/
-	TWBR = ((F_CPU / 100000) - 16) / 2; /* Set bit rate for 100kHz */
-	TWCR = (1 << TWEN);     /* Enable TWI - page 240 (description) */
-}
-
-void i2c_start(void)
-{
-	TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN); /* Send START condition - Page 225 */
-
-	while (!(TWCR & (1 << TWINT)));   /* Wait for TWINT flag set in TWCR Register (start condition is transmitted) - page 225 */
-}
 
 /*
-** Acknowledge read (with ACK)
-** Send 7-bit address + Read bit
+** Raw frame -> C / %RH (the float path, no I2C)
+** Data Format:
+** Byte 0: Status
+** Byte 1: Humidity MSB (upper 8 bits)
+** Byte 2: Humidity LSB (next 8 bits)
+** Byte 3: Humidity XLSB + Temperature MSB (4 bits each) (that's why we & 0x0F and >>4)
+** Byte 4: Temperature LSB (middle 8 bits)
+** Byte 5: Temperature XLSB (lower 8 bits)
+** Byte 6: CRC (not used here)
 */
-uint8_t i2c_read_ack(void)
+void aht20_convert(const uint8_t *data, float *temperature, float *humidity)
 {
-	TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWEA); /* Enable TWI, generation of ACK after reception */
+	uint32_t raw_temperature = (((uint32_t)data[3] & 0x0F) << 16) | \
+                               ((uint32_t)data[4] << 8) | \
+                               ((uint32_t)data[5]);
 
-	while (!(TWCR & (1 << TWINT)));   /* Wait for TWINT flag set in TWCR Register (data is received) - page 225 */
+    uint32_t raw_humidity = (((uint32_t)data[1] << 12) | \
+                             ((uint32_t)data[2] << 4) | \
+                             ((uint32_t)(data[3] & 0xF0) >> 4));
 
-	return TWDR; /* Return received data */
+	*temperature = ((float)raw_temperature * TEMPERATURE_SCALE / RESOLUTION) - OFFSET;
+	*humidity = ((float)raw_humidity * HUMIDITY_SCALE / RESOLUTION);
 }
 
 /*
-** Non-Acknowledge read (with NACK)
-** Send 7-bit address + Read bit
-** known as completion of data reception
+** Read the 7 bytes of the last measurement and convert them
+** Returns the status byte (AHT20_BUSY set -> conversion not finished, values not valid)
 */
-uint8_t i2c_read_nack(void)
-{
-	TWCR = (1 << TWINT) | (1 << TWEN); /* Enable TWI, generation of NACK after reception */
-
-	while (!(TWCR & (1 << TWINT)));   /* Wait for TWINT flag set in TWCR Register (data is received) - page 225 */
-
-	return TWDR; /* Return received data */
-}
-
-void i2c_read_aht20(void)
+uint8_t aht20_read(float *temperature, float *humidity)
 {
 	uint8_t data[7];
 
@@ -160,37 +148,31 @@ void i2c_read_aht20(void)
 	data[6] = i2c_read_nack();
 	i2c_stop();
 
-	// Process data to extract temperature and humidity
-	/*
-	** Data Format:
-	** Byte 0: Status
-	** Byte 1: Humidity MSB (upper 8 bits)
-	** Byte 2: Humidity LSB (next 8 bits)
-	** Byte 3: Humidity XLSB + Temperature MSB (4 bits each) (that's why we & 0x0F and >>4)
-	** Byte 4: Temperature LSB (middle 8 bits)
-	** Byte 5: Temperature XLSB (lower 8 bits)
-	** Byte 6: CRC (not used here)
-	*/
-	uint32_t raw_temperature = (((uint32_t)data[3] & 0x0F) << 16) | \
-                               ((uint32_t)data[4] << 8) | \
-                               ((uint32_t)data[5]);
+	aht20_convert(data, temperature, humidity);
+	return data[0];
+}
 
-    uint32_t raw_humidity = (((uint32_t)data[1] << 12) | \
-                             ((uint32_t)data[2] << 4) | \
-                             ((uint32_t)(data[3] & 0xF0) >> 4));
+void i2c_read_aht20(void)
+{
+	float temperature;
+	float humidity;
 
-	float temperature = ((float)raw_temperature * TEMPERATURE_SCALE / RESOLUTION) - OFFSET;
-	float humidity = ((float)raw_humidity * HUMIDITY_SCALE / RESOLUTION);
+	aht20_read(&temperature, &humidity);
 
 	// Store the measurements
 	measurement_process(temperature, humidity);
 
 	compute_average(&temperature, &humidity);
+	log_sample(millis(), temperature, humidity);
 
 	// For demonstration, just print raw data
 	char buffer[10];
+	char timestamp[11];
 	dtostrf(temperature, 5, 1, buffer); /* avr-libc function */
-	uart_puts("Temperature: ");
+	uart_puts("[");
+	ultoa(millis(), timestamp, 10); /* Time of the measurement (ms since boot) */
+	uart_puts(timestamp);
+	uart_puts(" ms] Temperature: ");
 	uart_puts(buffer);
 	uart_puts(" C ");
 
@@ -200,39 +182,181 @@ void i2c_read_aht20(void)
 	uart_puts("%\r\n");
 }
 
-void i2c_write(unsigned char data)
+/* Trigger measurement: 0xAC 0x33 0x00, result ready about 80ms later */
+void aht20_trigger(void)
 {
-	TWDR = data; /* Load data into TWDR Register */
-	TWCR = (1 << TWINT) | (1 << TWEN); /* Start transmission of data */
-	while (!(TWCR & (1 << TWINT)));   /* Wait for TWINT flag set in TWCR Register (data is transmitted) - page 225 */
+	i2c_start();
+
+	i2c_write(I2C_ADDRESS_AHT20);
+	i2c_write(MEASUREMENT_CMD);
+	i2c_write(0x33);
+	i2c_write(0x00);
+
+	i2c_stop();
 }
 
-void i2c_stop(void)
+#if NODE_MODE
+/*
+**-------------------------------
+** Node Mode (battery)
+**-------------------------------
+** One cycle (NODE_PERIOD_MS)
+**  1. wake up (watchdog), trigger a measurement, read the ADC channels (~1.3ms at 125kHz)
+**  2. power down through the conversion (AHT20_CONVERSION_MS, 16ms more while busy)
+**  3. read, filter (average of the last 3 / of NODE_ADC_OVERSAMPLE conversions), store in the batch
+**  4. batch full -> one UART burst
+**  5. power down for the rest of the period
+** systime (Timer1) stops in power down: micros() only counts the awake time,
+** so the awake time of a cycle is the micros() difference over the whole cycle
+*/
+typedef struct s_sample
 {
-	/* Stop condition - page 225 */
-	TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWSTO);
+	uint32_t	time;		/* ms since boot (awake + slept) */
+	float		temperature;
+	float		humidity;
+	uint16_t	adc[NODE_ADC_CHANNELS];	/* 10 bit, averaged */
+	uint16_t	awake_us;	/* awake time of the cycle before */
+}	t_sample;
+
+static t_sample g_batch[NODE_BATCH];
+static uint8_t g_batch_count = 0;
+
+static const char *const g_adc_name[NODE_ADC_CHANNELS] = { " RV1: ", " LDR: ", " NTC: " };
+
+/* ADC0 ~ ADC2, NODE_ADC_OVERSAMPLE conversions each, ADC stopped before the power down */
+void node_adc(uint16_t *values)
+{
+	init_adc();
+	for (uint8_t channel = 0; channel < NODE_ADC_CHANNELS; channel++)
+	{
+		uint16_t sum = 0;
+
+		for (uint8_t i = 0; i < NODE_ADC_OVERSAMPLE; i++)
+		{
+			sum += adc_read(ADC_CHANNEL(channel));
+		}
+		values[channel] = sum / NODE_ADC_OVERSAMPLE;
+	}
+	adc_stop();
 }
 
-int main(void)
+void node_burst(void)
 {
-	uart_init(UBRRN);
-	i2c_init();
+	char buffer[10];
+	uint32_t awake = 0;
+
+	clock_set(CLOCK_16MHZ);	/* Full speed for the burst (baud rate and float formatting) */
+
+	for (uint8_t i = 0; i < g_batch_count; i++)
+	{
+		uart_puts("[");
+		uart_put_u32(g_batch[i].time);
+		uart_puts(" ms] Temperature: ");
+		dtostrf(g_batch[i].temperature, 5, 1, buffer);
+		uart_puts(buffer);
+		uart_puts(" C Humidity: ");
+		dtostrf(g_batch[i].humidity, 5, 1, buffer);
+		uart_puts(buffer);
+		uart_puts("%");
+		for (uint8_t channel = 0; channel < NODE_ADC_CHANNELS; channel++)
+		{
+			uart_puts(g_adc_name[channel]);
+			uart_put_u32(g_batch[i].adc[channel]);
+		}
+		uart_puts(" awake: ");
+		uart_put_u32(g_batch[i].awake_us);
+		uart_puts(" us\r\n");
+		awake += g_batch[i].awake_us;
+	}
+	uart_puts("batch: ");
+	uart_put_u32(g_batch_count);
+	uart_puts(" samples, awake ");
+	uart_put_u32(awake / g_batch_count);
+	uart_puts(" us/cycle (period ");
+	uart_put_u32(NODE_PERIOD_MS);
+	uart_puts(" ms)\r\n");
+
+	uart_flush();
+	log_command();		/* The receiver only runs while awake: a 'D' sent during the burst */
+	g_batch_count = 0;
+	clock_set(NODE_CLOCK);
+}
+
+void node_loop(void)
+{
+	uint32_t awake = 0;	/* Awake time of the cycle before (its burst included) */
+
+	clock_listen(uart_clock);
+	clock_listen(i2c_clock);
+	clock_listen(adc_clock);
+	clock_set(NODE_CLOCK);
 
 	while (1)
 	{
-		i2c_start();
+		uint32_t start = micros();
+		uint8_t status;
+		float temperature;
+		float humidity;
+		uint16_t adc[NODE_ADC_CHANNELS];
+
+		aht20_trigger();
+		node_adc(adc);		/* While the AHT20 converts */
+		wakeup_sleep_ms(AHT20_CONVERSION_MS);
+
+		/* Still busy: 16ms more, a few times */
+		for (uint8_t tries = 0; (status = aht20_read(&temperature, &humidity)) & AHT20_BUSY; tries++)
+		{
+			if (tries == 4)
+				break;
+			wakeup_sleep(WAKEUP_16MS);
+		}
+
+		if (!(status & AHT20_BUSY))
+		{
+			measurement_process(temperature, humidity);
+			compute_average(&temperature, &humidity);
+
+			t_sample *sample = &g_batch[g_batch_count++];
+			sample->time = millis() + wakeup_slept_ms();
+			sample->temperature = temperature;
+			sample->humidity = humidity;
+			for (uint8_t channel = 0; channel < NODE_ADC_CHANNELS; channel++)
+				sample->adc[channel] = adc[channel];
+			sample->awake_us = (awake > 0xFFFF) ? 0xFFFF : awake;
+			log_sample(sample->time, temperature, humidity);
+		}
+
+		if (g_batch_count == NODE_BATCH)
+			node_burst();
+		elog_sync();	/* EE_READY_vect does not wake the CPU from power down */
+
+		awake = micros() - start;	/* micros() did not count the power down */
+		wakeup_sleep_ms(NODE_PERIOD_MS - AHT20_CONVERSION_MS);
+	}
+}
+#endif
+
+int main(void)
+{
+	uart_init(UART_UBRR(UART_BAUDRATE));	/* lib/uart.c, 115200 8N1 */
+	i2c_init();
+	systime_init();
+	elog_init(2, LOG_TICK_MS);	/* Temperature, humidity */
+	sei();
 
-		i2c_write(I2C_ADDRESS_AHT20);
-		i2c_write(MEASUREMENT_CMD);
-		i2c_write(0x33);
-		i2c_write(0x00);
+#if NODE_MODE
+	node_loop();
+#endif
 
-		i2c_stop();
+	while (1)
+	{
+		aht20_trigger();
 
 		_delay_ms(1000);
 		i2c_read_aht20();
 		uart_puts("\r\n");
 		_delay_ms(1000);
+		log_command();
 	}
 
 	return 0;
@@ -0,0 +1,82 @@
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "icp.h"
+#include "uart.h"
+
+/*
+** Frequency / duty meter
+**  - Signal on PB0 (ICP1), 0 ~ 5V
+**  - Period and frequency (auto gate of ~100ms), then duty cycle, over and over
+*/
+
+/*
+** mHz -> "123.456"
+*/
+void uart_put_milli(uint32_t value)
+{
+    char buffer[4];
+    uint16_t frac = value % 1000;
+
+    uart_put_u32(value / 1000);
+    uart_tx('.');
+    buffer[0] = '0' + frac / 100;
+    buffer[1] = '0' + (frac / 10) % 10;
+    buffer[2] = '0' + frac % 10;
+    buffer[3] = '\0';
+    uart_puts(buffer);
+}
+
+/*
+** Wait for a result, 0 when no edge came (no signal)
+*/
+uint8_t wait_result(t_icp_result *result)
+{
+    for (uint16_t ms = 0; ms < 2 * ICP_GATE_MS + 1000; ms++)
+    {
+        if (icp_read(result))
+        {
+            icp_stop();
+            return 1;
+        }
+        _delay_ms(1);
+    }
+    icp_stop();
+    uart_puts("no signal\r\n");
+    return 0;
+}
+
+int main(void)
+{
+    t_icp_result result;
+
+    uart_init(UART_UBRR(UART_BAUDRATE));    /* lib/uart.c, 115200 8N1 */
+    icp_init(ICP_RISING | ICP_NOISE_CANCEL);
+
+    sei();
+
+    while (1)
+    {
+        icp_start(ICP_MODE_PERIOD, 0);  /* Auto gate */
+        if (!wait_result(&result))
+            continue;
+
+        uart_puts("freq: ");
+        uart_put_milli(icp_freq_mhz(&result));
+        uart_puts(" Hz  gate: ");
+        uart_put_u32(result.ticks);
+        uart_puts(" ticks / ");
+        uart_put_u32(result.periods);
+        uart_puts(" periods");
+
+        icp_start(ICP_MODE_DUTY, 1);
+        if (!wait_result(&result))
+            continue;
+
+        uart_puts("  duty: ");
+        uart_put_milli((uint32_t)icp_duty_permille(&result) * 100);
+        uart_puts(" %\r\n");
+
+        _delay_ms(500);
+    }
+}
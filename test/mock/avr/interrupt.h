@@ -0,0 +1,22 @@
+#ifndef MOCK_AVR_INTERRUPT_H
+# define MOCK_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+/*
+** Host build: an ISR is a plain function named after its vector,
+** the test calls it (USART_RX_vect()) where the hardware would jump to it
+** sei() / cli() only move the I bit of SREG (read by ATOMIC_BLOCK and the tests)
+*/
+#define ISR(vector, ...)    void vector(void); void vector(void)
+#define EMPTY_INTERRUPT(vector) void vector(void) { }
+#define ISR_NAKED
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_ALIASOF(vector)
+
+#define sei()               (SREG |= (1 << SREG_I))
+#define cli()               (SREG &= ~(1 << SREG_I))
+#define reti()              return
+
+#endif
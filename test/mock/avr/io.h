@@ -0,0 +1,483 @@
+#ifndef MOCK_AVR_IO_H
+# define MOCK_AVR_IO_H
+
+#include <stdint.h>
+
+/*
+** Host build of <avr/io.h> (test/ only): ATmega328P registers on x86
+**  - every register is a byte of g_mock_io[], at its data space address (datasheet page 624 ~)
+**    like _SFR_MEM8() of avr-libc, so PORTB / DDRB... are plain memory
+**  - 16 bit registers read / write the two bytes (low byte first, as the CPU)
+**  - UDR0, UCSR0A, ADCSRA, TWCR, EECR and EEDR go through a hook (mock.c) which plays the
+**    peripheral:
+**      UDR0 writes are captured, UCSR0A gives RX bytes queued by the test,
+**      ADSC returns the value injected for the ADMUX channel,
+**      each TWCR step takes the next scripted TWI status,
+**      EERE / EEMPE + EEPE read / write g_mock.eeprom at EEAR
+*/
+
+typedef struct __attribute__((packed, may_alias)) s_mock_u16
+{
+    uint16_t    value;
+}   t_mock_u16;
+
+extern volatile uint8_t g_mock_io[0x100];
+
+volatile uint16_t  *mock_udr0(void);
+volatile uint8_t   *mock_ucsr0a(void);
+volatile uint8_t   *mock_adcsra(void);
+volatile uint16_t  *mock_twcr(void);
+volatile uint8_t   *mock_eecr(void);
+volatile uint8_t   *mock_eedr(void);
+
+#define _SFR_MEM8(addr)     (g_mock_io[addr])
+#define _SFR_MEM16(addr)    (((volatile t_mock_u16 *)&g_mock_io[addr])->value)
+#define _SFR_IO_ADDR(reg)   0
+#define _SFR_MEM_ADDR(reg)  0
+
+#define PINB        _SFR_MEM8(0x23)
+#define DDRB        _SFR_MEM8(0x24)
+#define PORTB       _SFR_MEM8(0x25)
+#define PINC        _SFR_MEM8(0x26)
+#define DDRC        _SFR_MEM8(0x27)
+#define PORTC       _SFR_MEM8(0x28)
+#define PIND        _SFR_MEM8(0x29)
+#define DDRD        _SFR_MEM8(0x2A)
+#define PORTD       _SFR_MEM8(0x2B)
+#define TIFR0       _SFR_MEM8(0x35)
+#define TIFR1       _SFR_MEM8(0x36)
+#define TIFR2       _SFR_MEM8(0x37)
+#define PCIFR       _SFR_MEM8(0x3B)
+#define EIFR        _SFR_MEM8(0x3C)
+#define EIMSK       _SFR_MEM8(0x3D)
+#define GPIOR0      _SFR_MEM8(0x3E)
+#define EEARL       _SFR_MEM8(0x41)
+#define EEARH       _SFR_MEM8(0x42)
+#define GTCCR       _SFR_MEM8(0x43)
+#define TCCR0A      _SFR_MEM8(0x44)
+#define TCCR0B      _SFR_MEM8(0x45)
+#define TCNT0       _SFR_MEM8(0x46)
+#define OCR0A       _SFR_MEM8(0x47)
+#define OCR0B       _SFR_MEM8(0x48)
+#define GPIOR1      _SFR_MEM8(0x4A)
+#define GPIOR2      _SFR_MEM8(0x4B)
+#define SPCR        _SFR_MEM8(0x4C)
+#define SPSR        _SFR_MEM8(0x4D)
+#define SPDR        _SFR_MEM8(0x4E)
+#define ACSR        _SFR_MEM8(0x50)
+#define SMCR        _SFR_MEM8(0x53)
+#define MCUSR       _SFR_MEM8(0x54)
+#define MCUCR       _SFR_MEM8(0x55)
+#define SPMCSR      _SFR_MEM8(0x57)
+#define SPL         _SFR_MEM8(0x5D)
+#define SPH         _SFR_MEM8(0x5E)
+#define SREG        _SFR_MEM8(0x5F)
+#define WDTCSR      _SFR_MEM8(0x60)
+#define CLKPR       _SFR_MEM8(0x61)
+#define PRR         _SFR_MEM8(0x64)
+#define OSCCAL      _SFR_MEM8(0x66)
+#define PCICR       _SFR_MEM8(0x68)
+#define EICRA       _SFR_MEM8(0x69)
+#define PCMSK0      _SFR_MEM8(0x6B)
+#define PCMSK1      _SFR_MEM8(0x6C)
+#define PCMSK2      _SFR_MEM8(0x6D)
+#define TIMSK0      _SFR_MEM8(0x6E)
+#define TIMSK1      _SFR_MEM8(0x6F)
+#define TIMSK2      _SFR_MEM8(0x70)
+#define ADCL        _SFR_MEM8(0x78)
+#define ADCH        _SFR_MEM8(0x79)
+#define ADCSRB      _SFR_MEM8(0x7B)
+#define ADMUX       _SFR_MEM8(0x7C)
+#define DIDR0       _SFR_MEM8(0x7E)
+#define DIDR1       _SFR_MEM8(0x7F)
+#define TCCR1A      _SFR_MEM8(0x80)
+#define TCCR1B      _SFR_MEM8(0x81)
+#define TCCR1C      _SFR_MEM8(0x82)
+#define TCNT1L      _SFR_MEM8(0x84)
+#define TCNT1H      _SFR_MEM8(0x85)
+#define ICR1L       _SFR_MEM8(0x86)
+#define ICR1H       _SFR_MEM8(0x87)
+#define OCR1AL      _SFR_MEM8(0x88)
+#define OCR1AH      _SFR_MEM8(0x89)
+#define OCR1BL      _SFR_MEM8(0x8A)
+#define OCR1BH      _SFR_MEM8(0x8B)
+#define TCCR2A      _SFR_MEM8(0xB0)
+#define TCCR2B      _SFR_MEM8(0xB1)
+#define TCNT2       _SFR_MEM8(0xB2)
+#define OCR2A       _SFR_MEM8(0xB3)
+#define OCR2B       _SFR_MEM8(0xB4)
+#define ASSR        _SFR_MEM8(0xB6)
+#define TWBR        _SFR_MEM8(0xB8)
+#define TWSR        _SFR_MEM8(0xB9)
+#define TWAR        _SFR_MEM8(0xBA)
+#define TWDR        _SFR_MEM8(0xBB)
+#define TWAMR       _SFR_MEM8(0xBD)
+#define UCSR0B      _SFR_MEM8(0xC1)
+#define UCSR0C      _SFR_MEM8(0xC2)
+#define UBRR0L      _SFR_MEM8(0xC4)
+#define UBRR0H      _SFR_MEM8(0xC5)
+#define EEAR        _SFR_MEM16(0x41)
+#define ADC         _SFR_MEM16(0x78)
+#define ADCW        _SFR_MEM16(0x78)
+#define TCNT1       _SFR_MEM16(0x84)
+#define ICR1        _SFR_MEM16(0x86)
+#define OCR1A       _SFR_MEM16(0x88)
+#define OCR1B       _SFR_MEM16(0x8A)
+#define UBRR0       _SFR_MEM16(0xC4)
+#define SP          _SFR_MEM16(0x5D)
+
+/* Registers played by mock.c */
+#define UDR0        (*mock_udr0())
+#define UCSR0A      (*mock_ucsr0a())
+#define ADCSRA      (*mock_adcsra())
+#define TWCR        (*mock_twcr())
+#define EECR        (*mock_eecr())
+#define EEDR        (*mock_eedr())
+
+/* Bits (same numbers as avr-libc iom328p.h) */
+#define TOV0 0
+#define OCF0A 1
+#define OCF0B 2
+#define TOV1 0
+#define OCF1A 1
+#define OCF1B 2
+#define ICF1 5
+#define TOV2 0
+#define OCF2A 1
+#define OCF2B 2
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+#define INTF0 0
+#define INTF1 1
+#define INT0 0
+#define INT1 1
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+#define EEPM0 4
+#define EEPM1 5
+#define PSRSYNC 0
+#define PSRASY 1
+#define TSM 7
+#define WGM00 0
+#define WGM01 1
+#define COM0B0 4
+#define COM0B1 5
+#define COM0A0 6
+#define COM0A1 7
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define WGM02 3
+#define FOC0B 6
+#define FOC0A 7
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+#define IVCE 0
+#define IVSEL 1
+#define PUD 4
+#define BODSE 5
+#define BODS 6
+#define SPMEN 0
+#define PGERS 1
+#define PGWRT 2
+#define BLBSET 3
+#define RWWSRE 4
+#define SIGRD 5
+#define RWWSB 6
+#define SPMIE 7
+#define WDP0 0
+#define WDP1 1
+#define WDP2 2
+#define WDE 3
+#define WDCE 4
+#define WDP3 5
+#define WDIE 6
+#define WDIF 7
+#define CLKPS0 0
+#define CLKPS1 1
+#define CLKPS2 2
+#define CLKPS3 3
+#define CLKPCE 7
+#define PRADC 0
+#define PRUSART0 1
+#define PRSPI 2
+#define PRTIM1 3
+#define PRTIM0 5
+#define PRTIM2 6
+#define PRTWI 7
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define ISC00 0
+#define ISC01 1
+#define ISC10 2
+#define ISC11 3
+#define TOIE0 0
+#define OCIE0A 1
+#define OCIE0B 2
+#define TOIE1 0
+#define OCIE1A 1
+#define OCIE1B 2
+#define ICIE1 5
+#define TOIE2 0
+#define OCIE2A 1
+#define OCIE2B 2
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE 3
+#define ADIF 4
+#define ADATE 5
+#define ADSC 6
+#define ADEN 7
+#define ADTS0 0
+#define ADTS1 1
+#define ADTS2 2
+#define ACME 6
+#define MUX0 0
+#define MUX1 1
+#define MUX2 2
+#define MUX3 3
+#define ADLAR 5
+#define REFS0 6
+#define REFS1 7
+#define WGM10 0
+#define WGM11 1
+#define COM1B0 4
+#define COM1B1 5
+#define COM1A0 6
+#define COM1A1 7
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define WGM13 4
+#define ICES1 6
+#define ICNC1 7
+#define FOC1B 6
+#define FOC1A 7
+#define WGM20 0
+#define WGM21 1
+#define COM2B0 4
+#define COM2B1 5
+#define COM2A0 6
+#define COM2A1 7
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM22 3
+#define FOC2B 6
+#define FOC2A 7
+#define TCR2BUB 0
+#define TCR2AUB 1
+#define OCR2BUB 2
+#define OCR2AUB 3
+#define TCN2UB 4
+#define AS2 5
+#define EXCLK 6
+#define TWPS0 0
+#define TWPS1 1
+#define TWS3 3
+#define TWS4 4
+#define TWS5 5
+#define TWS6 6
+#define TWS7 7
+#define TWIE 0
+#define TWEN 2
+#define TWWC 3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+#define MPCM0 0
+#define U2X0 1
+#define UPE0 2
+#define DOR0 3
+#define FE0 4
+#define UDRE0 5
+#define TXC0 6
+#define RXC0 7
+#define TXB80 0
+#define RXB80 1
+#define UCSZ02 2
+#define TXEN0 3
+#define RXEN0 4
+#define UDRIE0 5
+#define TXCIE0 6
+#define RXCIE0 7
+#define UCPOL0 0
+#define UCSZ00 1
+#define UCSZ01 2
+#define USBS0 3
+#define UPM00 4
+#define UPM01 5
+#define UMSEL00 6
+#define UMSEL01 7
+#define SPR0 0
+#define SPR1 1
+#define CPHA 2
+#define CPOL 3
+#define MSTR 4
+#define DORD 5
+#define SPE 6
+#define SPIE 7
+#define SPI2X 0
+#define WCOL 6
+#define SPIF 7
+#define ADC0D 0
+#define ADC1D 1
+#define ADC2D 2
+#define ADC3D 3
+#define ADC4D 4
+#define ADC5D 5
+#define SREG_C 0
+#define SREG_Z 1
+#define SREG_N 2
+#define SREG_V 3
+#define SREG_S 4
+#define SREG_H 5
+#define SREG_T 6
+#define SREG_I 7
+#define PB0 0
+#define PORTB0 0
+#define DDB0 0
+#define PINB0 0
+#define PB1 1
+#define PORTB1 1
+#define DDB1 1
+#define PINB1 1
+#define PB2 2
+#define PORTB2 2
+#define DDB2 2
+#define PINB2 2
+#define PB3 3
+#define PORTB3 3
+#define DDB3 3
+#define PINB3 3
+#define PB4 4
+#define PORTB4 4
+#define DDB4 4
+#define PINB4 4
+#define PB5 5
+#define PORTB5 5
+#define DDB5 5
+#define PINB5 5
+#define PB6 6
+#define PORTB6 6
+#define DDB6 6
+#define PINB6 6
+#define PB7 7
+#define PORTB7 7
+#define DDB7 7
+#define PINB7 7
+#define PC0 0
+#define PORTC0 0
+#define DDC0 0
+#define PINC0 0
+#define PC1 1
+#define PORTC1 1
+#define DDC1 1
+#define PINC1 1
+#define PC2 2
+#define PORTC2 2
+#define DDC2 2
+#define PINC2 2
+#define PC3 3
+#define PORTC3 3
+#define DDC3 3
+#define PINC3 3
+#define PC4 4
+#define PORTC4 4
+#define DDC4 4
+#define PINC4 4
+#define PC5 5
+#define PORTC5 5
+#define DDC5 5
+#define PINC5 5
+#define PC6 6
+#define PORTC6 6
+#define DDC6 6
+#define PINC6 6
+#define PC7 7
+#define PORTC7 7
+#define DDC7 7
+#define PINC7 7
+#define PD0 0
+#define PORTD0 0
+#define DDD0 0
+#define PIND0 0
+#define PD1 1
+#define PORTD1 1
+#define DDD1 1
+#define PIND1 1
+#define PD2 2
+#define PORTD2 2
+#define DDD2 2
+#define PIND2 2
+#define PD3 3
+#define PORTD3 3
+#define DDD3 3
+#define PIND3 3
+#define PD4 4
+#define PORTD4 4
+#define DDD4 4
+#define PIND4 4
+#define PD5 5
+#define PORTD5 5
+#define DDD5 5
+#define PIND5 5
+#define PD6 6
+#define PORTD6 6
+#define DDD6 6
+#define PIND6 6
+#define PD7 7
+#define PORTD7 7
+#define DDD7 7
+#define PIND7 7
+#define PCINT0 0
+#define PCINT1 1
+#define PCINT2 2
+#define PCINT3 3
+#define PCINT4 4
+#define PCINT5 5
+#define PCINT6 6
+#define PCINT7 7
+#define PCINT8 0
+#define PCINT9 1
+#define PCINT10 2
+#define PCINT11 3
+#define PCINT12 4
+#define PCINT13 5
+#define PCINT14 6
+#define PCINT15 7
+#define PCINT16 0
+#define PCINT17 1
+#define PCINT18 2
+#define PCINT19 3
+#define PCINT20 4
+#define PCINT21 5
+#define PCINT22 6
+#define PCINT23 7
+#define RAMEND 0x8FF
+#define RAMSTART 0x100
+#define E2END 0x3FF
+#define SPM_PAGESIZE 128
+#define FLASHEND 0x7FFF
+#define E2PAGESIZE 4
+
+#define _BV(bit)                    (1 << (bit))
+#define bit_is_set(reg, bit)        ((reg) & _BV(bit))
+#define bit_is_clear(reg, bit)      (!((reg) & _BV(bit)))
+#define loop_until_bit_is_set(reg, bit)     do { } while (bit_is_clear(reg, bit))
+#define loop_until_bit_is_clear(reg, bit)   do { } while (bit_is_set(reg, bit))
+
+#endif
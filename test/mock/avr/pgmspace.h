@@ -0,0 +1,25 @@
+#ifndef MOCK_AVR_PGMSPACE_H
+# define MOCK_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+** Host build: one address space, flash data is ordinary const data
+*/
+#define PROGMEM
+#define PGM_P               const char *
+#define PSTR(s)             (s)
+
+#define pgm_read_byte(addr)     (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)     (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)    (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr)      (*(void * const *)(addr))
+
+#define memcpy_P            memcpy
+#define strcmp_P            strcmp
+#define strncmp_P           strncmp
+#define strlen_P            strlen
+#define strcpy_P            strcpy
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef MOCK_AVR_SLEEP_H
+# define MOCK_AVR_SLEEP_H
+
+#include <avr/io.h>
+
+/*
+** Host build: sleep_cpu() returns at once and is counted (g_mock.sleeps)
+** SMCR keeps the mode and SE like the hardware
+*/
+#define SLEEP_MODE_IDLE         0
+#define SLEEP_MODE_ADC          (1 << SM0)
+#define SLEEP_MODE_PWR_DOWN     (1 << SM1)
+#define SLEEP_MODE_PWR_SAVE     ((1 << SM0) | (1 << SM1))
+#define SLEEP_MODE_STANDBY      ((1 << SM1) | (1 << SM2))
+#define SLEEP_MODE_EXT_STANDBY  ((1 << SM0) | (1 << SM1) | (1 << SM2))
+
+void    mock_sleep(void);
+
+#define set_sleep_mode(mode)    (SMCR = (SMCR & ~((1 << SM0) | (1 << SM1) | (1 << SM2))) | (mode))
+#define sleep_enable()          (SMCR |= (1 << SE))
+#define sleep_disable()         (SMCR &= ~(1 << SE))
+#define sleep_cpu()             mock_sleep()
+#define sleep_mode()            do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
+#define sleep_bod_disable()     do { } while (0)
+
+#endif
@@ -0,0 +1,361 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <util/delay.h>
+#include <util/twi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mock.h"
+
+/*
+** Register file: g_mock_io[address] (avr/io.h)
+** The 6 hooked registers have their own cell, 16 bit for UDR0 and TWCR:
+**  - high byte MOCK_OWNED -> value set by the mock (low byte = register)
+**  - anything else        -> the driver has written the cell since (uint8_t store = 0x00xx,
+**                            char 0x80 ~ 0xFF = 0xFFxx), not seen yet by the peripheral
+** The hook runs at every access of the register (the macro calls it), so a write is
+** handled at the next access, like the hardware which acts after the store
+*/
+#define MOCK_OWNED      0x1200
+#define MOCK_PENDING(cell)  (((cell) & 0xFF00) != MOCK_OWNED)
+
+volatile uint8_t    g_mock_io[0x100];
+t_mock              g_mock;
+
+/* avr-libc linker script symbols of lib/mem.c (__data_start / __bss_start: the host ones) */
+uint8_t __data_end, __heap_start;
+
+static volatile uint16_t    g_udr0 = MOCK_OWNED;
+static volatile uint8_t     g_ucsr0a;
+static volatile uint8_t     g_adcsra;
+static volatile uint16_t    g_twcr = MOCK_OWNED;
+static volatile uint8_t     g_eecr;
+static volatile uint8_t     g_eedr;
+
+void mock_reset(void)
+{
+    memset((void *)g_mock_io, 0, sizeof(g_mock_io));
+    memset(&g_mock, 0, sizeof(g_mock));
+    g_udr0 = MOCK_OWNED;
+    g_ucsr0a = 0;
+    g_adcsra = 0;
+    g_twcr = MOCK_OWNED;
+    g_eecr = 0;
+    g_eedr = 0;
+    memset(g_mock.eeprom, 0xFF, sizeof(g_mock.eeprom));
+}
+
+/* ---------------- USART0 ---------------- */
+
+static void udr0_capture(void)
+{
+    if (!MOCK_PENDING(g_udr0))
+        return;
+    if (g_mock.tx_len < MOCK_QUEUE)
+        g_mock.tx[g_mock.tx_len++] = (uint8_t)g_udr0;
+    g_udr0 = MOCK_OWNED | (uint8_t)g_udr0;
+}
+
+volatile uint16_t *mock_udr0(void)
+{
+    udr0_capture();
+    return &g_udr0;
+}
+
+/*
+** Transmitter is always ready (UDRE0) and done (TXC0)
+** RXC0 follows the queue of mock_rx_push(): the next byte is put in UDR0 when
+** the previous one has been read (RXC0 is cleared by the read on the hardware)
+*/
+volatile uint8_t *mock_ucsr0a(void)
+{
+    udr0_capture();
+    g_ucsr0a |= (1 << UDRE0) | (1 << TXC0);
+    if (g_mock.rx_head < g_mock.rx_len)
+    {
+        g_udr0 = MOCK_OWNED | g_mock.rx[g_mock.rx_head++];
+        g_ucsr0a |= (1 << RXC0);
+    }
+    else
+    {
+        g_ucsr0a &= ~(1 << RXC0);
+    }
+    return &g_ucsr0a;
+}
+
+void mock_rx_push(const char *bytes, size_t len)
+{
+    if (g_mock.rx_head == g_mock.rx_len)
+    {
+        g_mock.rx_head = 0;
+        g_mock.rx_len = 0;
+    }
+    while (len-- && g_mock.rx_len < MOCK_QUEUE)
+    {
+        g_mock.rx[g_mock.rx_len++] = (uint8_t)*bytes++;
+    }
+}
+
+void mock_rx_isr(void (*vector)(void), uint8_t byte)
+{
+    udr0_capture();
+    g_udr0 = MOCK_OWNED | byte;
+    g_ucsr0a |= (1 << RXC0);
+    vector();
+    g_ucsr0a &= ~(1 << RXC0);
+}
+
+size_t mock_tx_take(char *out, size_t size)
+{
+    size_t len;
+
+    udr0_capture();
+    len = g_mock.tx_len < size ? g_mock.tx_len : size;
+    memcpy(out, g_mock.tx, len);
+    if (len < size)
+        out[len] = '\0';
+    g_mock.tx_len = 0;
+    return len;
+}
+
+/* ---------------- ADC ---------------- */
+
+/*
+** A conversion started by ADSC ends at the next access: ADC = injected value,
+** ADSC cleared, ADIF set (page 250)
+*/
+volatile uint8_t *mock_adcsra(void)
+{
+    if (g_adcsra & (1 << ADSC))
+    {
+        ADC = g_mock.adc[ADMUX & 0x0F] & 0x3FF;
+        g_adcsra = (g_adcsra & ~(1 << ADSC)) | (1 << ADIF);
+        g_mock.conversions++;
+    }
+    return &g_adcsra;
+}
+
+void mock_adc_set(uint8_t channel, uint16_t value)
+{
+    g_mock.adc[channel & 0x0F] = value;
+}
+
+/* ---------------- TWI ---------------- */
+
+static uint8_t twi_next_status(uint8_t normal)
+{
+    uint8_t forced = 0;
+
+    if (g_mock.twi_status_head < g_mock.twi_status_len)
+        forced = g_mock.twi_status[g_mock.twi_status_head++];
+    return forced ? forced : normal;
+}
+
+/*
+** One bus step per TWCR write with TWINT (page 225 ~ 233)
+**  - TWSTO: stop sent at once (TWSTO cleared, no TWINT)
+**  - TWSTA: START, or REPEATED START when no STOP was sent since the last one
+**  - after a START, TWDR is the address byte: SLA+W / SLA+R ack when a slave has this
+**    address (mock_twi_device()), nack else
+**  - then data sent (ack) or data received (TWEA -> ack, else nack)
+*/
+static void twi_step(uint8_t control)
+{
+    uint8_t status = TWSR & TW_STATUS_MASK;
+
+    if (control & (1 << TWSTO))
+    {
+        g_mock.twi_stops++;
+        g_twcr = MOCK_OWNED | (control & ~((1 << TWSTO) | (1 << TWINT)));
+        TWSR = (TWSR & ~TW_STATUS_MASK) | TW_NO_INFO;
+        return;
+    }
+
+    if (control & (1 << TWSTA))
+    {
+        status = (status == TW_NO_INFO || status == TW_BUS_ERROR) ? TW_START : TW_REP_START;
+        status = twi_next_status(status);
+    }
+    else if (status == TW_START || status == TW_REP_START)
+    {
+        if (g_mock.twi_log_len < sizeof(g_mock.twi_log))
+            g_mock.twi_log[g_mock.twi_log_len++] = TWDR;
+        uint8_t address = TWDR >> 1;
+        uint8_t present = g_mock.twi_devices[address >> 3] & (1 << (address & 7));
+
+        g_mock.twi_read = TWDR & TW_READ;
+        if (g_mock.twi_read)
+            status = twi_next_status(present ? TW_MR_SLA_ACK : TW_MR_SLA_NACK);
+        else
+            status = twi_next_status(present ? TW_MT_SLA_ACK : TW_MT_SLA_NACK);
+    }
+    else if (g_mock.twi_read)
+    {
+        TWDR = g_mock.twi_rx_head < g_mock.twi_rx_len ? g_mock.twi_rx[g_mock.twi_rx_head++] : 0xFF;
+        status = twi_next_status((control & (1 << TWEA)) ? TW_MR_DATA_ACK : TW_MR_DATA_NACK);
+    }
+    else
+    {
+        if (g_mock.twi_log_len < sizeof(g_mock.twi_log))
+            g_mock.twi_log[g_mock.twi_log_len++] = TWDR;
+        status = twi_next_status(TW_MT_DATA_ACK);
+    }
+
+    TWSR = (TWSR & ~TW_STATUS_MASK) | status;
+    g_twcr = MOCK_OWNED | control | (1 << TWINT);
+}
+
+volatile uint16_t *mock_twcr(void)
+{
+    if (MOCK_PENDING(g_twcr))
+    {
+        uint8_t control = (uint8_t)g_twcr;
+
+        if (control & (1 << TWINT))
+            twi_step(control);
+        else
+            g_twcr = MOCK_OWNED | control;
+    }
+    return &g_twcr;
+}
+
+void mock_twi_device(uint8_t address)
+{
+    address &= 0x7F;
+    g_mock.twi_devices[address >> 3] |= (1 << (address & 7));
+}
+
+void mock_twi_status(uint8_t status)
+{
+    if (g_mock.twi_status_len < sizeof(g_mock.twi_status))
+        g_mock.twi_status[g_mock.twi_status_len++] = status;
+}
+
+void mock_twi_rx(const uint8_t *bytes, size_t len)
+{
+    while (len-- && g_mock.twi_rx_len < sizeof(g_mock.twi_rx))
+    {
+        g_mock.twi_rx[g_mock.twi_rx_len++] = *bytes++;
+    }
+}
+
+/* ---------------- EEPROM ---------------- */
+
+/*
+** EERE / EEPE set by the driver act at the next EECR / EEDR access (page 30):
+**  - EERE: EEDR = byte at EEAR, cleared
+**  - EEPE with EEMPE: byte at EEAR = EEDR, both cleared (no 3.4ms), EEPE alone is ignored
+*/
+static void eeprom_step(void)
+{
+    uint16_t addr = EEAR % MOCK_EEPROM;
+
+    if (g_eecr & (1 << EERE))
+    {
+        g_eedr = g_mock.eeprom[addr];
+        g_eecr &= ~(1 << EERE);
+    }
+    if (g_eecr & (1 << EEPE))
+    {
+        if (g_eecr & (1 << EEMPE))
+        {
+            g_mock.eeprom[addr] = g_eedr;
+            g_mock.eeprom_writes++;
+        }
+        g_eecr &= ~((1 << EEPE) | (1 << EEMPE));
+    }
+}
+
+volatile uint8_t *mock_eecr(void)
+{
+    eeprom_step();
+    return &g_eecr;
+}
+
+volatile uint8_t *mock_eedr(void)
+{
+    eeprom_step();
+    return &g_eedr;
+}
+
+/*
+** The ready interrupt fires as long as it is enabled (EEPE is always clear here)
+** The write it started is done before returning, at its own EEAR (a reset after it, a new
+** EEAR from the next code, do not move it)
+*/
+size_t mock_ee_ready(void (*vector)(void), size_t max)
+{
+    size_t runs = 0;
+
+    while (runs < max && (EECR & (1 << EERIE)))
+    {
+        vector();
+        eeprom_step();
+        runs++;
+    }
+    return runs;
+}
+
+/* ---------------- util/delay.h, avr/sleep.h ---------------- */
+
+void mock_delay_us(double us)
+{
+    g_mock.delay_us += us;
+}
+
+void mock_sleep(void)
+{
+    g_mock.sleeps++;
+}
+
+/* ---------------- avr-libc stdlib extensions ---------------- */
+
+char *ultoa(unsigned long value, char *s, int radix)
+{
+    char    tmp[sizeof(unsigned long) * 8 + 1];
+    size_t  len = 0;
+    size_t  i = 0;
+
+    do
+    {
+        unsigned long digit = value % radix;
+
+        tmp[len++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= radix;
+    } while (value);
+    while (len)
+    {
+        s[i++] = tmp[--len];
+    }
+    s[i] = '\0';
+    return s;
+}
+
+char *ltoa(long value, char *s, int radix)
+{
+    if (value < 0 && radix == 10)
+    {
+        s[0] = '-';
+        ultoa(-(unsigned long)value, s + 1, radix);
+        return s;
+    }
+    return ultoa((unsigned long)value, s, radix);
+}
+
+char *utoa(unsigned int value, char *s, int radix)
+{
+    return ultoa(value, s, radix);
+}
+
+char *itoa(int value, char *s, int radix)
+{
+    if (radix != 10)
+        return ultoa((unsigned int)value, s, radix);
+    return ltoa(value, s, radix);
+}
+
+char *dtostrf(double value, signed char width, unsigned char prec, char *s)
+{
+    sprintf(s, "%*.*f", width, prec, value);
+    return s;
+}
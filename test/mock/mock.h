@@ -0,0 +1,69 @@
+#ifndef MOCK_H
+# define MOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+** Test side of the register mock (avr/io.h)
+**  - mock_reset()        all registers to 0, queues empty, I bit cleared
+**  - UART                mock_rx_push() queues bytes for uart_rx() (polling, RXC0)
+**                        mock_rx_isr() puts one byte in UDR0 and runs USART_RX_vect
+**                        mock_tx_take() gives the bytes written to UDR0 since the last call
+**  - ADC                 mock_adc_set() value returned by a conversion on a channel (ADMUX & 0x0F)
+**  - TWI                 mock_twi_device() puts a slave on the bus (7 bit address), SLA+R/W of
+**                        any other address is not acknowledged
+**                        mock_twi_status() forces the status of the next step (NACK, arbitration lost...)
+**                        mock_twi_rx() queues the bytes returned by the read steps
+**                        g_mock.twi_log: bytes written to TWDR (address byte included), stops counted
+**  - EEPROM              g_mock.eeprom, erased (0xFF) by mock_reset(), a write is done at once
+**                        (EEPE never stays set), g_mock.eeprom_writes counts them
+**                        mock_ee_ready() runs EE_READY_vect while EERIE is set, max times at most
+*/
+
+#define MOCK_QUEUE      1024
+#define MOCK_EEPROM     1024
+
+typedef struct s_mock
+{
+    uint8_t     tx[MOCK_QUEUE];         /* UDR0 writes */
+    size_t      tx_len;
+    uint8_t     rx[MOCK_QUEUE];         /* Bytes for uart_rx() */
+    size_t      rx_head;
+    size_t      rx_len;
+    uint16_t    adc[16];                /* Conversion result of each ADMUX channel */
+    uint32_t    conversions;
+    uint8_t     twi_devices[16];        /* Slaves on the bus, one bit per 7 bit address */
+    uint8_t     twi_status[32];         /* Forced status of the next steps (0 = normal bus) */
+    size_t      twi_status_head;
+    size_t      twi_status_len;
+    uint8_t     twi_rx[64];             /* Bytes read from the slave */
+    size_t      twi_rx_head;
+    size_t      twi_rx_len;
+    uint8_t     twi_log[64];            /* Bytes written to the slave */
+    size_t      twi_log_len;
+    uint8_t     twi_read;               /* Last address byte had the R bit */
+    uint32_t    twi_stops;
+    uint8_t     eeprom[MOCK_EEPROM];
+    uint32_t    eeprom_writes;
+    uint32_t    sleeps;
+    double      delay_us;               /* _delay_us() / _delay_ms() total */
+}   t_mock;
+
+extern t_mock   g_mock;
+
+void    mock_reset(void);
+
+void    mock_rx_push(const char *bytes, size_t len);
+void    mock_rx_isr(void (*vector)(void), uint8_t byte);
+size_t  mock_tx_take(char *out, size_t size);
+
+void    mock_adc_set(uint8_t channel, uint16_t value);
+
+void    mock_twi_device(uint8_t address);
+void    mock_twi_status(uint8_t status);
+void    mock_twi_rx(const uint8_t *bytes, size_t len);
+
+size_t  mock_ee_ready(void (*vector)(void), size_t max);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef MOCK_STDLIB_H
+# define MOCK_STDLIB_H
+
+#include_next <stdlib.h>
+
+/*
+** avr-libc extensions used by the exercises (not in glibc), test/mock/mock.c
+*/
+char    *itoa(int value, char *s, int radix);
+char    *utoa(unsigned int value, char *s, int radix);
+char    *ltoa(long value, char *s, int radix);
+char    *ultoa(unsigned long value, char *s, int radix);
+char    *dtostrf(double value, signed char width, unsigned char prec, char *s);
+
+#endif
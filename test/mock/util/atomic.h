@@ -0,0 +1,36 @@
+#ifndef MOCK_UTIL_ATOMIC_H
+# define MOCK_UTIL_ATOMIC_H
+
+#include <avr/interrupt.h>
+
+/*
+** Same construction as avr-libc: SREG saved, I cleared, put back when the block is left
+** (also by return / break, through the cleanup attribute)
+*/
+static inline uint8_t mock_atomic_enter(void)
+{
+    uint8_t sreg = SREG;
+
+    cli();
+    return sreg;
+}
+
+static inline void mock_atomic_restore(const uint8_t *sreg)
+{
+    SREG = *sreg;
+}
+
+static inline void mock_atomic_force_on(const uint8_t *sreg)
+{
+    (void)sreg;
+    sei();
+}
+
+#define ATOMIC_RESTORESTATE uint8_t mock_sreg __attribute__((cleanup(mock_atomic_restore))) = SREG
+#define ATOMIC_FORCEON      uint8_t mock_sreg __attribute__((cleanup(mock_atomic_force_on))) = 0
+#define NONATOMIC_RESTORESTATE  ATOMIC_RESTORESTATE
+
+#define ATOMIC_BLOCK(type) \
+    for (type, mock_once = (cli(), 1); mock_once; mock_once = 0)
+
+#endif
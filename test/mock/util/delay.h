@@ -0,0 +1,14 @@
+#ifndef MOCK_UTIL_DELAY_H
+# define MOCK_UTIL_DELAY_H
+
+#include <stdint.h>
+
+/*
+** Host build: no wait, the time is added to g_mock.delay_us (tests can check it)
+*/
+void    mock_delay_us(double us);
+
+#define _delay_us(us)   mock_delay_us(us)
+#define _delay_ms(ms)   mock_delay_us((ms) * 1000.0)
+
+#endif
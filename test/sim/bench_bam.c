@@ -0,0 +1,24 @@
+#include "sim.h"
+#include "../../lib/bam.c"
+
+/*
+** lib/bam.c: bit angle modulation engine (module00/ex04, bam.c included: its state is static)
+** TIMER2_COMPA_vect_slot is the ISR cost of lib/bam.h
+*/
+
+int main(void)
+{
+    sim_init();
+
+    bam_init(&PORTB, (1 << PB0) | (1 << PB1) | (1 << PB2) | (1 << PB4));
+    TIMSK2 = 0;                             /* The engine is driven by the bench, not by Timer2 */
+    TCCR2B = 0;
+    bam_set(PB0, 255);
+    bam_set(PB4, 100);
+
+    SIM_CYCLES("bam_commit", bam_commit());
+    SIM_ISR("TIMER2_COMPA_vect_frame", TIMER2_COMPA_vect);     /* Slot 0: buffer swap */
+    SIM_ISR("TIMER2_COMPA_vect_slot", TIMER2_COMPA_vect);      /* Slot 1 */
+
+    sim_exit();
+}
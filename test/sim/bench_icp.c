@@ -0,0 +1,24 @@
+#include "sim.h"
+#include "../../lib/icp.c"
+
+/*
+** lib/icp.c (included: its state is static): capture interrupt and overflow
+** The bench counter is Timer1 too: icp_start() is not called, only the state is set
+*/
+
+int main(void)
+{
+    sim_init();
+
+    SIM_ISR("TIMER1_OVF_vect", TIMER1_OVF_vect);
+    SIM_ISR("TIMER1_CAPT_vect_idle", TIMER1_CAPT_vect);
+
+    g_icp_state = ICP_COUNT;                /* Frequency gate running: one edge counted */
+    g_icp_left = 100;
+    SIM_ISR("TIMER1_CAPT_vect_count", TIMER1_CAPT_vect);
+
+    g_icp_left = 1;                         /* Last edge of the gate: timestamp and publish */
+    SIM_ISR("TIMER1_CAPT_vect_publish", TIMER1_CAPT_vect);
+
+    sim_exit();
+}
@@ -0,0 +1,47 @@
+#include "sim.h"
+#include "pwm.h"
+#include "systime.h"
+#include "input.h"
+#include "kvstore.h"
+#include "wakeup.h"
+#include "gpio.h"
+
+/*
+** Shared drivers (lib/): wheel() and the ISRs of the library
+** lib/icp.c has its own program (bench_icp.c): its TIMER1_OVF_vect is the systime one here
+*/
+
+/* Vectors of the library objects (__vector_N symbols) */
+void SYSTIME_OVF_vect(void);
+void WDT_vect(void);
+void EE_READY_vect(void);
+void PCINT2_vect(void);
+
+static volatile uint8_t g_pos[3] = { 10, 100, 200 };
+
+int main(void)
+{
+    sim_init();
+
+    /* One position in each third of the wheel (3 code paths) */
+    SIM_CYCLES("wheel_red_blue", wheel(g_pos[0]));
+    SIM_CYCLES("wheel_blue_green", wheel(g_pos[1]));
+    SIM_CYCLES("wheel_green_red", wheel(g_pos[2]));
+
+    SIM_ISR("SYSTIME_OVF_vect", SYSTIME_OVF_vect);
+    SIM_ISR("WDT_vect", WDT_vect);
+    SIM_ISR("EE_READY_vect_idle", EE_READY_vect);  /* Write queues empty (lib/eeprom.c) */
+
+    /*
+    ** Pin change: SW1 driven low by the port itself (output), PINx reads it back
+    ** PCICR off: the flag raised by the edge must not run the ISR after reti
+    */
+    input_watch(PIN_PORT(SW1), PIN_MASK(SW1));
+    PCICR = 0;
+    SIM_ISR("PCINT2_vect_nochange", PCINT2_vect);
+    PIN_OUTPUT(SW1);
+    PIN_CLR(SW1);
+    SIM_ISR("PCINT2_vect_event", PCINT2_vect);
+
+    sim_exit();
+}
@@ -0,0 +1,19 @@
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module02/ex00/src/main.c"
+#undef main
+
+/*
+** module02/ex00: heart beat interrupt (one uart_tx())
+*/
+
+int main(void)
+{
+    sim_init();
+    uart_init(UART_UBRR(UART_BAUDRATE));
+
+    SIM_ISR("TIMER1_COMPA_vect", TIMER1_COMPA_vect);
+
+    sim_exit();
+}
@@ -0,0 +1,20 @@
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module02/ex01/src/main.c"
+#undef main
+
+/*
+** module02/ex01: "Hello World!\r\n" from the interrupt
+** uart_puts() waits for the transmitter: the count is mostly the 14 bytes on the line (115200)
+*/
+
+int main(void)
+{
+    sim_init();
+    uart_init(UART_UBRR(UART_BAUDRATE));
+
+    SIM_ISR("TIMER1_COMPA_vect", TIMER1_COMPA_vect);
+
+    sim_exit();
+}
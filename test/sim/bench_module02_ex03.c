@@ -0,0 +1,27 @@
+#define SIM_UDR0
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module02/ex03/src/main.c"
+#undef main
+
+/*
+** module02/ex03: case swap echo interrupt
+*/
+
+int main(void)
+{
+    sim_init();
+    uart_init(UART_UBRR(UART_BAUDRATE));
+
+    g_sim_udr0 = 'a';
+    SIM_ISR("USART_RX_vect_lower", USART_RX_vect);
+    sim_tx_idle();
+    g_sim_udr0 = 'Q';
+    SIM_ISR("USART_RX_vect_upper", USART_RX_vect);
+    sim_tx_idle();
+    g_sim_udr0 = '7';
+    SIM_ISR("USART_RX_vect_other", USART_RX_vect);
+
+    sim_exit();
+}
@@ -0,0 +1,47 @@
+#define SIM_UDR0
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module02/ex04/src/main.c"
+#undef main
+
+/*
+** module02/ex04: login compare and the RX interrupt (login and shell line)
+*/
+
+static const char g_user[] = "spectre";
+static const char *volatile g_input = "spectrf";
+
+static void rx(char c)
+{
+    sim_tx_idle();
+    g_sim_udr0 = c;
+}
+
+int main(void)
+{
+    sim_init();
+    uart_init(UART_UBRR(UART_BAUDRATE));
+
+    SIM_CYCLES("ft_strncmp_match", SIM_KEEP(ft_strncmp(g_user, g_user, 32)));
+    SIM_CYCLES("ft_strncmp_last_char", SIM_KEEP(ft_strncmp(g_input, g_user, 32)));
+
+    rx('s');
+    SIM_ISR("USART_RX_vect_username", USART_RX_vect);
+    rx('x');
+    g_current_state = STATE_WAIT_PASSWORD;
+    SIM_ISR("USART_RX_vect_password", USART_RX_vect);
+    rx(127);
+    SIM_ISR("USART_RX_vect_backspace", USART_RX_vect);
+    rx('\r');
+    SIM_ISR("USART_RX_vect_enter", USART_RX_vect);
+    rx('a');
+    SIM_ISR("USART_RX_vect_dropped", USART_RX_vect);   /* Line not taken yet */
+
+    g_input_ready = 0;
+    g_current_state = STATE_LOGGED_IN;
+    rx('a');
+    SIM_ISR("USART_RX_vect_shell", USART_RX_vect);
+
+    sim_exit();
+}
@@ -0,0 +1,67 @@
+#define SIM_UDR0
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module03/ex03/src/main.c"
+#undef main
+
+/*
+** module03/ex03: character classes, the RX parser (text and binary), the PWM latch,
+** the frame clock and the transmit ring
+** At 1Mbaud a byte comes every 160 cycles: USART_RX_vect must stay far below
+*/
+
+static volatile char g_char[2] = { 'b', '#' };
+
+/* Byte given to the parser without measure */
+static void feed(uint8_t byte)
+{
+    g_sim_udr0 = byte;
+    USART_RX_vect();
+    cli();
+}
+
+int main(void)
+{
+    sim_init();
+    init_rgb();
+    TIMSK0 = 0;                             /* Latch run by the bench, not by the overflow */
+
+    SIM_CYCLES("hex_char_to_int", SIM_KEEP(hex_char_to_int(g_char[0])));
+    SIM_CYCLES("check_color_format", SIM_KEEP(check_color_format(g_char[1], 0)));
+
+    g_sim_udr0 = '#';
+    SIM_ISR("USART_RX_vect_hash", USART_RX_vect);
+    g_sim_udr0 = 'a';
+    SIM_ISR("USART_RX_vect_digit", USART_RX_vect);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        feed('a');
+    }
+    g_sim_udr0 = 'a';
+    SIM_ISR("USART_RX_vect_last_digit", USART_RX_vect);     /* Color complete: latch */
+    TIMSK0 = 0;
+    g_sim_udr0 = '\r';
+    SIM_ISR("USART_RX_vect_end", USART_RX_vect);
+    g_sim_udr0 = '?';
+    SIM_ISR("USART_RX_vect_query", USART_RX_vect);
+    UCSR0B = 0;                             /* Ring drained by the bench */
+    SIM_ISR("USART_UDRE_vect", USART_UDRE_vect);
+    SIM_ISR("TIMER0_OVF_vect", TIMER0_OVF_vect);
+
+    g_sim_udr0 = 0x02;
+    SIM_ISR("USART_RX_vect_stx", USART_RX_vect);
+    UCSR0B = 0;
+    g_sim_udr0 = 0x40;
+    SIM_ISR("USART_RX_vect_binary", USART_RX_vect);
+    feed(0x40);
+    feed(0x40);
+    g_sim_udr0 = 10;
+    SIM_ISR("USART_RX_vect_binary_frame", USART_RX_vect);   /* 4th byte: frame queued */
+
+    SIM_ISR("TIMER1_COMPA_vect_frame", TIMER1_COMPA_vect);  /* Frame start */
+    TIMSK0 = 0;
+    SIM_ISR("TIMER1_COMPA_vect_tick", TIMER1_COMPA_vect);   /* Frame running: idle tick */
+
+    sim_exit();
+}
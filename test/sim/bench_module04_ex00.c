@@ -0,0 +1,18 @@
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module04/ex00/src/main.c"
+#undef main
+
+/*
+** module04/ex00: INT0 (SW1) flag interrupt
+*/
+
+int main(void)
+{
+    sim_init();
+
+    SIM_ISR("INT0_vect", INT0_vect);
+
+    sim_exit();
+}
@@ -0,0 +1,21 @@
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module04/ex01/src/main.c"
+#undef main
+
+/*
+** module04/ex01: waveform sample interrupt (one table step into OCR1A)
+** OCR1A is written with Timer1 in normal mode: no output, the bench counter is not disturbed
+*/
+
+int main(void)
+{
+    sim_init();
+    wave_init(&g_breath, g_wave_breath, NULL, &OCR1A);
+    wave_set_period(&g_breath, BREATH_PERIOD_MS);
+
+    SIM_ISR("TIMER0_COMPA_vect", TIMER0_COMPA_vect);
+
+    sim_exit();
+}
@@ -0,0 +1,32 @@
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module04/ex02/src/main.c"
+#undef main
+
+/*
+** module04/ex02: switch sampling interrupt (debounce + 2 gestures + LEDs), 100 times a second
+*/
+
+int main(void)
+{
+    sim_init();
+    gpio_leds_init();
+    gpio_switches_init();
+    debounce_init(&g_switch, gpio_switches());
+    gesture_init(&g_button[0]);
+    gesture_init(&g_button[1]);
+
+    SIM_ISR("TIMER0_COMPA_vect_idle", TIMER0_COMPA_vect);  /* No switch pressed */
+
+    PIN_OUTPUT(SW1);                        /* SW1 pressed: pin driven low, read back by PINx */
+    PIN_CLR(SW1);
+    for (uint8_t i = 0; i < 8; i++)         /* Past the debounce: press reported */
+    {
+        TIMER0_COMPA_vect();
+        cli();
+    }
+    SIM_ISR("TIMER0_COMPA_vect_held", TIMER0_COMPA_vect);
+
+    sim_exit();
+}
@@ -0,0 +1,21 @@
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module05/ex01/src/main.c"
+#undef main
+
+/*
+** module05/ex01: format_hex()
+*/
+
+static volatile uint8_t g_value = 0xA7;
+static uint8_t g_buffer[3];
+
+int main(void)
+{
+    sim_init();
+
+    SIM_CYCLES("format_hex", format_hex(g_value, g_buffer));
+
+    sim_exit();
+}
@@ -0,0 +1,23 @@
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module05/ex02/src/main.c"
+#undef main
+
+/*
+** module05/ex02: format_dec() (one division by 10 per digit: the count grows with the digits)
+*/
+
+static volatile uint16_t g_value[3] = { 7, 1023, 65535 };
+static char g_buffer[6];
+
+int main(void)
+{
+    sim_init();
+
+    SIM_CYCLES("format_dec_1_digit", format_dec(g_value[0], g_buffer));
+    SIM_CYCLES("format_dec_4_digits", format_dec(g_value[1], g_buffer));
+    SIM_CYCLES("format_dec_5_digits", format_dec(g_value[2], g_buffer));
+
+    sim_exit();
+}
@@ -0,0 +1,20 @@
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module05/ex03/src/main.c"
+#undef main
+
+/*
+** module05/ex03: convert_to_celsius() (32 bit multiply and division)
+*/
+
+static volatile uint16_t g_adc = 352;
+
+int main(void)
+{
+    sim_init();
+
+    SIM_CYCLES("convert_to_celsius", SIM_KEEP(convert_to_celsius(g_adc)));
+
+    sim_exit();
+}
@@ -0,0 +1,35 @@
+#include "sim.h"
+
+#define main exercise_main
+#include "../../module06/ex02/src/main.c"
+#undef main
+
+/*
+** module06/ex02: float path of i2c_read_aht20() (the I2C part waits for the bus, not measured)
+**  - aht20_convert(): 2 float multiply / divide / subtract
+**  - compute_average(): 4 float adds, 2 divides
+**  - dtostrf(): float -> text, twice per line
+*/
+
+static volatile uint8_t g_frame[7] = { 0x1C, 0x80, 0x00, 0x06, 0x66, 0x66, 0x00 };
+static char g_buffer[10];
+
+int main(void)
+{
+    uint8_t frame[7];
+    float temperature;
+    float humidity;
+
+    sim_init();
+    for (uint8_t i = 0; i < 7; i++)
+    {
+        frame[i] = g_frame[i];
+    }
+
+    SIM_CYCLES("aht20_convert", aht20_convert(frame, &temperature, &humidity));
+    SIM_CYCLES("measurement_process", measurement_process(temperature, humidity));
+    SIM_CYCLES("compute_average", compute_average(&temperature, &humidity));
+    SIM_CYCLES("dtostrf", dtostrf(temperature, 5, 1, g_buffer));
+
+    sim_exit();
+}
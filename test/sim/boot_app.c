@@ -0,0 +1,51 @@
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+
+/*
+** Application uploaded by boot_sim through bootloader/ (not a bench, no sim.c)
+**  - a table over several flash pages, checked byte after byte: a page lost, written
+**    twice or out of place shows up
+**  - "APP OK" / "APP BAD" on the console register (GPIOR0), read by boot_sim
+**  - then sleeps with interrupts off: simavr stops
+*/
+#define APP_BYTE(i)     (uint8_t)((i) * 7 + 3),
+#define APP_10(i)       APP_BYTE(i) APP_BYTE(i + 1) APP_BYTE(i + 2) APP_BYTE(i + 3) APP_BYTE(i + 4) \
+                        APP_BYTE(i + 5) APP_BYTE(i + 6) APP_BYTE(i + 7) APP_BYTE(i + 8) APP_BYTE(i + 9)
+#define APP_100(i)      APP_10(i) APP_10(i + 10) APP_10(i + 20) APP_10(i + 30) APP_10(i + 40) \
+                        APP_10(i + 50) APP_10(i + 60) APP_10(i + 70) APP_10(i + 80) APP_10(i + 90)
+
+static const uint8_t g_table[] PROGMEM =
+{
+    APP_100(0) APP_100(100) APP_100(200) APP_100(300) APP_100(400) APP_100(500) APP_100(600)
+};
+
+static void app_puts_P(const char *str)
+{
+    char c;
+
+    while ((c = pgm_read_byte(str++)))
+    {
+        GPIOR0 = c;
+    }
+}
+
+int main(void)
+{
+    uint8_t ok = 1;
+
+    for (uint16_t i = 0; i < sizeof(g_table); i++)
+    {
+        if (pgm_read_byte(&g_table[i]) != (uint8_t)(i * 7 + 3))
+            ok = 0;
+    }
+    app_puts_P(ok ? PSTR("APP OK\n") : PSTR("APP BAD\n"));
+
+    cli();
+    sleep_enable();
+    while (1)
+    {
+        sleep_cpu();
+    }
+}
@@ -0,0 +1,330 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "avr_uart.h"
+#include "avr_ioport.h"
+#include "../../bootloader/src/boot.h"
+
+/*
+** Bootloader end to end, host program on libsimavr (test/sim/Makefile, make boot)
+**
+**  boot_sim boot.elf app.bin command...
+**
+** The bootloader runs in a simulated ATmega328P at its boot section, USART0 is tied to a
+** pty: "command... <pty> app.bin" (tools/boot_flash.py --no-reset) is the host
+**  - upload:   erased chip, power-on reset: the boot waits, the tool writes app.bin,
+**              the flash must hold it and the application say "APP OK" (boot_app.c)
+**  - again:    external reset, same image: nothing to write, the application runs
+**  - start:    power-on reset: cycles to the application ("BENCH boot_start")
+**  - wait:     external reset, no host: BOOT_WAIT_MS then the application ("BENCH boot_wait_ms")
+**  - sw1:      power-on reset with SW1 held: the boot waits like after an external reset
+**
+** With a host the simulation is held to real time (the tool has real time outs)
+** simavr queues the received bytes (64 byte FIFO, XON / XOFF), it has no overrun: the
+** 1Mbaud budget of the boot (160 cycles a byte) is kept by its ring, not checked here
+*/
+
+#define SIM_MCUSR       0x54    /* Data address (I/O 0x34, page 428) */
+#define SIM_PORF        0x01
+#define SIM_EXTRF       0x02
+#define SIM_SW1_PORT    'D'     /* SW1 of lib/board.h: PD2, active low */
+#define SIM_SW1_BIT     2
+#define SIM_IO_CYCLES   1024    /* pty / pace / tool checks, 64us */
+
+typedef struct s_run
+{
+    uint64_t    app_cycles;     /* Reset -> first instruction of the application, 0: never */
+    int         app_ok;         /* "APP OK" on the console */
+    int         halted;         /* cpu_Done: the application sleeps with interrupts off */
+    int         tool_status;    /* Exit status of the tool, 0 without a tool */
+}   t_run;
+
+static avr_t        *g_avr;
+static avr_irq_t    *g_uart_in;
+static avr_irq_t    *g_sw1;
+static int          g_pty = -1;
+static int          g_xon = 1;
+static uint8_t      g_in[4096];             /* From the tool, not yet given to the UART */
+static int          g_in_len;
+static int          g_in_pos;
+static char         g_line[80];             /* Console line of the application */
+static int          g_line_len;
+static t_run        *g_run;
+static uint64_t     g_pace_cycle;
+static struct timespec g_pace_real;
+
+static void uart_output(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    uint8_t byte = value;
+
+    (void)irq;
+    (void)param;
+    if (write(g_pty, &byte, 1) != 1)
+        fprintf(stderr, "boot_sim: pty write failed\n");
+}
+
+static void uart_xon(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    (void)irq;
+    (void)value;
+    g_xon = param != NULL;
+}
+
+static void console_write(struct avr_t *avr, avr_io_addr_t addr, uint8_t value, void *param)
+{
+    (void)avr;
+    (void)addr;
+    (void)param;
+    if (value != '\n' && g_line_len < (int)sizeof(g_line) - 1)
+    {
+        g_line[g_line_len++] = value;
+        return;
+    }
+    g_line[g_line_len] = 0;
+    g_line_len = 0;
+    printf("boot_sim: app: %s\n", g_line);
+    if (g_run && strcmp(g_line, "APP OK") == 0)
+        g_run->app_ok = 1;
+}
+
+/* The pin level is only taken on a change: the other level first */
+static void sim_sw1(int held)
+{
+    avr_raise_irq(g_sw1, held);
+    avr_raise_irq(g_sw1, !held);
+}
+
+static void sim_reset(uint8_t mcusr, int sw1_held)
+{
+    avr_reset(g_avr);
+    g_avr->pc = BOOT_START;                 /* BOOTRST */
+    g_avr->state = cpu_Running;
+    g_avr->data[SIM_MCUSR] = mcusr;
+    sim_sw1(sw1_held);
+    g_in_len = 0;
+    g_in_pos = 0;
+    g_line_len = 0;
+}
+
+static void sim_pump(void)
+{
+    if (g_in_pos == g_in_len)
+    {
+        int n = read(g_pty, g_in, sizeof(g_in));
+
+        g_in_pos = 0;
+        g_in_len = n > 0 ? n : 0;
+    }
+    while (g_xon && g_in_pos < g_in_len)
+        avr_raise_irq(g_uart_in, g_in[g_in_pos++]);
+}
+
+/* Simulated time no ahead of the real one */
+static void sim_pace(void)
+{
+    struct timespec now;
+    int64_t real_us;
+    int64_t sim_us;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    real_us = (now.tv_sec - g_pace_real.tv_sec) * 1000000LL + (now.tv_nsec - g_pace_real.tv_nsec) / 1000;
+    sim_us = (int64_t)(g_avr->cycle - g_pace_cycle) * 1000000LL / g_avr->frequency;
+    if (sim_us > real_us + 1000)
+        usleep(sim_us - real_us);
+}
+
+static pid_t tool_start(char **command, int argc, const char *image)
+{
+    char **argv = calloc(argc + 3, sizeof(char *));
+    pid_t pid;
+
+    memcpy(argv, command, argc * sizeof(char *));
+    argv[argc] = ptsname(g_pty);
+    argv[argc + 1] = (char *)image;
+    pid = fork();
+    if (pid == 0)
+    {
+        execvp(argv[0], argv);
+        perror("boot_sim: exec");
+        _exit(127);
+    }
+    free(argv);
+    return pid;
+}
+
+/*
+** From a reset to the end of the application (or max_ms of simulated time),
+** the tool (pid, 0: none) fed through the pty meanwhile
+*/
+static void sim_run(t_run *run, pid_t tool, uint32_t max_ms)
+{
+    uint64_t start = g_avr->cycle;
+    uint64_t limit = start + (uint64_t)g_avr->frequency / 1000 * max_ms;
+    uint64_t next_io = start;
+    int tool_done = tool == 0;
+    int status;
+
+    memset(run, 0, sizeof(*run));
+    g_run = run;
+    g_pace_cycle = start;
+    clock_gettime(CLOCK_MONOTONIC, &g_pace_real);
+    while (g_avr->cycle < limit)
+    {
+        int state = avr_run(g_avr);
+
+        if (!run->app_cycles && g_avr->pc == 0)
+            run->app_cycles = g_avr->cycle - start;
+        if (state == cpu_Done || state == cpu_Crashed)
+        {
+            run->halted = state == cpu_Done;
+            break;
+        }
+        if (g_avr->cycle < next_io)
+            continue;
+        next_io = g_avr->cycle + SIM_IO_CYCLES;
+        if (tool_done)
+            continue;
+        sim_pump();
+        sim_pace();
+        if (waitpid(tool, &status, WNOHANG) == tool)
+        {
+            tool_done = 1;
+            run->tool_status = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+            if (run->tool_status)
+                break;
+        }
+    }
+    if (!tool_done)
+    {
+        if (!run->halted)
+            kill(tool, SIGTERM);
+        waitpid(tool, &status, 0);
+        run->tool_status = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    }
+    g_run = NULL;
+}
+
+static int check(int ok, const char *phase, const char *what)
+{
+    printf("boot_sim: %s: %s%s\n", phase, ok ? "" : "FAIL ", what);
+    return ok ? 0 : 1;
+}
+
+static int check_upload(const char *phase, const t_run *run, const uint8_t *image, size_t size)
+{
+    int fail = 0;
+
+    fail |= check(run->tool_status == 0, phase, "tool done");
+    fail |= check(memcmp(g_avr->flash, image, size) == 0, phase, "flash holds the image");
+    fail |= check(run->app_cycles != 0, phase, "application started");
+    fail |= check(run->halted && run->app_ok, phase, "application ran (APP OK)");
+    return fail;
+}
+
+static int pty_open(void)
+{
+    struct termios tio;
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (fd < 0 || grantpt(fd) || unlockpt(fd))
+        return -1;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+int main(int argc, char *argv[])
+{
+    elf_firmware_t boot;
+    uint8_t image[BOOT_START];
+    size_t size;
+    uint32_t flags = 0;
+    t_run run;
+    int fail = 0;
+    FILE *f;
+
+    if (argc < 4)
+    {
+        fprintf(stderr, "usage: boot_sim boot.elf app.bin command...\n");
+        return 2;
+    }
+    memset(&boot, 0, sizeof(boot));
+    if (elf_read_firmware(argv[1], &boot) || boot.flashbase != BOOT_START)
+    {
+        fprintf(stderr, "boot_sim: %s: no bootloader at 0x%x\n", argv[1], BOOT_START);
+        return 1;
+    }
+    f = fopen(argv[2], "rb");
+    if (!f)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+    size = fread(image, 1, sizeof(image), f);
+    fclose(f);
+
+    g_avr = avr_make_mcu_by_name("atmega328p");
+    if (!g_avr || avr_init(g_avr))
+        return 1;
+    avr_load_firmware(g_avr, &boot);
+    g_avr->frequency = 16000000;
+    g_avr->codeend = g_avr->flashend;
+    memset(g_avr->flash, 0xFF, BOOT_START);             /* Erased application space */
+
+    g_pty = pty_open();
+    if (g_pty < 0)
+    {
+        perror("boot_sim: pty");
+        return 1;
+    }
+    avr_ioctl(g_avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+    flags &= ~(AVR_UART_FLAG_STDIO | AVR_UART_FLAG_POLL_SLEEP);
+    avr_ioctl(g_avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+    g_uart_in = avr_io_getirq(g_avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+    avr_irq_register_notify(avr_io_getirq(g_avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+                            uart_output, NULL);
+    avr_irq_register_notify(avr_io_getirq(g_avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUT_XON),
+                            uart_xon, (void *)1);
+    avr_irq_register_notify(avr_io_getirq(g_avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUT_XOFF),
+                            uart_xon, NULL);
+    g_sw1 = avr_io_getirq(g_avr, AVR_IOCTL_IOPORT_GETIRQ(SIM_SW1_PORT), SIM_SW1_BIT);
+    avr_register_io_write(g_avr, 0x3E, console_write, NULL);   /* GPIOR0 */
+
+    sim_reset(SIM_PORF, 0);
+    sim_run(&run, tool_start(argv + 3, argc - 3, argv[2]), 10000);
+    fail |= check_upload("upload", &run, image, size);
+
+    sim_reset(SIM_EXTRF, 0);
+    sim_run(&run, tool_start(argv + 3, argc - 3, argv[2]), 10000);
+    fail |= check_upload("again", &run, image, size);
+
+    sim_reset(SIM_PORF, 0);
+    sim_run(&run, 0, 100);
+    fail |= check(run.app_cycles != 0 && run.app_ok, "start", "application at once");
+    printf("BENCH boot_start %llu\n", (unsigned long long)run.app_cycles);
+
+    sim_reset(SIM_EXTRF, 0);
+    sim_run(&run, 0, 2 * BOOT_WAIT_MS);
+    fail |= check(run.app_cycles >= g_avr->frequency / 1000 * BOOT_WAIT_MS && run.app_ok,
+                  "wait", "application after BOOT_WAIT_MS");
+    printf("BENCH boot_wait_ms %llu\n", (unsigned long long)(run.app_cycles / (g_avr->frequency / 1000)));
+
+    sim_reset(SIM_PORF, 1);
+    sim_run(&run, 0, 2 * BOOT_WAIT_MS);
+    fail |= check(run.app_cycles >= g_avr->frequency / 1000 * BOOT_WAIT_MS && run.app_ok,
+                  "sw1", "held at power-on: the boot waits");
+
+    printf("BENCH boot_flash %u\n", boot.flashsize);
+    return fail;
+}
@@ -0,0 +1,92 @@
+#include <avr/sleep.h>
+#include <util/delay.h>
+#include "avr_mcu_section.h"
+#include "periph.h"
+#include "mem.h"
+#include "sim.h"
+
+/*
+** .mmcu section read by simavr (simavr/sim/avr/avr_mcu_section.h): the chip, the clock,
+** and GPIOR0 as console (each byte written goes to the simavr output, line by line)
+*/
+AVR_MCU(F_CPU, "atmega328p");
+AVR_MCU_SIMAVR_CONSOLE(&GPIOR0);
+
+uint16_t g_sim_overhead = 0;
+volatile uint8_t g_sim_udr0;            /* UDR0 of the exercise code with SIM_UDR0 */
+
+void sim_init(void)
+{
+    uint16_t empty;
+
+    periph_claim(PERIPH_TIM1);
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);                   /* Normal mode, clk/1 (page 173 16-5) */
+
+    SIM_MEASURE((void)0, empty);            /* Cost of the measure itself */
+    g_sim_overhead = empty;
+}
+
+/*
+** RAM of the run (lib/mem.c paints the stack before main): deepest stack and the gap
+** left above .bss, checked against STACK_MARGIN by tools/bench_compare.py
+*/
+void sim_exit(void)
+{
+    t_mem_stats mem;
+
+    mem_stats(&mem);
+    sim_report(PSTR("stack"), mem.stack_peak);
+    sim_report(PSTR("stack_gap"), mem.gap);
+    cli();
+    sleep_enable();
+    while (1)
+    {
+        sleep_cpu();                        /* simavr: "sleeping with interrupts off", quits */
+    }
+}
+
+void sim_puts_P(const char *str)
+{
+    char c;
+
+    while ((c = pgm_read_byte(str++)))
+    {
+        GPIOR0 = c;
+    }
+}
+
+void sim_put_u32(uint32_t value)
+{
+    char digits[10];
+    uint8_t len = 0;
+
+    do
+    {
+        digits[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (len)
+    {
+        GPIOR0 = digits[--len];
+    }
+}
+
+/* "BENCH <name> <cycles>", parsed by tools/bench_compare.py */
+void sim_report(const char *name, uint16_t cycles)
+{
+    sim_puts_P(PSTR("BENCH "));
+    sim_puts_P(name);
+    GPIOR0 = ' ';
+    sim_put_u32(cycles);
+    GPIOR0 = '\n';
+}
+
+/*
+** Wait until the transmitter is empty before measuring code which sends:
+** 2 bytes at 115200 (double buffer), not part of the count
+*/
+void sim_tx_idle(void)
+{
+    _delay_us(200);
+}
@@ -0,0 +1,86 @@
+#ifndef SIM_H
+# define SIM_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+/*
+** AVR programs run in simavr (test/sim/Makefile), not on the board
+**  - output: simavr console register (GPIOR0), one line per result, printed by simavr
+**  - end: sim_exit() prints the stack peak and the gap left under it ("BENCH stack",
+**    "BENCH stack_gap", lib/mem.h), then sleeps with interrupts off, simavr stops there
+**
+** Cycle counter: Timer1 normal mode at clk/1, 1 tick = 1 cycle (page 140)
+**  - SIM_CYCLES(name, stmt) runs stmt once with interrupts off and prints
+**    "BENCH <name> <cycles>", the cost of the two TCNT1 reads taken off
+**  - simulation is exact: one run gives the number, no average needed
+**  - up to 65535 cycles (16 bit counter, 4ms)
+**  - the inputs of stmt must come from volatile variables, else the compiler
+**    folds the call at build time and the count is 0
+**  - its results: SIM_KEEP() for a value, a static buffer for stores (a local one may be
+**    optimized away, the memory barrier only keeps what is visible outside)
+**
+** ISRs are called as functions (the vector is a plain symbol): "call" (4 cycles) instead of the
+** hardware entry (4 cycles + jmp 3), reti is counted
+** SIM_ISR() takes the call off: the number is the vector, prologue to reti included
+** reti sets the I bit: an interrupt the ISR has enabled runs after the first instruction
+** behind it, the TCNT1L read (TCNT1H is latched, the count is right), then the bench
+** turns the source off again (TIMSKx = 0...)
+*/
+
+#define SIM_CALL_CYCLES     4
+
+/*
+** SIM_UDR0 (defined before sim.h, the exercise main.c included after it):
+** UDR0 of the exercise code is a RAM byte set by the bench (g_sim_udr0), so an RX
+** interrupt can be run with any received byte
+** Same cost: UDR0 (0xC6) and RAM are both read with lds (2 cycles)
+*/
+#ifdef SIM_UDR0
+extern volatile uint8_t g_sim_udr0;
+# undef UDR0
+# define UDR0 g_sim_udr0
+#endif
+
+extern uint16_t g_sim_overhead;
+
+void    sim_init(void);
+void    sim_exit(void) __attribute__((noreturn));
+void    sim_puts_P(const char *str);
+void    sim_put_u32(uint32_t value);
+void    sim_report(const char *name, uint16_t cycles);
+void    sim_tx_idle(void);
+
+/* Keep a value alive (result of the measured code, never computed at build time) */
+#define SIM_KEEP(value)     __asm__ volatile("" : : "r"(value) : "memory")
+
+#define SIM_MEASURE(stmt, cycles) \
+    do { \
+        uint16_t t0_; \
+        cli(); \
+        __asm__ volatile("" : : : "memory"); \
+        t0_ = TCNT1; \
+        __asm__ volatile("" : : : "memory"); \
+        stmt; \
+        __asm__ volatile("" : : : "memory"); \
+        (cycles) = TCNT1 - t0_ - g_sim_overhead; \
+    } while (0)
+
+#define SIM_CYCLES(name, stmt) \
+    do { \
+        uint16_t n_; \
+        SIM_MEASURE(stmt, n_); \
+        sim_report(PSTR(name), n_); \
+    } while (0)
+
+/* reti has set the I bit again: SIM_MEASURE() clears it */
+#define SIM_ISR(name, vector) \
+    do { \
+        uint16_t n_; \
+        SIM_MEASURE(vector(), n_); \
+        cli(); \
+        sim_report(PSTR(name), n_ - SIM_CALL_CYCLES); \
+    } while (0)
+
+#endif
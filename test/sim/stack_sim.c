@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "avr_uart.h"
+
+/*
+** Stack of an exercise as flashed, host program on libsimavr (test/sim/Makefile, make stack)
+**
+**  stack_sim main.elf heap_start ms [input]
+**
+** The benches call functions one by one: the real main loop, its ISRs nested in it and the
+** exercises without a bench are never seen there. This runs the main.elf of the exercise
+** Makefile (its own flags, nothing linked in) from the reset for ms of simulated time
+**  - before the first instruction the SRAM from __heap_start (avr-nm) to RAMEND is painted
+**    with MEM_CANARY, like lib/mem.c does in a program which links it
+**  - input: bytes given to USART0 from the middle of the run, one per ms (login, colors...)
+**  - at the end: "BENCH run_stack <peak>" and "BENCH run_stack_gap <gap>" (lib/mem.h),
+**    tools/bench_compare.py checks run_stack_gap against STACK_MARGIN
+**  - a program which sleeps with interrupts off ends the run early (cpu_Done), a crash fails
+*/
+
+#define SIM_CANARY      0xC5    /* MEM_CANARY of lib/mem.h */
+#define SIM_BYTE_MS     1
+
+int main(int argc, char *argv[])
+{
+    elf_firmware_t firmware;
+    avr_t *avr;
+    avr_irq_t *uart_in;
+    uint32_t flags = 0;
+    uint32_t heap;
+    uint64_t limit;
+    uint64_t next_byte;
+    const char *input;
+    uint32_t p;
+    int state = cpu_Running;
+
+    if (argc < 4)
+    {
+        fprintf(stderr, "usage: stack_sim main.elf heap_start ms [input]\n");
+        return 2;
+    }
+    memset(&firmware, 0, sizeof(firmware));
+    if (elf_read_firmware(argv[1], &firmware))
+    {
+        fprintf(stderr, "stack_sim: %s: cannot load\n", argv[1]);
+        return 1;
+    }
+    heap = strtoul(argv[2], NULL, 16) & 0xFFFF;     /* avr-nm: 0x800000 + data address */
+    input = argc > 4 ? argv[4] : "";
+
+    avr = avr_make_mcu_by_name("atmega328p");
+    if (!avr || avr_init(avr))
+        return 1;
+    avr_load_firmware(avr, &firmware);
+    avr->frequency = 16000000;
+    avr_reset(avr);
+    if (heap == 0 || heap > avr->ramend)
+    {
+        fprintf(stderr, "stack_sim: __heap_start 0x%x outside the SRAM\n", heap);
+        return 1;
+    }
+    memset(avr->data + heap, SIM_CANARY, avr->ramend + 1 - heap);
+
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+    flags &= ~(AVR_UART_FLAG_STDIO | AVR_UART_FLAG_POLL_SLEEP);
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+    uart_in = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+
+    limit = (uint64_t)avr->frequency / 1000 * strtoul(argv[3], NULL, 10);
+    next_byte = limit / 2;
+    while (avr->cycle < limit)
+    {
+        state = avr_run(avr);
+        if (state == cpu_Done || state == cpu_Crashed)
+            break;
+        if (*input && avr->cycle >= next_byte)
+        {
+            avr_raise_irq(uart_in, (uint8_t)*input++);
+            next_byte = avr->cycle + avr->frequency / 1000 * SIM_BYTE_MS;
+        }
+    }
+    if (state == cpu_Crashed)
+    {
+        fprintf(stderr, "stack_sim: %s crashed at 0x%x\n", argv[1], avr->pc);
+        return 1;
+    }
+
+    p = heap;
+    while (p <= avr->ramend && avr->data[p] == SIM_CANARY)
+        p++;
+    printf("BENCH run_stack %u\n", avr->ramend - p + 1);
+    printf("BENCH run_stack_gap %u\n", p - heap);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#ifndef TEST_H
+# define TEST_H
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "mock.h"
+
+/*
+** Host unit tests (x86, registers of mock/avr/io.h)
+**  - CHECK*: print the failing line, keep going, the exit code counts the failures
+**  - TEST(fn): mock_reset() then fn()
+**  - BENCH(name, n, stmt): n runs of stmt, prints ns per run (./test_x bench, make bench)
+**    host time, not AVR cycles: it compares versions of the same code, nothing more
+*/
+
+static int g_test_run;
+static int g_test_failed;
+
+#define CHECK(cond) \
+    do { \
+        g_test_run++; \
+        if (!(cond)) \
+        { \
+            g_test_failed++; \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(got, want) \
+    do { \
+        long long got_ = (long long)(got); \
+        long long want_ = (long long)(want); \
+        g_test_run++; \
+        if (got_ != want_) \
+        { \
+            g_test_failed++; \
+            fprintf(stderr, "%s:%d: %s = %lld, want %lld\n", __FILE__, __LINE__, #got, got_, want_); \
+        } \
+    } while (0)
+
+#define CHECK_STR(got, want) \
+    do { \
+        const char *got_ = (got); \
+        const char *want_ = (want); \
+        g_test_run++; \
+        if (strcmp(got_, want_) != 0) \
+        { \
+            g_test_failed++; \
+            fprintf(stderr, "%s:%d: %s = \"%s\", want \"%s\"\n", __FILE__, __LINE__, #got, got_, want_); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(got, want, eps) \
+    do { \
+        double got_ = (got); \
+        double want_ = (want); \
+        g_test_run++; \
+        if (got_ - want_ > (eps) || want_ - got_ > (eps)) \
+        { \
+            g_test_failed++; \
+            fprintf(stderr, "%s:%d: %s = %f, want %f\n", __FILE__, __LINE__, #got, got_, want_); \
+        } \
+    } while (0)
+
+#define TEST(fn) \
+    do { \
+        mock_reset(); \
+        fn(); \
+    } while (0)
+
+static inline double test_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#define BENCH(name, n, stmt) \
+    do { \
+        double start_ = test_now_ns(); \
+        for (long i_ = 0; i_ < (n); i_++) \
+        { \
+            stmt; \
+        } \
+        printf("  %-32s %8.1f ns\n", name, (test_now_ns() - start_) / (n)); \
+    } while (0)
+
+/* Keep a result alive so the benchmark loop is not optimized away */
+#define BENCH_KEEP(value)   __asm__ volatile("" : : "g"(value) : "memory")
+
+static inline int test_report(const char *name)
+{
+    printf("%-20s %d checks, %d failed\n", name, g_test_run, g_test_failed);
+    return g_test_failed != 0;
+}
+
+static inline int test_bench_mode(int argc, char **argv)
+{
+    return argc > 1 && strcmp(argv[1], "bench") == 0;
+}
+
+#endif
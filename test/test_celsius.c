@@ -0,0 +1,67 @@
+#define main exercise_main
+#include "../module05/ex03/src/main.c"
+#undef main
+
+#include "test.h"
+
+/*
+** module05/ex03: convert_to_celsius() (1.08mV per step, 1mV per K, page 256 24.8)
+*/
+
+static void test_convert_to_celsius(void)
+{
+    CHECK_EQ((int16_t)convert_to_celsius(242), -12);    /* -45C ~ 85C: 242 ~ 352 mV, page 256 24-2 */
+    CHECK_EQ(convert_to_celsius(314), 66);
+    CHECK_EQ(convert_to_celsius(352), 107);
+    CHECK_EQ(convert_to_celsius(1023), 831);
+
+    for (uint16_t adc = 0; adc < 1024; adc++)
+    {
+        int16_t want = (int16_t)((int32_t)adc * 108 / 100 - 273);
+
+        if ((int16_t)convert_to_celsius(adc) != want)
+        {
+            CHECK_EQ((int16_t)convert_to_celsius(adc), want);
+            break;
+        }
+    }
+}
+
+static void test_format_climate(void)
+{
+    char buffer[4];
+
+    format_climate(7, buffer);
+    CHECK_STR(buffer, "07");
+    format_climate(42, buffer);
+    CHECK_STR(buffer, "42");
+}
+
+static void test_sensor_read(void)
+{
+    mock_adc_set(8, 300);
+    init_adc();
+    CHECK_EQ(convert_to_celsius(adc_read(ADC_TEMPERATURE)), 51);
+    CHECK_EQ(g_mock.delay_us, 200);                 /* 1.1V reference settling */
+}
+
+static void bench(void)
+{
+    BENCH("convert_to_celsius", 10000000, BENCH_KEEP(convert_to_celsius(i_ & 1023)));
+}
+
+int main(int argc, char **argv)
+{
+    if (test_bench_mode(argc, argv))
+    {
+        puts("celsius (module05/ex03)");
+        mock_reset();
+        bench();
+        return 0;
+    }
+
+    TEST(test_convert_to_celsius);
+    TEST(test_format_climate);
+    TEST(test_sensor_read);
+    return test_report("celsius");
+}
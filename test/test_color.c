@@ -0,0 +1,207 @@
+#define main exercise_main
+#include "../module03/ex03/src/main.c"
+#undef main
+
+#include "test.h"
+
+/*
+** module03/ex03: color format check, RX parser (text and binary stream), acknowledgement
+*/
+
+/* Parser back to its power on state (static of main.c, kept from test to test) */
+static void color_reset(void)
+{
+    g_nibble = 0;
+    g_fill = 0;
+    g_play = 0;
+    g_show = 0;
+    memset(g_color, 0, sizeof(g_color));
+    g_binary = 0;
+    g_frame_head = 0;
+    g_frame_tail = 0;
+    g_frame_byte = 0;
+    g_frame_left = 0;
+    g_playing = 0;
+    g_stream_end = 0;
+    g_credit = 0;
+    g_colors = 0;
+    g_errors = 0;
+    g_report = 0;
+    g_tx_head = 0;
+    g_tx_tail = 0;
+}
+
+static void rx(const char *bytes, size_t len)
+{
+    while (len--)
+    {
+        mock_rx_isr(USART_RX_vect, (uint8_t)*bytes++);
+    }
+}
+
+/* One pass of the main loop (reports), then the transmit ring drained like the UDRE interrupt would */
+static size_t tx(char *out, size_t size)
+{
+    send_reports();
+    while (UCSR0B & (1 << UDRIE0))
+    {
+        USART_UDRE_vect();
+    }
+    return mock_tx_take(out, size);
+}
+
+static void test_check_color_format(void)
+{
+    const char *color = "#1A2b3C\r";
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        CHECK_EQ(check_color_format(color[i], i), 1);
+    }
+    CHECK_EQ(check_color_format('1', 0), 0);
+    CHECK_EQ(check_color_format('#', 1), 0);
+    CHECK_EQ(check_color_format('g', 3), 0);
+    CHECK_EQ(check_color_format('G', 6), 0);
+    CHECK_EQ(check_color_format('\n', 7), 0);
+    CHECK_EQ(check_color_format('\r', 5), 0);
+    CHECK_EQ(check_color_format('\x02', 2), 0);     /* STX is not a digit */
+    CHECK_EQ(check_color_format('\xFF', 2), 0);
+    CHECK_EQ(hex_char_to_int('b'), 11);
+    CHECK_EQ(hex_char_to_int('z'), 0);
+}
+
+static void test_text_color(void)
+{
+    char out[32];
+
+    color_reset();
+    init_rgb();
+    rx("#FF8001\r\n", 9);
+    CHECK_EQ(g_colors, 1);
+    CHECK_EQ(g_errors, 0);
+    CHECK(TIMSK0 & (1 << TOIE0));                   /* Shown at the next PWM period */
+    CHECK_EQ(OCR0B, 0);
+
+    TIMER0_OVF_vect();
+    CHECK_EQ(OCR0B, 0xFF);
+    CHECK_EQ(OCR0A, 0x80);
+    CHECK_EQ(OCR2B, 0x01);
+    CHECK(!(TIMSK0 & (1 << TOIE0)));
+
+    rx("#0000ff?", 8);
+    TIMER0_OVF_vect();
+    CHECK_EQ(OCR2B, 0xFF);
+    tx(out, sizeof(out));
+    CHECK_STR(out, "OK 2\r\n");
+}
+
+static void test_text_errors(void)
+{
+    char out[32];
+
+    color_reset();
+    rx("12#12#345678x?", 14);                       /* 2 digits without '#', color cut, 'x' */
+    tx(out, sizeof(out));
+    CHECK_STR(out, "ERR 4\r\n");
+    rx("?", 1);                                     /* Counters cleared by the acknowledgement */
+    CHECK_EQ(g_tx_tail, g_tx_head);                 /* Latched only: the main loop writes it */
+    tx(out, sizeof(out));
+    CHECK_STR(out, "OK 0\r\n");
+}
+
+static void test_binary_stream(void)
+{
+    static const char frames[] = { 10, 20, 30, 2, 40, 50, 60, 1, 0, 0, 0, 0 };
+    char out[32];
+
+    color_reset();
+    init_rgb();
+    rx("\x02", 1);
+    CHECK_EQ(g_binary, 1);
+    CHECK_EQ(tx(out, sizeof(out)), 1);
+    CHECK_EQ(out[0], FRAME_QUEUE - 1);              /* First credits: the whole queue */
+
+    rx(frames, sizeof(frames));
+    CHECK_EQ(g_binary, 0);                          /* Duration 0: back to text */
+    CHECK_EQ(g_frame_tail, 2);
+
+    TIMER1_COMPA_vect();                            /* Frame 1, 2 ticks */
+    TIMER0_OVF_vect();
+    CHECK_EQ(OCR0B, 10);
+    TIMER1_COMPA_vect();
+    TIMER1_COMPA_vect();                            /* Frame 2, 1 tick */
+    TIMER0_OVF_vect();
+    CHECK_EQ(OCR2B, 60);
+    TIMER1_COMPA_vect();                            /* Dry: end report */
+    tx(out, sizeof(out));
+    CHECK_STR(out, "END 2 0\r\n");
+
+    g_frames = 65535;                               /* Longest report, latched in the interrupt */
+    g_underruns = 65535;
+    g_stream_end = 1;
+    TIMER1_COMPA_vect();
+    CHECK_EQ(mock_tx_take(out, sizeof(out)), 0);    /* Written by the main loop, not the timer */
+    tx(out, sizeof(out));
+    CHECK_STR(out, "END 65535 65535\r\n");
+}
+
+/* A frame started in the middle of a text color: both colors come out whole */
+static void test_frame_during_color(void)
+{
+    static const char frames[] = { 10, 20, 30, 1, 0, 0, 0, 0 };
+    char out[32];
+
+    color_reset();
+    init_rgb();
+    rx("\x02", 1);
+    rx(frames, sizeof(frames));
+    tx(out, sizeof(out));
+    rx("#123", 4);                                  /* Text color half received */
+    TIMER1_COMPA_vect();                            /* Queued frame starts */
+    TIMER0_OVF_vect();
+    CHECK_EQ(OCR0B, 10);
+    CHECK_EQ(OCR0A, 20);
+    CHECK_EQ(OCR2B, 30);
+    rx("456", 3);
+    TIMER0_OVF_vect();
+    CHECK_EQ(OCR0B, 0x12);
+    CHECK_EQ(OCR0A, 0x34);
+    CHECK_EQ(OCR2B, 0x56);
+    CHECK_EQ(g_errors, 0);
+}
+
+static void bench(void)
+{
+    static const char line[] = "#1A2B3C\r";
+    char out[32];
+    long colors;
+
+    BENCH("check_color_format (8 chars)", 10000000,
+        for (uint8_t k = 0; k < 8; k++) BENCH_KEEP(check_color_format(line[k], k)));
+
+    color_reset();
+    BENCH("USART_RX_vect (one color)", 1000000, rx(line, 8));
+    colors = g_colors;
+    BENCH_KEEP(colors);
+
+    color_reset();
+    BENCH("USART_RX_vect + ack ('?')", 1000000, rx("?", 1); tx(out, sizeof(out)));
+}
+
+int main(int argc, char **argv)
+{
+    if (test_bench_mode(argc, argv))
+    {
+        puts("color (module03/ex03)");
+        mock_reset();
+        bench();
+        return 0;
+    }
+
+    TEST(test_check_color_format);
+    TEST(test_text_color);
+    TEST(test_text_errors);
+    TEST(test_binary_stream);
+    TEST(test_frame_during_color);
+    return test_report("color");
+}
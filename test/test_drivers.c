@@ -0,0 +1,787 @@
+#include <avr/io.h>
+#include "test.h"
+#include "uart.h"
+#include "adc.h"
+#include "twi.h"
+#include "load.h"
+#include "input.h"
+#include "wave.h"
+#include "bam.h"
+#include "kvstore.h"
+#include "elog.h"
+#include "power.h"
+#define TIMER1_FREQ TIMER_HZ(1)
+#include "timer_cfg.h"
+#include <util/crc16.h>
+
+/*
+** lib/uart.c, lib/adc.c, lib/twi.c, lib/load.c, lib/input.c, lib/wave.c, lib/bam.c,
+** lib/kvstore.c, lib/elog.c against the register mock
+*/
+
+void EE_READY_vect(void);                           /* lib/eeprom.c */
+void PCINT2_vect(void);                             /* lib/input.c */
+void TIMER2_COMPA_vect(void);                       /* lib/bam.c */
+
+static void test_uart_init(void)
+{
+    uart_init(UART_UBRR(UART_BAUDRATE));
+    CHECK_EQ(UBRR0, 16);                            /* 115200 with U2X: 2.1% error, page 199 */
+    CHECK(UCSR0A & (1 << U2X0));
+    CHECK_EQ(UCSR0C, 3 << UCSZ00);
+    CHECK_EQ(UCSR0B & ((1 << RXEN0) | (1 << TXEN0)), (1 << RXEN0) | (1 << TXEN0));
+    CHECK(!(PRR & (1 << PRUSART0)));                /* Clock claimed */
+}
+
+static void test_uart_output(void)
+{
+    char out[64];
+
+    uart_init(UART_UBRR(UART_BAUDRATE));
+    uart_puts("abc");
+    uart_tx('\xFF');                                /* char > 0x7F: captured as one byte */
+    uart_puts_P(PSTR("\r\n"));
+    CHECK_EQ(mock_tx_take(out, sizeof(out)), 6);
+    CHECK(memcmp(out, "abc\xFF\r\n", 6) == 0);
+
+    uart_put_u32(0);
+    uart_tx(' ');
+    uart_put_u32(4294967295UL);
+    uart_tx(' ');
+    uart_put_hex8(0x0A);
+    uart_put_hex8(0xF5);
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "0 4294967295 0AF5");
+}
+
+static void test_uart_rx(void)
+{
+    uart_init(UART_UBRR(UART_BAUDRATE));
+    mock_rx_push("ok", 2);
+    CHECK_EQ(uart_rx(), 'o');
+    CHECK_EQ(uart_rx(), 'k');
+    CHECK(!(UCSR0A & (1 << RXC0)));
+}
+
+static void test_uart_clock(void)
+{
+    uart_init(UART_UBRR(UART_BAUDRATE));
+    uart_clock(3);                                  /* 2MHz: (17 + 4) >> 3 = 2 -> UBRR 1 */
+    CHECK_EQ(UBRR0, 1);
+    uart_clock(0);
+    CHECK_EQ(UBRR0, 16);
+}
+
+static void test_timer_clock(void)
+{
+    uint16_t top;
+
+    CHECK_EQ(clock_timer(0, 64UL * 250, 0, &top), 3);   /* 1kHz at 16MHz: /64, TOP 249 */
+    CHECK_EQ(top, 249);
+    CHECK_EQ(clock_timer(0, 64UL * 250, 4, &top), 2);   /* 1MHz: 1000 counts -> /8, 125 */
+    CHECK_EQ(top, 124);
+    CHECK_EQ(clock_timer(1, 1024UL * 65536, 0, &top), 5);
+    CHECK_EQ(top, 65535);
+    CHECK_EQ(clock_timer(2, 32UL * 250, 0, &top), 3);   /* Timer2 has /32 */
+    CHECK_EQ(top, 249);
+
+    OCR1A = TIMER1_TOP;                             /* 1Hz: /256, TOP 62499 */
+    TCCR1B = TIMER1_TCCRB;
+    TCNT1 = 20000;
+    timer1_clock(4);                                /* 1MHz: 1000000 counts -> /64, 15625 */
+    CHECK_EQ(OCR1A, 15624);
+    CHECK_EQ(TCCR1B, (1 << WGM12) | (1 << CS11) | (1 << CS10));
+    CHECK_EQ(TCNT1, 0);
+    timer1_clock(0);
+    CHECK_EQ(OCR1A, TIMER1_TOP);
+    CHECK_EQ(TCCR1B, TIMER1_TCCRB);
+
+    TCCR1B = 1 << WGM12;                            /* stopped: stays stopped */
+    timer1_clock(4);
+    CHECK_EQ(TCCR1B, 1 << WGM12);
+    TCCR1B = 0;
+}
+
+static void test_power_mode(void)
+{
+    UCSR0B = 0;
+    TCCR0B = 0;
+    TCCR1B = 0;
+    TCCR2B = 0;
+    CHECK_EQ(power_mode(), POWER_DOWN);
+    UCSR0B = (1 << TXEN0);                          /* Last byte out (mock: UDRE0 and TXC0 set) */
+    CHECK_EQ(power_mode(), POWER_DOWN);
+    EIMSK = (1 << INT0);
+    EICRA = 0;                                      /* Low level: wakes from power down */
+    CHECK_EQ(power_mode(), POWER_DOWN);
+    EICRA = (1 << ISC01);                           /* Falling edge: needs the I/O clock */
+    CHECK_EQ(power_mode(), POWER_IDLE);
+    EIMSK = (1 << INT1);
+    CHECK_EQ(power_mode(), POWER_DOWN);
+    EICRA = (1 << ISC10);                           /* Any change */
+    CHECK_EQ(power_mode(), POWER_IDLE);
+    EIMSK = 0;
+    EICRA = 0;
+    UCSR0B = 0;
+}
+
+static void test_adc(void)
+{
+    init_adc();
+    CHECK_EQ(ADMUX, ADC_AVCC);
+    CHECK_EQ(ADCSRA, (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0));
+
+    mock_adc_set(0, 1023);
+    mock_adc_set(2, 512);
+    CHECK_EQ(adc_read(ADC_CHANNEL(0)), 1023);
+    CHECK_EQ(adc_read(ADC_CHANNEL(2)), 512);
+    CHECK_EQ(adc_read8(ADC_CHANNEL(2)), 128);
+    CHECK_EQ(g_mock.conversions, 3);
+    CHECK_EQ(g_mock.delay_us, 0);                   /* Same reference: no settling time */
+
+    mock_adc_set(8, 352);
+    CHECK_EQ(adc_read(ADC_TEMPERATURE), 352);
+    CHECK_EQ(g_mock.delay_us, 200);                 /* AVCC -> 1.1V: 200us once */
+    adc_read(ADC_TEMPERATURE);
+    CHECK_EQ(g_mock.delay_us, 200);
+
+    adc_stop();
+    CHECK_EQ(ADCSRA, 0);
+    CHECK(PRR & (1 << PRADC));
+
+    adc_clock(CLOCK_2MHZ);                          /* Off: kept for the next init */
+    CHECK_EQ(ADCSRA, 0);
+    init_adc();
+    CHECK_EQ(ADCSRA, (1 << ADEN) | (1 << ADPS2));   /* 2MHz / 16 = 125kHz */
+    adc_clock(CLOCK_16MHZ);
+    CHECK_EQ(ADCSRA, (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0));
+    adc_stop();
+}
+
+static void test_twi_write(void)
+{
+    mock_twi_device(0x38);
+    clock_set(CLOCK_2MHZ);
+    i2c_init();
+    CHECK_EQ(TWBR, 2);                              /* Init after clock_set(): (2MHz / 100kHz - 16) / 2 */
+    i2c_deinit();
+    clock_set(CLOCK_16MHZ);
+    i2c_init();
+    CHECK_EQ(TWBR, 72);                             /* 100kHz: (16MHz / 100kHz - 16) / 2 */
+
+    CHECK_EQ(i2c_start(), TW_START);
+    CHECK_EQ(i2c_write(0x38 << 1), TW_MT_SLA_ACK);
+    CHECK_EQ(i2c_write(0xAC), TW_MT_DATA_ACK);
+    CHECK_EQ(i2c_start(), TW_REP_START);
+    i2c_stop();
+    CHECK_EQ(g_mock.twi_log_len, 2);
+    CHECK_EQ(g_mock.twi_log[0], 0x70);
+    CHECK_EQ(g_mock.twi_log[1], 0xAC);
+    CHECK_EQ(g_mock.twi_stops, 1);
+    CHECK(!(TWCR & (1 << TWSTO)));
+
+    CHECK_EQ(i2c_start(), TW_START);
+    CHECK_EQ(i2c_write(0x42 << 1), TW_MT_SLA_NACK); /* Nobody at the address */
+    i2c_stop();
+
+    mock_twi_status(TW_MT_ARB_LOST);                /* Another master took the bus */
+    CHECK_EQ(i2c_start(), TW_MT_ARB_LOST);
+    i2c_deinit();                                   /* Claims are counted (lib/periph.c) */
+}
+
+static void test_twi_read(void)
+{
+    static const uint8_t data[] = { 0x1C, 0x80, 0x00, 0x05, 0x66, 0x66, 0xA5 };
+
+    mock_twi_device(0x38);
+    i2c_init();
+    mock_twi_rx(data, sizeof(data));
+    i2c_start();
+    CHECK_EQ(i2c_write((0x38 << 1) | TW_READ), TW_MR_SLA_ACK);
+    CHECK_EQ(i2c_read_ack(), 0x1C);
+    CHECK_EQ(TW_STATUS, TW_MR_DATA_ACK);
+    CHECK_EQ(i2c_read_ack(), 0x80);
+    CHECK_EQ(i2c_read_nack(), 0x00);
+    CHECK_EQ(TW_STATUS, TW_MR_DATA_NACK);
+    i2c_stop();
+
+    i2c_deinit();
+    CHECK(PRR & (1 << PRTWI));
+}
+
+/* Exclusive accounting: the cycles go to the running account, the window is closed slots only */
+static void test_load(void)
+{
+    uint8_t prev;
+
+    TCNT1 = 0;
+    load_init();
+    TCNT1 = 1000;
+    prev = load_switch(1);                          /* ISR entry after 1000 idle cycles */
+    CHECK_EQ(prev, LOAD_IDLE);
+    TCNT1 = 1500;
+    load_switch(prev);
+    CHECK_EQ(g_load_cycles[LOAD_IDLE], 1000);
+    CHECK_EQ(g_load_cycles[1], 500);
+    CHECK_EQ(g_load_current, LOAD_IDLE);
+
+    TCNT1 = 65000;
+    load_switch(2);
+    TCNT1 = 564;                                    /* Timer1 wrapped: 1100 cycles */
+    load_switch(LOAD_IDLE);
+    CHECK_EQ(g_load_cycles[2], 1100);
+    CHECK_EQ(load_permille(2), 0);                  /* No slot closed yet */
+
+    for (uint8_t i = 0; i < LOAD_SLOT_OVF; i++)
+        load_overflow();
+    CHECK_EQ(g_load_cycles[1], 500 & 63);           /* Under 64 cycles: next slot */
+    CHECK_NEAR(load_permille(1), 500 * 1000.0 / 65064, 2);     /* Slots count 64 cycle units */
+    CHECK_NEAR(load_permille(2), 1100 * 1000.0 / 65064, 2);
+    CHECK_NEAR(load_busy_permille(), 1600 * 1000.0 / 65064, 2);
+}
+
+/* Timer1 at clk/8: 2000 ticks = 1ms, 32ms at most (no overflow: icp.c has the ISR too on the host) */
+static void input_ms(uint32_t ms)
+{
+    TCNT1 += ms * 2000;
+}
+
+static void test_input(void)
+{
+    t_input_event event;
+
+    PIND = 0xFF;
+    systime_init();
+    TIFR1 = 0;                                      /* Its write 1 to clear is a set on the mock */
+    TCNT1 = 0;
+    input_watch(INPUT_PORTD, 1 << 2);
+
+    PIND = ~(1 << 2);                               /* Press, then a bounce inside the lockout */
+    PCINT2_vect();
+    input_ms(2);
+    PIND = 0xFF;
+    PCINT2_vect();
+    input_ms(2);
+    PIND = ~(1 << 2);
+    PCINT2_vect();
+    CHECK_EQ(input_poll(&event), 1);
+    CHECK_EQ(INPUT_FELL(&event, 1 << 2), 1 << 2);
+    input_ms(20);
+    CHECK_EQ(input_poll(&event), 0);                /* Ended low: nothing more */
+    PIND = 0xFF;
+    PCINT2_vect();
+    CHECK_EQ(input_poll(&event), 1);
+    CHECK_EQ(INPUT_ROSE(&event, 1 << 2), 1 << 2);
+
+    TCNT1 = 0;                                      /* Tap of 2ms: the release comes after the lockout */
+    PIND = ~(1 << 2);
+    PCINT2_vect();
+    input_ms(2);
+    PIND = 0xFF;
+    PCINT2_vect();
+    CHECK_EQ(input_poll(&event), 1);
+    CHECK_EQ(INPUT_FELL(&event, 1 << 2), 1 << 2);
+    CHECK_EQ(input_poll(&event), 0);
+    input_ms(20);
+    CHECK_EQ(input_poll(&event), 1);
+    CHECK_EQ(INPUT_ROSE(&event, 1 << 2), 1 << 2);
+    CHECK_EQ(input_dropped(), 0);
+}
+
+static void test_wave(void)
+{
+    t_wave wave;
+
+    CHECK_EQ(wave_init(&wave, g_wave_sawtooth, NULL, NULL), WAVE_ERR_OUTPUT);
+    wave_set_period(&wave, 100);
+    wave_tick(&wave);                               /* Refused: goes nowhere, no NULL write */
+
+    CHECK_EQ(wave_init(&wave, g_wave_sawtooth, &OCR0A, NULL), WAVE_OK);
+    wave_set_period(&wave, 2560);                   /* 256 ticks at 100Hz: one sample per tick */
+    wave_tick(&wave);
+    wave_tick(&wave);
+    CHECK_EQ(OCR0A, 2);
+    wave_set_amplitude(&wave, 200, 100);            /* Kept under 256: 155 + 100 */
+    wave_set_phase(&wave, 254);
+    wave_tick(&wave);
+    CHECK_EQ(OCR0A, 100 + (255 * 155 + 255) / 256);
+}
+
+static void test_bam(void)
+{
+    TCCR1A = (1 << COM1A1);                         /* OC1A hardware PWM (module01): PB1 kept out */
+    PORTB = (1 << PB5);
+    bam_init(&PORTB, (1 << PB0) | (1 << PB1) | (1 << PB2) | (1 << PB4));
+    CHECK(TIMSK2 & (1 << OCIE2A));
+    CHECK_EQ(TCCR2B, (1 << CS22) | (1 << CS21));
+    CHECK(!(PRR & (1 << PRTIM2)));
+
+    bam_set(PB0, 255);
+    bam_set(PB1, 255);
+    bam_set(PB4, 0x82);                             /* Slots 1 and 7 */
+    bam_commit();
+    TIMER2_COMPA_vect();                            /* Slot 0: new buffer taken */
+    CHECK_EQ(PORTB, (1 << PB5) | (1 << PB0));
+    CHECK_EQ(OCR2A, 0);
+    TIMER2_COMPA_vect();
+    CHECK_EQ(PORTB, (1 << PB5) | (1 << PB0) | (1 << PB4));
+    CHECK_EQ(OCR2A, 1);
+    for (uint8_t bit = 2; bit < BAM_BITS; bit++)
+        TIMER2_COMPA_vect();
+    CHECK_EQ(PORTB, (1 << PB5) | (1 << PB0) | (1 << PB4));
+    CHECK_EQ(OCR2A, 127);                           /* Slot 7: 128 units */
+
+    bam_set(PB0, 0);
+    bam_commit();                                   /* Shown from the next frame only */
+    TIMER2_COMPA_vect();
+    CHECK_EQ(PORTB, (1 << PB5));
+    CHECK_EQ(OCR2A, 0);
+
+    bam_stop();
+    CHECK_EQ(TCCR2B, 0);
+    CHECK(!(TIMSK2 & (1 << OCIE2A)));
+    CHECK_EQ(PORTB, (1 << PB5));                    /* Other pins of the port kept */
+}
+
+/* 8 keys of 11 chars, values of 19: records of 35 bytes, 3 per page */
+static const char *const g_kv_keys[KV_ENTRIES] =
+{
+    "key_alpha_0", "key_alpha_1", "key_alpha_2", "key_alpha_3",
+    "key_alpha_4", "key_alpha_5", "key_alpha_6", "key_alpha_7",
+};
+static char g_kv_model[KV_ENTRIES][KV_VALUE_SIZE];
+
+static void kv_value_of(char *value, uint8_t key, uint16_t round)
+{
+    snprintf(value, KV_VALUE_SIZE, "value_%u_%05u_pad__", key, round);
+}
+
+/* Every key as in the model (kv_init() reads it all back from the EEPROM) */
+static int kv_model_ok(void)
+{
+    for (uint8_t i = 0; i < KV_ENTRIES; i++)
+    {
+        const char *value = kv_get(g_kv_keys[i]);
+
+        if (g_kv_model[i][0] ? !value || strcmp(value, g_kv_model[i]) : value != 0)
+            return 0;
+    }
+    return 1;
+}
+
+/* kv_set() until the queue takes it, the EEPROM written as it goes (never stuck on KV_ERR_BUSY) */
+static uint8_t kv_set_drained(uint8_t key, const char *value)
+{
+    uint8_t status;
+
+    for (uint8_t steps = 0; (status = kv_set(g_kv_keys[key], value)) == KV_ERR_BUSY && steps < KV_PAGES; steps++)
+        mock_ee_ready(EE_READY_vect, 1000);         /* One page written per step */
+    mock_ee_ready(EE_READY_vect, 1000);
+    if (status == KV_OK)
+        strcpy(g_kv_model[key], value);
+    return status;
+}
+
+/* kv_set() of key, reset after cut bytes written (or less, when it is done before): bytes written */
+static size_t kv_set_cut(uint8_t key, const char *value, size_t cut)
+{
+    size_t runs = 0;
+
+    while (kv_set(g_kv_keys[key], value) == KV_ERR_BUSY)
+    {
+        runs += mock_ee_ready(EE_READY_vect, cut - runs);
+        if (runs == cut)
+            return runs;
+    }
+    return runs + mock_ee_ready(EE_READY_vect, cut - runs);
+}
+
+static void test_kv_records(void)
+{
+    char value[KV_VALUE_SIZE];
+    uint8_t status = KV_OK;
+    uint8_t i;
+
+    kv_init();                                      /* Blank EEPROM */
+    CHECK(kv_get("user") == 0);
+    CHECK_EQ(kv_set("user", "admin"), KV_OK);
+    CHECK_EQ(kv_set("pass", "secret"), KV_OK);
+    CHECK_EQ(kv_set("pass", "secret"), KV_OK);      /* Same value: nothing queued */
+    CHECK_EQ(kv_set("", "x"), KV_ERR_SIZE);
+    CHECK_EQ(kv_set("key_too_long", "x"), KV_ERR_SIZE);
+    CHECK_EQ(kv_del("pass"), KV_OK);
+    CHECK(kv_busy());
+    mock_ee_ready(EE_READY_vect, 1000);
+    CHECK(!kv_busy());
+    CHECK_EQ(g_mock.eeprom[0], KV_VERSION);         /* First page: 0, sequence 0xFFFF + 1 */
+    CHECK_EQ(g_mock.eeprom[1], 0);
+    CHECK_EQ(g_mock.eeprom[2], 0);
+
+    kv_init();
+    CHECK_STR(kv_get("user"), "admin");
+    CHECK(kv_get("pass") == 0);                     /* Tombstone read after the record */
+
+    g_mock.eeprom[1] = 4;                           /* Same bytes, other round: the CRCs fail */
+    kv_init();
+    CHECK(kv_get("user") == 0);
+    g_mock.eeprom[1] = 0;
+    kv_init();
+    CHECK_STR(kv_get("user"), "admin");
+
+    g_mock.eeprom[3 + 3 + 4] ^= 1;                  /* Page header, record header, "user": "admin" torn */
+    kv_init();
+    CHECK(kv_get("user") == 0);
+    CHECK_EQ(kv_set("user", "root"), KV_OK);
+    mock_ee_ready(EE_READY_vect, 1000);
+    kv_init();
+    CHECK_STR(kv_get("user"), "root");
+
+    for (i = 0; i < 40 && status == KV_OK; i++)     /* Queued, none written: the queue fills */
+    {
+        snprintf(value, sizeof(value), "admin_%u", i);
+        status = kv_set("user", value);
+    }
+    CHECK_EQ(status, KV_ERR_BUSY);
+    CHECK(i > 4);
+    snprintf(value, sizeof(value), "admin_%u", i - 2);
+    CHECK_STR(kv_get("user"), value);               /* Refused: the cache keeps the last one */
+    mock_ee_ready(EE_READY_vect, 1000);
+    snprintf(value, sizeof(value), "admin_%u", i - 1);
+    CHECK_EQ(kv_set("user", value), KV_OK);
+    CHECK_EQ(kv_set("user", "admin"), KV_OK);
+    mock_ee_ready(EE_READY_vect, 1000);
+    kv_init();
+    CHECK_STR(kv_get("user"), "admin");
+}
+
+/*
+** Largest records, every key live: the ring goes round many times, the live records
+** of the oldest page move on, a write never needs more than the queue holds
+*/
+static void test_kv_ring(void)
+{
+    char value[KV_VALUE_SIZE];
+    uint8_t failed = 0;
+
+    memset(g_kv_model, 0, sizeof(g_kv_model));
+    kv_init();
+    for (uint16_t round = 0; round < 300; round++)
+    {
+        uint8_t key = round < KV_ENTRIES ? round : (round * 5) % 7 + (round & 1);
+
+        kv_value_of(value, key, round);
+        if (kv_set_drained(key, value) != KV_OK || !kv_model_ok())
+            failed++;
+        if (round % 16 == 15)
+        {
+            kv_init();
+            if (!kv_model_ok())
+                failed++;
+        }
+    }
+    CHECK_EQ(failed, 0);
+
+    CHECK_EQ(kv_del(g_kv_keys[5]), KV_OK);          /* Tombstone kept while older copies live */
+    g_kv_model[5][0] = '\0';
+    for (uint16_t round = 0; round < 40; round++)
+    {
+        kv_value_of(value, round % 4, round);
+        kv_set_drained(round % 4, value);
+    }
+    kv_init();
+    CHECK(kv_model_ok());
+}
+
+/*
+** Reset after each byte of a write (page openings included): the old value or the new one,
+** the other keys as they were, and the next write goes on from there
+*/
+static void test_kv_reset(void)
+{
+    static uint8_t saved[KV_EEPROM_SIZE];
+    char saved_model[KV_ENTRIES][KV_VALUE_SIZE];
+    char value[KV_VALUE_SIZE];
+    uint16_t failed = 0;
+
+    memset(g_kv_model, 0, sizeof(g_kv_model));
+    kv_init();
+    for (uint16_t round = 0; round < 20; round++)
+    {
+        kv_value_of(value, round % KV_ENTRIES, round);
+        kv_set_drained(round % KV_ENTRIES, value);
+    }
+    for (uint8_t n = 0; n < 6; n++)                 /* 3 records per page: 2 openings at least */
+    {
+        uint8_t key = (n * 3) % KV_ENTRIES;
+        size_t total;
+
+        memcpy(saved, &g_mock.eeprom[KV_EEPROM_START], KV_EEPROM_SIZE);
+        memcpy(saved_model, g_kv_model, sizeof(g_kv_model));
+        kv_value_of(value, key, 1000 + n);
+        kv_init();
+        total = kv_set_cut(key, value, 100000);
+        CHECK_STR(kv_get(g_kv_keys[key]), value);
+        for (size_t cut = 0; cut <= total; cut++)
+        {
+            memcpy(&g_mock.eeprom[KV_EEPROM_START], saved, KV_EEPROM_SIZE);
+            memcpy(g_kv_model, saved_model, sizeof(g_kv_model));
+            kv_init();
+            kv_set_cut(key, value, cut);
+            kv_init();                              /* Reset */
+            if (kv_get(g_kv_keys[key]) && !strcmp(kv_get(g_kv_keys[key]), value))
+                strcpy(g_kv_model[key], value);
+            if (!kv_model_ok())
+                failed++;
+
+            kv_value_of(g_kv_model[7], 7, cut);     /* The next write after the reset */
+            kv_set_drained(7, g_kv_model[7]);
+            kv_init();
+            if (!kv_model_ok())
+                failed++;
+        }
+        memcpy(&g_mock.eeprom[KV_EEPROM_START], saved, KV_EEPROM_SIZE);
+        memcpy(g_kv_model, saved_model, sizeof(g_kv_model));
+        kv_init();
+        kv_set_drained(key, value);
+    }
+    CHECK_EQ(failed, 0);
+}
+
+/* EEPROM page of the logger */
+static uint8_t *elog_page(uint8_t slot)
+{
+    return &g_mock.eeprom[ELOG_EEPROM_START + slot * ELOG_PAGE_SIZE];
+}
+
+/*
+** Samples of a logger page up to its last good commit, -1: none (tools/elog_dump.py does the same)
+** *last: channel 0 of the last one
+*/
+static int elog_samples(const uint8_t *page, int16_t *last)
+{
+    uint8_t channels = page[3];
+    int16_t values[ELOG_CHANNELS];
+    uint16_t crc = 0xFFFF;
+    int samples = 1;
+    int committed = -1;
+    size_t offset;
+
+    if (page[0] != ELOG_VERSION || channels == 0 || channels > ELOG_CHANNELS)
+        return -1;
+    memcpy(values, &page[10], 2 * channels);
+    for (offset = 0; offset < 10 + 2u * channels; offset++)
+        crc = _crc_ccitt_update(crc, page[offset]);
+    while (offset + ELOG_COMMIT_SIZE <= ELOG_PAGE_SIZE)
+    {
+        uint8_t flags = page[offset++];
+
+        crc = _crc_ccitt_update(crc, flags);
+        if (flags == ELOG_COMMIT)
+        {
+            if (crc != (page[offset] | (page[offset + 1] << 8)))
+                break;
+            committed = samples;
+            *last = values[0];
+            crc = _crc_ccitt_update(crc, page[offset++]);
+            crc = _crc_ccitt_update(crc, page[offset++]);
+            continue;
+        }
+        if (flags & ~(ELOG_TIME_BIT | ((1 << channels) - 1)))
+            break;
+        for (uint8_t n = 0; n <= ELOG_CHANNELS; n++)  /* Period first, then the channels */
+        {
+            uint8_t bit = n ? n - 1 : 6;
+            uint32_t zigzag = 0;
+
+            if (!(flags & (1 << bit)))
+                continue;
+            for (uint8_t shift = 0; offset < ELOG_PAGE_SIZE; shift += 7)
+            {
+                crc = _crc_ccitt_update(crc, page[offset]);
+                zigzag |= (uint32_t)(page[offset] & 0x7F) << shift;
+                if (!(page[offset++] & 0x80))
+                    break;
+            }
+            if (n)
+                values[bit] += (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+        }
+        samples++;
+    }
+    return committed;
+}
+
+/* Same period, same values: 1 byte; one small change: 2 bytes */
+static void test_elog_records(void)
+{
+    static const uint8_t records[] = { 0x40, 0x14, 0x00, 0x01, 0x02, 0x03, 0x03, 0x02, ELOG_COMMIT };
+    int16_t values[2] = { 215, 480 };
+    uint8_t *page = elog_page(0);
+    int16_t last;
+
+    elog_init(2, 100);
+    CHECK_EQ(elog_add(0, values), ELOG_OK);         /* Base of the page (header) */
+    CHECK_EQ(elog_add(1000, values), ELOG_OK);      /* Period 0 -> 10: +10 = 0x14 */
+    CHECK_EQ(elog_add(2050, values), ELOG_OK);      /* 20 ticks: same period */
+    values[0] = 216;
+    CHECK_EQ(elog_add(3000, values), ELOG_OK);      /* Channel 0 +1 */
+    values[0] = 214;
+    values[1] = 481;
+    CHECK_EQ(elog_add(4000, values), ELOG_OK);      /* -2 and +1 */
+    CHECK(!elog_busy());                            /* Nothing written before a flush */
+
+    elog_flush();
+    CHECK(elog_busy());
+    CHECK(mock_ee_ready(EE_READY_vect, 1000) < 1000);
+    CHECK(!elog_busy());
+    CHECK_EQ(page[1] | (page[2] << 8), 0);          /* First sequence on a blank EEPROM */
+    CHECK_EQ(page[3], 2);
+    CHECK_EQ(page[4] | (page[5] << 8), 100);
+    CHECK_EQ(page[10] | (page[11] << 8), 215);
+    CHECK_EQ(page[12] | (page[13] << 8), 480);
+    CHECK(memcmp(&page[14], records, sizeof(records)) == 0);
+    CHECK_EQ(elog_samples(page, &last), 5);
+    CHECK_EQ(last, 214);
+    CHECK_EQ(g_mock.eeprom_writes, 14 + sizeof(records) + 2);
+
+    elog_flush();                                   /* Nothing new: no write */
+    CHECK(!elog_busy());
+}
+
+/* Pages in turn, the newest one found again at boot, a torn flush leaves the commit before */
+static void test_elog_ring(void)
+{
+    int16_t value = 0;
+    int16_t last;
+
+    elog_init(1, 1000);
+    for (uint16_t i = 0; i < 5 * 57 + 1; i++)     /* 57 samples per page: base + 56 records of 2 bytes */
+    {
+        value++;
+        CHECK_EQ(elog_add(i * 1000UL, &value), ELOG_OK);
+        mock_ee_ready(EE_READY_vect, 1000);
+    }
+    elog_flush();
+    mock_ee_ready(EE_READY_vect, 1000);
+    CHECK_EQ(elog_page(0)[1], 4);                   /* Sequence 4 over 0 */
+    CHECK_EQ(elog_page(1)[1], 5);
+    CHECK_EQ(elog_page(2)[1], 2);
+    CHECK_EQ(elog_page(3)[1], 3);
+    CHECK_EQ(elog_samples(elog_page(0), &last), 57);
+    CHECK_EQ(last, 5 * 57);
+    CHECK_EQ(elog_samples(elog_page(1), &last), 1);
+    CHECK_EQ(elog_samples(elog_page(3), &last), 57);
+
+    elog_init(1, 1000);                             /* Reset: next page after sequence 5 */
+    elog_add(0, &value);
+    value += 3;
+    elog_add(1000, &value);
+    elog_flush();
+    mock_ee_ready(EE_READY_vect, 1000);
+    CHECK_EQ(elog_page(2)[1], 6);
+    CHECK_EQ(elog_samples(elog_page(2), &last), 2);
+
+    value += 300;                                   /* 3 byte record, then the commit */
+    elog_add(2000, &value);
+    elog_flush();
+    mock_ee_ready(EE_READY_vect, 3);                /* Record written, not the commit: reset */
+    CHECK(elog_busy());
+    CHECK_EQ(elog_samples(elog_page(2), &last), 2);
+    CHECK_EQ(last, value - 300);
+
+    elog_init(1, 1000);                             /* The torn page is still the newest */
+    elog_add(3000, &value);
+    elog_flush();
+    mock_ee_ready(EE_READY_vect, 1000);
+    CHECK_EQ(elog_page(3)[1], 7);
+}
+
+/* Both RAM pages taken: dropped and counted, the dump has the EEPROM then the RAM pages */
+static void test_elog_dump(void)
+{
+    static char out[MOCK_QUEUE];
+    int16_t value = 0;
+    int16_t last;
+    uint16_t crc = 0xFFFF;
+    size_t len;
+
+    uart_init(UART_UBRR(UART_BAUDRATE));
+    elog_init(1, 1000);
+    for (uint16_t i = 0; i < 2 * 57; i++)           /* No interrupt: the first page stays queued */
+    {
+        value++;
+        CHECK_EQ(elog_add(i * 1000UL, &value), ELOG_OK);
+    }
+    CHECK_EQ(elog_add(114000, &value), ELOG_ERR_BUSY);
+
+    elog_dump();
+    len = mock_tx_take(out, sizeof(out));
+    CHECK_EQ(len, 2 + 5 + 6 * ELOG_PAGE_SIZE + 2);
+    CHECK(memcmp(out, "EL\x01\x80\x01\x00\x06", 7) == 0);     /* Version 1, 128, lost 1, 6 pages */
+    for (size_t i = 2; i < len - 2; i++)
+        crc = _crc_ccitt_update(crc, (uint8_t)out[i]);
+    CHECK_EQ(crc, (uint8_t)out[len - 2] | ((uint8_t)out[len - 1] << 8));
+    CHECK_EQ(elog_samples((uint8_t *)&out[7], &last), -1);         /* Not written yet */
+    CHECK_EQ(elog_samples((uint8_t *)&out[7 + 4 * ELOG_PAGE_SIZE], &last), 57);
+    CHECK_EQ(elog_samples((uint8_t *)&out[7 + 5 * ELOG_PAGE_SIZE], &last), 57);  /* Commit in RAM */
+    CHECK_EQ(last, 114);
+
+    mock_ee_ready(EE_READY_vect, 1000);             /* Room again */
+    CHECK_EQ(elog_add(115000, &value), ELOG_OK);
+    elog_dump();
+    mock_tx_take(out, sizeof(out));
+    CHECK_EQ(out[4], 0);                            /* Lost count sent once */
+}
+
+static void bench(void)
+{
+    char out[MOCK_QUEUE];
+
+    uart_init(UART_UBRR(UART_BAUDRATE));
+    BENCH("uart_put_u32", 1000000, uart_put_u32(4294967295UL); mock_tx_take(out, sizeof(out)));
+    BENCH("uart_puts (16 chars)", 1000000, uart_puts("0123456789abcdef"); mock_tx_take(out, sizeof(out)));
+
+    init_adc();
+    BENCH("adc_read", 1000000, BENCH_KEEP(adc_read(ADC_CHANNEL(i_ & 7))));
+
+    mock_twi_device(0x38);
+    i2c_init();
+    BENCH("i2c start / write / stop", 1000000, i2c_start(); i2c_write(0x70); i2c_stop());
+
+    int16_t values[2] = { 215, 480 };
+
+    elog_init(2, 1000);
+    BENCH("elog_add (2 channels)", 1000000,
+        values[i_ & 1] += (i_ & 2) - 1; BENCH_KEEP(elog_add(i_ * 1000UL, values)); mock_ee_ready(EE_READY_vect, 1000));
+}
+
+int main(int argc, char **argv)
+{
+    if (test_bench_mode(argc, argv))
+    {
+        puts("drivers");
+        mock_reset();
+        bench();
+        return 0;
+    }
+
+    TEST(test_uart_init);
+    TEST(test_uart_output);
+    TEST(test_uart_rx);
+    TEST(test_uart_clock);
+    TEST(test_timer_clock);
+    TEST(test_power_mode);
+    TEST(test_adc);
+    TEST(test_twi_write);
+    TEST(test_twi_read);
+    TEST(test_load);
+    TEST(test_input);
+    TEST(test_wave);
+    TEST(test_bam);
+    TEST(test_kv_records);
+    TEST(test_kv_ring);
+    TEST(test_kv_reset);
+    TEST(test_elog_records);
+    TEST(test_elog_ring);
+    TEST(test_elog_dump);
+    return test_report("drivers");
+}
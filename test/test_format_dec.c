@@ -0,0 +1,71 @@
+#define main exercise_main
+#include "../module05/ex02/src/main.c"
+#undef main
+
+#include "test.h"
+
+/*
+** module05/ex02: format_dec() against snprintf, over the whole 16 bit range
+*/
+
+static void test_format_dec(void)
+{
+    char buffer[8];
+    char want[8];
+
+    format_dec(0, buffer);
+    CHECK_STR(buffer, "0");
+    format_dec(1023, buffer);                       /* Largest ADC value */
+    CHECK_STR(buffer, "1023");
+    format_dec(65535, buffer);
+    CHECK_STR(buffer, "65535");
+
+    for (uint32_t value = 0; value <= 0xFFFF; value++)
+    {
+        format_dec(value, buffer);
+        snprintf(want, sizeof(want), "%u", (unsigned)value);
+        if (strcmp(buffer, want) != 0)
+        {
+            CHECK_STR(buffer, want);
+            break;
+        }
+    }
+}
+
+/* The line of the main loop: "<ms>: rv1, ldr, ntc" */
+static void test_adc_line(void)
+{
+    char out[64];
+    char buffer[5];
+
+    init_adc();
+    mock_adc_set(1, 1023);
+    format_dec(adc_read(ADC_CHANNEL(1)), buffer);
+    uart_puts(buffer);
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "1023");
+}
+
+static void bench(void)
+{
+    char buffer[8];
+
+    BENCH("format_dec (0 ~ 1023)", 10000000, format_dec(i_ & 1023, buffer); BENCH_KEEP(buffer[0]));
+    BENCH("format_dec (65535)", 10000000, format_dec(65535, buffer); BENCH_KEEP(buffer[0]));
+    BENCH("utoa (0 ~ 1023)", 10000000, utoa(i_ & 1023, buffer, 10); BENCH_KEEP(buffer[0]));
+}
+
+int main(int argc, char **argv)
+{
+    if (test_bench_mode(argc, argv))
+    {
+        puts("format_dec (module05/ex02)");
+        mock_reset();
+        bench();
+        return 0;
+    }
+
+    TEST(test_format_dec);
+    TEST(test_adc_line);
+    return test_report("format_dec");
+}
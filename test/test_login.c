@@ -0,0 +1,165 @@
+#define main exercise_main
+#include "../module02/ex04/src/main.c"
+#undef main
+
+#include "test.h"
+
+/*
+** module02/ex04: login RX interrupt (echo, password mask, backspace, 31 char limit),
+** shell line editing and a few commands (shell.c / commands.c linked as they are)
+*/
+
+static void login_reset(void)
+{
+    g_current_state = STATE_WAIT_USERNAME;
+    g_buffer_index = 0;
+    g_input_ready = 0;
+    memset(g_username_buffer, 0, sizeof(g_username_buffer));
+    memset(g_password_buffer, 0, sizeof(g_password_buffer));
+    memset(&g_shell_stats, 0, sizeof(g_shell_stats));
+}
+
+static void rx(const char *bytes)
+{
+    while (*bytes)
+    {
+        mock_rx_isr(USART_RX_vect, (uint8_t)*bytes++);
+    }
+}
+
+static void test_username(void)
+{
+    char out[64];
+
+    login_reset();
+    rx("spectrx\x7F" "e\r");
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "spectrx\b \be\r\n");
+    CHECK_STR(g_username_buffer, "spectre");
+    CHECK_EQ(g_current_state, STATE_WAIT_PASSWORD);
+    CHECK_EQ(g_input_ready, 1);
+}
+
+static void test_password_masked(void)
+{
+    char out[64];
+
+    login_reset();
+    g_current_state = STATE_WAIT_PASSWORD;
+    rx("abc\b\b\b\bxy\r");                          /* One backspace too many: ignored */
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "***\b \b\b \b\b \b**\r\n");
+    CHECK_STR(g_password_buffer, "xy");
+    CHECK_EQ(g_current_state, STATE_CHECKING);
+}
+
+static void test_length_limit(void)
+{
+    char out[64];
+    char line[41];
+
+    login_reset();
+    memset(line, 'u', 40);
+    line[40] = '\0';
+    rx(line);
+    CHECK_EQ(g_buffer_index, 31);                   /* 31 chars + '\0' in the 32 byte buffer */
+    CHECK_EQ(mock_tx_take(out, sizeof(out)), 31);
+    rx("\r");
+    CHECK_EQ(strlen(g_username_buffer), 31);
+}
+
+static void test_drop_while_ready(void)
+{
+    char out[64];
+
+    login_reset();
+    rx("a\r");
+    rx("bc");                                       /* Main loop has not taken the line yet */
+    CHECK_EQ(g_shell_stats.dropped, 2);
+    CHECK_EQ(g_buffer_index, 0);
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "a\r\n");
+}
+
+static void test_shell_line(void)
+{
+    char out[64];
+
+    login_reset();
+    g_current_state = STATE_LOGGED_IN;
+    rx("adc 3x\x08\r");
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "adc 3x\b \b\r\n");
+    CHECK_STR(g_line, "adc 3");
+    CHECK_EQ(g_input_ready, 1);
+
+    mock_adc_set(3, 777);
+    shell_exec(g_line);
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "777\r\n");
+
+    shell_exec(strcpy(g_line, "adc 9"));
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "adc: channel 0 ~ 7\r\n");
+
+    shell_exec(strcpy(g_line, "nope"));
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "nope: unknown command (help)\r\n");
+    CHECK_EQ(g_shell_stats.unknown, 1);
+}
+
+static void test_shell_commands(void)
+{
+    char out[MOCK_QUEUE];
+
+    login_reset();
+    mock_adc_set(8, 352);                           /* 352 * 1.08 - 273 = 107C */
+    shell_exec(strcpy(g_line, "temp"));
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "107 C\r\n");
+
+    mock_twi_device(0x38);
+    mock_twi_device(0x68);
+    shell_exec(strcpy(g_line, "i2c scan"));
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "0x38\r\n0x68\r\n2 device(s)\r\n");
+    CHECK_EQ(g_mock.twi_stops, 0x78 - 0x08);
+
+    shell_exec(strcpy(g_line, "logout"));
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "Username: ");
+    CHECK_EQ(g_current_state, STATE_WAIT_USERNAME);
+}
+
+static void bench(void)
+{
+    char out[MOCK_QUEUE];
+
+    login_reset();
+    g_current_state = STATE_LOGGED_IN;
+    BENCH("USART_RX_vect (8 chars + Enter)", 1000000,
+        rx("adc 3 4 5\r"); g_input_ready = 0; mock_tx_take(out, sizeof(out)));
+    BENCH("shell_exec (unknown command)", 1000000,
+        shell_exec(strcpy(g_line, "nope a b")); mock_tx_take(out, sizeof(out)));
+    BENCH("shell_exec (adc 3)", 1000000,
+        shell_exec(strcpy(g_line, "adc 3")); mock_tx_take(out, sizeof(out)));
+}
+
+int main(int argc, char **argv)
+{
+    if (test_bench_mode(argc, argv))
+    {
+        puts("login (module02/ex04)");
+        mock_reset();
+        bench();
+        return 0;
+    }
+
+    TEST(test_username);
+    TEST(test_password_masked);
+    TEST(test_length_limit);
+    TEST(test_drop_while_ready);
+    TEST(test_shell_line);
+    TEST(test_shell_commands);
+    return test_report("login");
+}
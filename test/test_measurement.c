@@ -0,0 +1,130 @@
+#define main exercise_main
+#include "../module06/ex02/src/main.c"
+#undef main
+
+#include "test.h"
+
+/*
+** module06/ex02: moving average of the last 3 AHT20 samples, AHT20 frames over the TWI mock,
+** EEPROM log of the samples
+*/
+
+static void measurement_reset(void)
+{
+    memset(g_temperature, 0, sizeof(g_temperature));
+    memset(g_humidity, 0, sizeof(g_humidity));
+    g_measurement_index = 0;
+}
+
+static void test_average(void)
+{
+    char out[64];
+    float temperature = -1;
+    float humidity = -1;
+
+    measurement_reset();
+    compute_average(&temperature, &humidity);
+    mock_tx_take(out, sizeof(out));
+    CHECK_STR(out, "No measurements available.\r\n");
+    CHECK_NEAR(temperature, -1, 0);                 /* Left as it was */
+
+    measurement_process(20, 40);
+    compute_average(&temperature, &humidity);
+    CHECK_NEAR(temperature, 20, 1e-6);
+    CHECK_NEAR(humidity, 40, 1e-6);
+
+    measurement_process(22, 50);
+    compute_average(&temperature, &humidity);
+    CHECK_NEAR(temperature, 21, 1e-6);              /* 2 samples: empty slot not counted */
+
+    measurement_process(24, 60);
+    measurement_process(30, 70);                    /* 20 / 40 is out */
+    compute_average(&temperature, &humidity);
+    CHECK_NEAR(temperature, (22 + 24 + 30) / 3.0, 1e-4);
+    CHECK_NEAR(humidity, 60, 1e-4);
+    CHECK_EQ(g_measurement_index, 3);
+}
+
+static void test_aht20(void)
+{
+    /* Status (calibrated, idle), humidity 0x80000 = 50%, temperature 0x66666 = 30C, CRC */
+    static const uint8_t frame[] = { 0x1C, 0x80, 0x00, 0x06, 0x66, 0x66, 0x00 };
+    float temperature;
+    float humidity;
+
+    mock_twi_device(0x38);
+    i2c_init();
+
+    aht20_trigger();
+    CHECK_EQ(g_mock.twi_log_len, 4);
+    CHECK_EQ(g_mock.twi_log[0], I2C_ADDRESS_AHT20);
+    CHECK_EQ(g_mock.twi_log[1], MEASUREMENT_CMD);
+    CHECK_EQ(g_mock.twi_log[2], 0x33);
+    CHECK_EQ(g_mock.twi_log[3], 0x00);
+    CHECK_EQ(g_mock.twi_stops, 1);
+
+    mock_twi_rx(frame, sizeof(frame));
+    CHECK_EQ(aht20_read(&temperature, &humidity), 0x1C);
+    CHECK_NEAR(temperature, 30, 1e-3);
+    CHECK_NEAR(humidity, 50, 1e-3);
+    CHECK_EQ(g_mock.twi_rx_head, 7);
+}
+
+/* Tenths rounded both ways, one sample logged out of LOG_EVERY, LOG_DUMP -> dump */
+static void test_log(void)
+{
+    static char out[MOCK_QUEUE];
+    const uint8_t *page = (uint8_t *)&out[7 + ELOG_PAGES * ELOG_PAGE_SIZE];
+
+    CHECK_EQ(log_tenths(21.46f), 215);
+    CHECK_EQ(log_tenths(-0.26f), -3);
+
+    uart_init(UART_UBRR(UART_BAUDRATE));
+    elog_init(2, LOG_TICK_MS);
+    g_log_skip = 0;
+    g_log_count = 0;
+    for (uint8_t i = 0; i < 2 * LOG_EVERY; i++)
+        log_sample(i * 1000UL, 21.5, 48.0);
+
+    log_command();                                  /* Nothing received */
+    mock_rx_push("x", 1);
+    log_command();                                  /* Not the dump command */
+    CHECK_EQ(mock_tx_take(out, sizeof(out)), 0);
+    mock_rx_push("D", 1);
+    log_command();
+    CHECK_EQ(mock_tx_take(out, sizeof(out)), 2 + 5 + (ELOG_PAGES + 1) * ELOG_PAGE_SIZE + 2);
+    CHECK_EQ(out[6], ELOG_PAGES + 1);               /* The open page, in RAM */
+    CHECK_EQ(page[6], LOG_EVERY - 1);               /* Base time: s */
+    CHECK_EQ(page[10] | (page[11] << 8), 215);
+    CHECK_EQ(page[12] | (page[13] << 8), 480);
+    CHECK_EQ(page[14], 0x40);                       /* Second one: period only (+10 s) */
+    CHECK_EQ(page[15], 2 * LOG_EVERY);
+    CHECK_EQ(page[16], ELOG_COMMIT);
+}
+
+static void bench(void)
+{
+    float temperature;
+    float humidity;
+
+    measurement_reset();
+    BENCH("measurement_process", 10000000, measurement_process(i_ & 63, 50));
+    BENCH("compute_average", 10000000,
+        compute_average(&temperature, &humidity); BENCH_KEEP(temperature); BENCH_KEEP(humidity));
+}
+
+int main(int argc, char **argv)
+{
+    if (test_bench_mode(argc, argv))
+    {
+        puts("measurement (module06/ex02)");
+        mock_reset();
+        bench();
+        return 0;
+    }
+
+    TEST(test_average);
+    TEST(test_aht20);
+    TEST(test_log);
+    return test_report("measurement");
+}
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+Cycle / size benchmark results against a baseline (test/sim/Makefile)
+
+    bench_compare.py [--update] [--tolerance N] build_dir baseline.tsv
+
+build_dir holds what the Makefile collected:
+    bench_<module>_<ex>.log   simavr output, lines "BENCH <name> <cycles>"
+                              (simavr may add a prefix, the line is searched)
+                              "stack" (peak, bytes) and "stack_gap" (bytes left above .bss)
+                              come at the end of every program
+    run_<module>_<ex>.log     stack_sim.c: the exercise itself run from the reset,
+                              "run_stack" / "run_stack_gap"
+    size.log                  "<module>/<ex> <avr-size line: text data bss dec hex file>"
+
+Results, tab separated, one metric per line (build_dir/bench.tsv and the baseline):
+    <target>    <metric>    <value>
+    module03/ex03   USART_RX_vect_digit   52
+    module03/ex03   flash                 2210        text + data
+    module03/ex03   ram                   160         data + bss (static RAM, no stack)
+
+Exit 1 when a metric grew by more than the tolerance (percent, default 0: any
+cycle or byte more), a benchmark did not report, or a program did not run.
+stack_gap / run_stack_gap are the other way round (less is worse), and under --margin bytes it fails
+whatever the baseline says: the stack came that close to the globals.
+New metrics are listed, never failing. --update writes the results as the new baseline.
+No baseline file: the results and the stack margin are shown, and it fails (nothing to compare)
+--toolchain: avr-gcc version, written in the baseline header; a baseline recorded
+with another version is still compared, with a note (the compiler alone moves cycles and bytes)
+"""
+
+import argparse
+import os
+import re
+import sys
+
+BENCH_LINE = re.compile(r"BENCH (\S+) (\d+)")
+
+LESS_IS_WORSE = ("stack_gap", "run_stack_gap")
+LOG_PREFIXES = ("bench_", "run_")
+
+
+def target_of(log):
+    """bench_module03_ex03.log / run_module03_ex03.log -> module03/ex03, bench_lib.log -> lib"""
+    name = os.path.basename(log).split("_", 1)[1][:-len(".log")]
+    match = re.fullmatch(r"(module\d+)_(ex\d+)", name)
+    return "/".join(match.groups()) if match else name
+
+
+def collect(build_dir):
+    results = {}
+    for entry in sorted(os.listdir(build_dir)):
+        if not (entry.startswith(LOG_PREFIXES) and entry.endswith(".log")):
+            continue
+        target = target_of(entry)
+        found = False
+        with open(os.path.join(build_dir, entry), errors="replace") as f:
+            for line in f:
+                match = BENCH_LINE.search(line)
+                if match:
+                    results[(target, match.group(1))] = int(match.group(2))
+                    found = True
+        if not found:
+            results[(target, "run_no_output" if entry.startswith("run_") else "no_output")] = -1
+    size_log = os.path.join(build_dir, "size.log")
+    if os.path.exists(size_log):
+        with open(size_log) as f:
+            for line in f:
+                fields = line.split()
+                if len(fields) < 4 or not fields[1].isdigit():
+                    continue
+                text, data, bss = (int(x) for x in fields[1:4])
+                results[(fields[0], "flash")] = text + data
+                results[(fields[0], "ram")] = data + bss
+    return results
+
+
+TOOLCHAIN_LINE = "# toolchain: "
+
+
+def load(path):
+    """(results, toolchain of the header or None)"""
+    results = {}
+    toolchain = None
+    if not os.path.exists(path):
+        return results, toolchain
+    with open(path) as f:
+        for line in f:
+            if line.startswith(TOOLCHAIN_LINE):
+                toolchain = line[len(TOOLCHAIN_LINE):].strip()
+            if line.startswith("#") or not line.strip():
+                continue
+            target, metric, value = line.split("\t")
+            results[(target, metric)] = int(value)
+    return results, toolchain
+
+
+def save(path, results, header):
+    with open(path, "w") as f:
+        f.write(header)
+        for (target, metric), value in sorted(results.items()):
+            f.write("%s\t%s\t%d\n" % (target, metric, value))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="simavr cycle / size results against a baseline")
+    parser.add_argument("build_dir")
+    parser.add_argument("baseline")
+    parser.add_argument("--update", action="store_true", help="write the results as the baseline")
+    parser.add_argument("--tolerance", type=float, default=0.0, help="allowed growth, percent")
+    parser.add_argument("--margin", type=int, default=0, help="smallest stack_gap allowed, bytes")
+    parser.add_argument("--toolchain", default="", help="compiler version of this run")
+    args = parser.parse_args()
+
+    results = collect(args.build_dir)
+    save(os.path.join(args.build_dir, "bench.tsv"), results, "")
+    if args.update:
+        broken = sorted(target for (target, metric), value in results.items() if value < 0)
+        if broken:
+            print("bench: no output from %s, baseline not written" % ", ".join(broken))
+            return 1
+        save(args.baseline, results,
+             TOOLCHAIN_LINE + (args.toolchain or "unknown") + "\n"
+             "# target\tmetric\tvalue (cycles, flash / ram bytes) - make -C test/sim baseline\n")
+        print("bench: %d metrics written to %s" % (len(results), args.baseline))
+        return 0
+
+    baseline, toolchain = load(args.baseline)
+    if toolchain and args.toolchain and toolchain != args.toolchain:
+        print("bench: baseline recorded with %s, this run %s" % (toolchain, args.toolchain))
+    failed = 0
+    print("%-16s %-32s %8s %8s %8s" % ("target", "metric", "base", "now", "delta"))
+    for key in sorted(set(results) | set(baseline)):
+        now = results.get(key)
+        base = baseline.get(key)
+        mark = ""
+        if now is None or now < 0:
+            mark = "  MISSING"
+            failed += 1
+        elif key[1] in LESS_IS_WORSE and now < args.margin:
+            mark = "  STACK (margin %d)" % args.margin
+            failed += 1
+        elif base is None:
+            mark = "  new"
+        elif key[1] in LESS_IS_WORSE:
+            if now < base * (1 - args.tolerance / 100.0):
+                mark = "  REGRESSION"
+                failed += 1
+            elif now > base:
+                mark = "  better"
+        elif now > base * (1 + args.tolerance / 100.0):
+            mark = "  REGRESSION"
+            failed += 1
+        elif now < base:
+            mark = "  better"
+        delta = "" if now is None or base is None else "%+d" % (now - base)
+        print("%-16s %-32s %8s %8s %8s%s" % (key[0], key[1],
+              "-" if base is None else base, "-" if now is None else now, delta, mark))
+    if failed:
+        print("bench: %d metric(s) worse than %s" % (failed, args.baseline))
+        return 1
+    if not os.path.exists(args.baseline):
+        print("bench: no %s, make -C test/sim baseline records one (commit it)" % args.baseline)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
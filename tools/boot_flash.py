@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+Upload through the project bootloader (bootloader/, needs pyserial)
+
+    boot_flash.py [--baud B] [--no-reset] [--wait S] [--full] port image
+
+image: build/main.bin (make hex) or an Intel hex file, loaded at address 0
+    make flash BOOT=1       from an exercise directory (this tool, BOOT_BAUD)
+
+Steps:
+    reset       DTR pulse (the USB adapter resets the board, external reset: the boot waits
+                500ms for a host), skipped with --no-reset (reset button, SW1 held, simulator)
+    sync        'S' every 10ms until 'B' version page_size app_pages
+    query       'Q' ~'Q' 0 count: CRC of every page of the image in one reply
+    write       'W' ~'W' page data CRC for the pages whose CRC differs (all with --full),
+                two frames in flight: the next one is received while a page is written,
+                the reply has the page number (a frame lost whole gets no reply)
+    go          'G' ~'G': the application starts
+
+A page CRC is CRC-16 CCITT (0xFFFF) of the page number then its bytes (bootloader/src/boot.h)
+A frame answered 'C' (bad CRC, the boot then drops what follows until 1ms of silence) or left
+without answer is sent again after a new sync, with the frames sent behind it;
+a query or a go left without answer is sent again after a new sync too
+"""
+
+import argparse
+import collections
+import struct
+import sys
+import time
+
+import serial
+
+VERSION = 1
+ROUNDS = 3
+
+
+def crc_ccitt(data, crc=0xFFFF):
+    """_crc_ccitt_update() of avr-libc, byte after byte"""
+    for byte in data:
+        byte ^= crc & 0xFF
+        byte = (byte ^ (byte << 4)) & 0xFF
+        crc = ((byte << 8) | (crc >> 8)) ^ (byte >> 4) ^ (byte << 3)
+        crc &= 0xFFFF
+    return crc
+
+
+def load_image(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if not path.endswith(".hex"):
+        return data
+    image = bytearray()
+    base = 0
+    for line in data.decode().split():
+        record = bytes.fromhex(line.lstrip(":"))
+        count, address, kind = record[0], struct.unpack(">H", record[1:3])[0], record[3]
+        if kind == 0:
+            address += base
+            image.extend(b"\xFF" * max(0, address + count - len(image)))
+            image[address:address + count] = record[4:4 + count]
+        elif kind == 2:
+            base = struct.unpack(">H", record[4:6])[0] << 4
+        elif kind == 4:
+            base = struct.unpack(">H", record[4:6])[0] << 16
+    return bytes(image)
+
+
+def command(letter):
+    """Command byte and its complement"""
+    return bytes((ord(letter), ~ord(letter) & 0xFF))
+
+
+def page_crc(page, data):
+    return crc_ccitt(bytes((page,)) + data)
+
+
+class Boot:
+    def __init__(self, link):
+        self.link = link
+        self.page_size = 0
+        self.app_pages = 0
+
+    def read(self, size, what):
+        data = self.link.read(size)
+        if len(data) != size:
+            raise TimeoutError("no %s from the bootloader" % what)
+        return data
+
+    def sync(self, wait):
+        """'S' until the hello, what was coming before and after it is dropped"""
+        deadline = time.monotonic() + wait
+        self.link.timeout = 0.05
+        while self.link.read(256):
+            pass
+        while True:
+            if time.monotonic() > deadline:
+                sys.exit("boot_flash: no bootloader version %d (reset it, or hold SW1 while it starts)"
+                         % VERSION)
+            self.link.timeout = 0.01
+            self.link.write(b"S")
+            reply = self.link.read(1)
+            self.link.timeout = 0.05
+            if reply == b"B":
+                hello = self.link.read(3)
+                if len(hello) == 3 and hello[0] == VERSION:
+                    break
+            # Something else still coming (a command whose bytes were lost read the 'S')
+            while reply and self.link.read(256):
+                pass
+        version, self.page_size, self.app_pages = hello
+        while self.link.read(64):
+            pass
+        self.link.timeout = 0.5
+
+    def query(self, count):
+        self.link.write(command("Q") + bytes((0, count)))
+        if self.read(1, "query reply") != b"K":
+            sys.exit("boot_flash: query out of range (%d pages)" % count)
+        raw = self.read(2 * count, "page CRCs")
+        return list(struct.unpack("<%dH" % count, raw))
+
+    def write(self, pages, image):
+        """Pages answered 'K', the others come back for a new round"""
+        again = []
+        in_flight = collections.deque()
+
+        def reply():
+            """False: the frames in flight are out of step (dropped by the boot, or no reply)"""
+            answer = self.link.read(2)
+            if len(answer) != 2 or answer[:1] == b"C":
+                again.extend(in_flight)
+                in_flight.clear()
+                return False
+            status, page = answer[:1], answer[1]
+            while in_flight and in_flight[0] != page:
+                again.append(in_flight.popleft())   # Lost whole, never answered
+            if not in_flight:
+                return False
+            in_flight.popleft()
+            if status == b"E":
+                sys.exit("boot_flash: page %d is in the boot section" % page)
+            if status != b"K":
+                print("boot_flash: page %d read back wrong" % page, file=sys.stderr)
+                again.append(page)
+            return True
+
+        for page in pages:
+            if len(in_flight) == 2 and not reply():
+                return again + pages[pages.index(page):]
+            data = image[page * self.page_size:(page + 1) * self.page_size]
+            self.link.write(command("W") + bytes((page,)) + data + struct.pack("<H", page_crc(page, data)))
+            in_flight.append(page)
+        while in_flight:
+            if not reply():
+                break
+        return again
+
+    def go(self):
+        self.link.write(command("G"))
+        if self.read(1, "go reply") != b"K":
+            sys.exit("boot_flash: the application did not start")
+
+    def retry(self, wait, action, *args):
+        """action(*args) again after a new sync when a reply does not come"""
+        for _ in range(ROUNDS):
+            try:
+                return action(*args)
+            except TimeoutError as error:
+                print("boot_flash: %s, sync again" % error, file=sys.stderr)
+                self.sync(wait)
+        sys.exit("boot_flash: the bootloader does not answer")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="upload through bootloader/ (page CRC, 1Mbaud)")
+    parser.add_argument("port", help="serial port (/dev/ttyUSB0)")
+    parser.add_argument("image", help="raw binary (build/main.bin) or Intel hex")
+    parser.add_argument("--baud", type=int, default=1000000)
+    parser.add_argument("--no-reset", action="store_true", help="no DTR pulse, the boot waits already")
+    parser.add_argument("--wait", type=float, default=2.0, help="time to find the bootloader, seconds")
+    parser.add_argument("--full", action="store_true", help="write every page, even the same ones")
+    args = parser.parse_args()
+
+    image = load_image(args.image)
+    start = time.monotonic()
+    with serial.Serial(args.port, args.baud, timeout=0.5) as link:
+        try:
+            link.set_low_latency_mode(True)     # FTDI: no 16ms latency timer
+        except (AttributeError, OSError, ValueError):
+            pass
+        if not args.no_reset:
+            link.dtr = False
+            time.sleep(0.01)
+            link.dtr = True
+        link.reset_input_buffer()
+
+        boot = Boot(link)
+        boot.sync(args.wait)
+        size = boot.page_size
+        count = (len(image) + size - 1) // size
+        if count > boot.app_pages:
+            sys.exit("boot_flash: %d bytes, the application space is %d" % (len(image), boot.app_pages * size))
+        image += b"\xFF" * (count * size - len(image))
+
+        pages = list(range(count))
+        if not args.full:
+            flash = boot.retry(args.wait, boot.query, count)
+            pages = [p for p in pages if flash[p] != page_crc(p, image[p * size:(p + 1) * size])]
+        written = len(pages)
+        for _ in range(ROUNDS):
+            if not pages:
+                break
+            pages = boot.write(pages, image)
+            if pages:
+                boot.sync(args.wait)
+        if pages:
+            sys.exit("boot_flash: pages %s not written" % pages)
+        boot.retry(args.wait, boot.go)
+
+    print("boot_flash: %d bytes, %d pages, %d written, %.2f s" % (
+        len(image), count, written, time.monotonic() - start))
+
+
+if __name__ == "__main__":
+    main()
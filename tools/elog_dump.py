@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+EEPROM sample log (lib/elog.h) -> CSV
+
+    elog_dump.py [--command D] [--baud B] [--names a,b] [--scale S] [--raw FILE] source
+
+source: serial port (needs pyserial) or a file holding a raw dump (cat /dev/ttyUSB0 > file)
+    module06/ex02   elog_dump.py --names temperature,humidity --scale 0.1 /dev/ttyUSB0
+    module05/ex01   elog_dump.py --names rv1,ldr,ntc /dev/ttyUSB0
+The port is opened without a DTR pulse (no reset: the samples in RAM would go), --command is
+sent every 10ms until the dump starts (a sleeping board only reads it while it is awake)
+
+Dump (elog_dump(), little endian):
+    'E' 'L' | version 1 | page size | lost (16 bit) | page count | {page} |
+    CRC-16 CCITT (0xFFFF) of everything after 'E' 'L'
+Page: version, sequence, channels, tick ms, base time (ticks), base values (int16), then
+    records: flags (bit 6 period changed, bits 0 ~ 3 channel changed), a zig-zag varint per
+    set bit, the period one first; commit: 0x80, CRC of the page up to the marker
+    the records after the last good commit are dropped (not flushed, or torn by a reset)
+A page sent twice (EEPROM, then RAM) is taken the second time
+
+Output: time_s then one column per channel (value * scale), oldest first, and a summary on
+stderr: pages, samples, bytes per sample against the 4 + 2 x channels of raw samples
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+VERSION = 1
+COMMIT = 0x80
+TIME_BIT = 0x40
+CHANNELS = 4
+
+
+def crc_ccitt(data, crc=0xFFFF):
+    """_crc_ccitt_update() of avr-libc, byte after byte"""
+    for byte in data:
+        byte ^= crc & 0xFF
+        byte = (byte ^ (byte << 4)) & 0xFF
+        crc = ((byte << 8) | (crc >> 8)) ^ (byte >> 4) ^ (byte << 3)
+        crc &= 0xFFFF
+    return crc
+
+
+def varint(page, offset):
+    """Zig-zag varint at offset: (value, next offset)"""
+    value = shift = 0
+    while True:
+        if offset >= len(page):
+            raise IndexError
+        byte = page[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return (value >> 1) ^ -(value & 1), offset
+
+
+def decode(page):
+    """(sequence, tick ms, channels, [(ticks, values)], bytes) up to the last good commit, or None"""
+    version, seq, channels, tick, base = struct.unpack_from("<BHBHI", page)
+    if version != VERSION or not 1 <= channels <= CHANNELS:
+        return None
+    values = list(struct.unpack_from("<%dh" % channels, page, 10))
+    samples = [(base, tuple(values))]
+    ticks, period = base, 0
+    offset = 10 + 2 * channels
+    good = None
+    try:
+        while offset + 3 <= len(page):
+            flags = page[offset]
+            offset += 1
+            if flags == COMMIT:
+                if struct.unpack_from("<H", page, offset)[0] != crc_ccitt(page[:offset]):
+                    break
+                offset += 2
+                good = (list(samples), offset)
+                continue
+            if flags & ~(TIME_BIT | ((1 << channels) - 1)):
+                break
+            if flags & TIME_BIT:
+                change, offset = varint(page, offset)
+                period += change
+            for channel in range(channels):
+                if flags & (1 << channel):
+                    change, offset = varint(page, offset)
+                    values[channel] += change
+            ticks += period
+            samples.append((ticks, tuple(values)))
+    except IndexError:
+        pass
+    if good is None:
+        return None
+    return seq, tick, channels, good[0], good[1]
+
+
+class Reader:
+    def __init__(self, source, baud, command):
+        self.command = command.encode()
+        if source.startswith("/dev/"):
+            import serial
+            self.link = serial.Serial()
+            self.link.port = source
+            self.link.baudrate = baud
+            self.link.timeout = 0.01
+            self.link.dtr = False           # Kept low when the port opens: no reset
+            self.link.rts = False
+            self.link.open()
+            self.link.reset_input_buffer()
+        else:
+            self.link = open(source, "rb")
+
+    def read(self, size):
+        data = self.link.read(size)
+        if len(data) != size:
+            raise EOFError
+        return data
+
+    def start(self, wait):
+        """Command until 'E' 'L' comes back"""
+        if not self.command or not hasattr(self.link, "write"):
+            return self.read(1) == b"E" and self.read(1) == b"L"
+        deadline = time.monotonic() + wait
+        while time.monotonic() < deadline:
+            self.link.write(self.command)
+            if self.link.read(1) == b"E" and self.link.read(1) == b"L":
+                self.link.timeout = 1
+                return True
+        raise EOFError
+
+    def dump(self, wait):
+        """Next dump with a good CRC: (lost, [page])"""
+        while True:
+            if not self.start(wait):
+                continue
+            head = self.read(5)
+            version, size, lost, count = struct.unpack("<BBHB", head)
+            if version != VERSION:
+                continue
+            raw = self.read(size * count)
+            if struct.unpack("<H", self.read(2))[0] != crc_ccitt(head + raw):
+                print("elog: bad CRC, dump skipped", file=sys.stderr)
+                continue
+            return lost, [raw[i * size:(i + 1) * size] for i in range(count)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="samples of lib/elog.c from a dump, as CSV")
+    parser.add_argument("source", help="serial port or file of a raw dump")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--command", default="D", help="byte(s) asking for the dump ('' for none)")
+    parser.add_argument("--wait", type=float, default=20.0, help="time for the dump to start, seconds")
+    parser.add_argument("--names", default="", help="column names, comma separated")
+    parser.add_argument("--scale", type=float, default=1.0, help="value unit (0.1: tenths)")
+    parser.add_argument("--raw", help="also save the raw pages to this file")
+    args = parser.parse_args()
+
+    try:
+        lost, pages = Reader(args.source, args.baud, args.command).dump(args.wait)
+    except EOFError:
+        sys.exit("elog: no dump read")
+    if args.raw:
+        with open(args.raw, "wb") as f:
+            f.write(b"".join(pages))
+
+    by_seq = {}
+    for page in pages:
+        decoded = decode(page)
+        if decoded:
+            by_seq[decoded[0]] = decoded
+    if not by_seq:
+        sys.exit("elog: no sample in the log")
+    first = next(iter(by_seq))                  # Sequences wrap: ordered around any of them
+    ordered = sorted(by_seq.values(), key=lambda page: (page[0] - first + 0x8000) & 0xFFFF)
+
+    channels = ordered[-1][2]
+    names = args.names.split(",") if args.names else ["ch%d" % i for i in range(channels)]
+    print(",".join(["time_s"] + names[:channels]))
+    samples = used = 0
+    for _, tick, count, page_samples, size in ordered:
+        for ticks, values in page_samples:
+            print(",".join(["%.3f" % (ticks * tick / 1000.0)] +
+                           ["%g" % round(value * args.scale, 6) for value in values[:count]]))
+        samples += len(page_samples)
+        used += size
+
+    print("elog: %d page(s), %d samples, %d lost, %.2f bytes per sample (raw: %d)" % (
+        len(ordered), samples, lost, used / samples, 4 + 2 * channels), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
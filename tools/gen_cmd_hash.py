@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""
+Perfect hash generator for the UART shell command table
+
+    gen_cmd_hash.py commands.txt shell_cmds.h
+
+commands.txt, one command per line (# -> comment):
+    name    handler     help text
+
+The hash is the one of shell.c (8 bit, no division):
+    h = SEED
+    for c in name: h = (h * MUL + c) & 0xFF
+    index = h & (SIZE - 1)
+
+SIZE is the smallest power of 2 >= number of commands for which a (SEED, MUL)
+without collision exists, so dispatch is: hash the word, one strcmp_P()
+"""
+
+import sys
+
+
+def shell_hash(name, seed, mul):
+    h = seed
+    for c in name.encode():
+        h = (h * mul + c) & 0xFF
+    return h
+
+
+def find(names):
+    size = 1
+    while size < len(names):
+        size <<= 1
+    while size <= 256:
+        for mul in range(3, 256, 2):            # odd multipliers only
+            for seed in range(256):
+                slots = {shell_hash(n, seed, mul) & (size - 1) for n in names}
+                if len(slots) == len(names):
+                    return size, seed, mul
+        size <<= 1
+    sys.exit("gen_cmd_hash: no perfect hash found")
+
+
+def parse(path):
+    commands = []
+    with open(path) as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            name, handler, text = (line.split(None, 2) + [""])[:3]
+            commands.append((name, handler, text))
+    names = [c[0] for c in commands]
+    if len(set(names)) != len(names):
+        sys.exit("gen_cmd_hash: duplicate command")
+    return commands
+
+
+def c_string(text):
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: gen_cmd_hash.py commands.txt shell_cmds.h")
+    commands = parse(sys.argv[1])
+    size, seed, mul = find([c[0] for c in commands])
+
+    out = []
+    out.append("/* Generated by tools/gen_cmd_hash.py from %s, do not edit */" % sys.argv[1].split("/")[-1])
+    out.append("#ifndef SHELL_CMDS_H")
+    out.append("# define SHELL_CMDS_H")
+    out.append("")
+    out.append('#include "shell.h"')
+    out.append("")
+    out.append("#define SHELL_HASH_SIZE     %d" % size)
+    out.append("#define SHELL_HASH_SEED     0x%02X" % seed)
+    out.append("#define SHELL_HASH_MUL      %d" % mul)
+    out.append("#define SHELL_CMD_COUNT     %d" % len(commands))
+    out.append("")
+    for name, handler, _ in commands:
+        out.append("void %s(t_shell_args *args);" % handler)
+    out.append("")
+    for name, _, text in commands:
+        out.append("static const char g_cmd_name_%s[] PROGMEM = %s;" % (name, c_string(name)))
+        out.append("static const char g_cmd_help_%s[] PROGMEM = %s;" % (name, c_string(text)))
+    out.append("")
+    out.append("/* Index = hash of the name, empty slots are { 0 } */")
+    out.append("static const t_shell_cmd g_shell_cmds[SHELL_HASH_SIZE] PROGMEM =")
+    out.append("{")
+    for index, (name, handler, _) in sorted((shell_hash(c[0], seed, mul) & (size - 1), c) for c in commands):
+        out.append("    [%d] = { g_cmd_name_%s, g_cmd_help_%s, %s }," % (index, name, name, handler))
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+    with open(sys.argv[2], "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""
+Binary RGB stream player for module03/ex03 (needs pyserial)
+
+    rgb_stream.py /dev/ttyUSB0 [fps] [seconds]
+
+Plays a hue wheel: STX, then R G B ticks frames (ticks of 1ms), sent only
+while credits are left, then the end frame (ticks 0) and the END report.
+"""
+
+import colorsys
+import sys
+
+import serial
+
+STX = 0x02
+
+
+def frames(fps, seconds):
+    ticks = max(1, min(255, round(1000 / fps)))
+    count = int(fps * seconds)
+    for i in range(count):
+        r, g, b = colorsys.hsv_to_rgb((i / fps / 4) % 1.0, 1.0, 1.0)
+        yield bytes((int(r * 255), int(g * 255), int(b * 255), ticks))
+
+
+def main():
+    port = sys.argv[1] if len(sys.argv) > 1 else "/dev/ttyUSB0"
+    fps = float(sys.argv[2]) if len(sys.argv) > 2 else 100.0
+    seconds = float(sys.argv[3]) if len(sys.argv) > 3 else 10.0
+
+    with serial.Serial(port, 1000000, timeout=2) as link:
+        link.reset_input_buffer()
+        link.write(bytes((STX,)))
+        credits = 0
+        for frame in frames(fps, seconds):
+            while credits == 0:
+                grant = link.read(1)
+                if not grant:
+                    sys.exit("rgb_stream: no credit from the device")
+                credits += grant[0]
+            link.write(frame)
+            credits -= 1
+        link.write(bytes(4))                    # end of the stream
+        # Credits still coming are single bytes < 0x20, the report is text
+        report = b""
+        while not report.endswith(b"\r\n"):
+            byte = link.read(1)
+            if not byte:
+                sys.exit("rgb_stream: no END report")
+            if byte[0] >= 0x20 or byte in b"\r\n":
+                report += byte
+        print(report.decode().strip())
+
+
+if __name__ == "__main__":
+    main()
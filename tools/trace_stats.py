@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+ISR trace statistics (lib/trace.h, make TRACE=1)
+
+    trace_stats.py [--command trace] [--dumps N] [--baud B] [--chain C] [--bucket US] source
+
+source: serial port (needs pyserial) or a file holding raw dumps (cat /dev/ttyUSB0 > file)
+    module02/ex04   trace_stats.py --command trace /dev/ttyUSB0   (logged in: "trace" sends it)
+    module04/ex02   trace_stats.py --dumps 4 /dev/ttyUSB0          (sent when the ring is full)
+
+Dump (trace_dump(), little endian):
+    'T' 'R' | version 1 | F_CPU MHz | name count | {id, length, name} | lost | count |
+    {tag, time} | CRC-16 CCITT (0xFFFF) of everything after 'T' 'R'
+    tag: id (bits 0 ~ 2), 0x40 interrupts were off, 0x80 exit; time: TCNT1 at clk/1
+
+Per id: count, min / avg / max duration (exit - entry, nested ISRs included)
+A span with interrupts off (an ISR) holds every other interrupt back for its whole duration:
+its max is the worst delay it adds to the others
+Wait histogram: an ISR entered at most --chain cycles after the exit of another one (default
+100: exit record -> reti -> vector -> prologue -> entry record) was pending during it;
+its wait is counted from the entry of that one (upper bound), otherwise 0
+Time is 16 bit (4.096ms at 16MHz): longer spans are seen modulo the wrap
+"""
+
+import argparse
+import struct
+import sys
+
+EXIT = 0x80
+MASKED = 0x40
+ID_MASK = 0x07
+
+
+def crc_ccitt(data, crc=0xFFFF):
+    """_crc_ccitt_update() of avr-libc, byte after byte"""
+    for byte in data:
+        byte ^= crc & 0xFF
+        byte = (byte ^ (byte << 4)) & 0xFF
+        crc = ((byte << 8) | (crc >> 8)) ^ (byte >> 4) ^ (byte << 3)
+        crc &= 0xFFFF
+    return crc
+
+
+class Reader:
+    def __init__(self, source, baud, command):
+        self.command = command
+        if source.startswith("/dev/"):
+            import serial
+            self.link = serial.Serial(source, baud, timeout=3)
+            self.link.reset_input_buffer()
+        else:
+            self.link = open(source, "rb")
+
+    def read(self, size):
+        data = self.link.read(size)
+        if len(data) != size:
+            raise EOFError
+        return data
+
+    def dump(self):
+        """Next dump with a good CRC: (mhz, names, lost, events)"""
+        if self.command and hasattr(self.link, "write"):
+            self.link.write(self.command.encode() + b"\r")
+        while True:
+            if self.read(1) != b"T" or self.read(1) != b"R":
+                continue
+            body = self.read(3)
+            version, mhz, count = body
+            if version != 1:
+                continue
+            names = {}
+            for _ in range(count):
+                head = self.read(2)
+                name = self.read(head[1])
+                body += head + name
+                names[head[0]] = name.decode(errors="replace")
+            head = self.read(2)
+            lost, count = head
+            raw = self.read(3 * count)
+            body += head + raw
+            if struct.unpack("<H", self.read(2))[0] != crc_ccitt(body):
+                print("trace: bad CRC, dump skipped", file=sys.stderr)
+                continue
+            events = [struct.unpack_from("<BH", raw, 3 * i) for i in range(count)]
+            return mhz, names, lost, events
+
+
+class Stats:
+    def __init__(self, chain):
+        self.chain = chain
+        self.spans = {}         # id -> [durations]
+        self.masked = set()     # ids seen with interrupts off
+        self.waits = {}         # id -> [wait]
+        self.blockers = {}      # (id, blocker) -> [wait]
+        self.events = 0
+        self.lost = 0
+
+    def add(self, events, lost):
+        self.events += len(events)
+        self.lost += lost
+        entered = {}
+        last = None             # (tag, time, entry time of the closed span)
+        for tag, time in events:
+            ident = tag & ID_MASK
+            if tag & MASKED:
+                self.masked.add(ident)
+            if tag & EXIT:
+                start = entered.pop(ident, None)
+                if start is not None:
+                    self.spans.setdefault(ident, []).append((time - start) & 0xFFFF)
+                last = (tag, time, start)
+                continue
+            entered[ident] = time
+            if tag & MASKED:
+                wait = 0
+                if (last and last[0] & MASKED and last[2] is not None
+                        and (time - last[1]) & 0xFFFF <= self.chain):
+                    wait = (time - last[2]) & 0xFFFF
+                    self.blockers.setdefault((ident, last[0] & ID_MASK), []).append(wait)
+                self.waits.setdefault(ident, []).append(wait)
+            last = (tag, time, None)
+
+
+def histogram(values, width):
+    buckets = {}
+    for value in values:
+        buckets[value // width] = buckets.get(value // width, 0) + 1
+    most = max(buckets.values())
+    for bucket, count in sorted(buckets.items()):
+        print("    %5d ~ %5d us  %-40s %d" % (bucket * width, (bucket + 1) * width - 1,
+                                             "#" * ((count * 40 + most - 1) // most), count))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="per ISR duration and wait from lib/trace.c dumps")
+    parser.add_argument("source", help="serial port or file of raw dumps")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--command", default="", help="shell command sent before each dump (trace)")
+    parser.add_argument("--dumps", type=int, default=1, help="dumps to read (0: until the end of a file)")
+    parser.add_argument("--chain", type=int, default=100, help="exit -> entry gap of a held back ISR, cycles")
+    parser.add_argument("--bucket", type=int, default=2, help="histogram bucket, us")
+    args = parser.parse_args()
+
+    reader = Reader(args.source, args.baud, args.command)
+    stats = Stats(args.chain)
+    names = {}
+    mhz = 16
+    dumps = 0
+    while args.dumps == 0 or dumps < args.dumps:
+        try:
+            mhz, dump_names, lost, events = reader.dump()
+        except EOFError:
+            if dumps == 0:
+                sys.exit("trace: no dump read")
+            break
+        names.update(dump_names)
+        stats.add(events, lost)
+        dumps += 1
+
+    print("trace: %d dump(s), %d events, %d lost, %d MHz" % (dumps, stats.events, stats.lost, mhz))
+    print("%-3s %-20s %6s %9s %9s %9s  cycles (us)" % ("id", "name", "count", "min", "avg", "max"))
+    for ident, spans in sorted(stats.spans.items()):
+        low, avg, high = min(spans), sum(spans) / len(spans), max(spans)
+        print("%-3d %-20s %6d %9d %9.0f %9d  %.2f / %.2f / %.2f%s" % (
+            ident, names.get(ident, "?"), len(spans), low, avg, high,
+            low / mhz, avg / mhz, high / mhz,
+            "  (interrupts off: holds the others back)" if ident in stats.masked else ""))
+
+    for ident, waits in sorted(stats.waits.items()):
+        print("\nwait of %s before its entry (%d entries)" % (names.get(ident, "?"), len(waits)))
+        histogram([wait // mhz for wait in waits], args.bucket)
+        for (waiter, blocker), held in sorted(stats.blockers.items()):
+            if waiter == ident:
+                print("    behind %s: %d time(s), max %.2f us" % (
+                    names.get(blocker, "?"), len(held), max(held) / mhz))
+
+
+if __name__ == "__main__":
+    main()